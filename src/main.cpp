@@ -10,12 +10,16 @@
 #include "src/declarative/pathviewrangehandler.h"
 #include "src/globalcontrol.h"
 #include "src/globalstatus.h"
+#include "src/standbycontroller.h"
 #include "src/types.h"
 #include "src/imagedata/imageinfo.h"
 #include "src/imagedata/imagesourcemodel.h"
 #include "src/imagedata/imageprovider.h"
 #include "src/utils/filetrashhelper.h"
+#include "src/utils/startuptrace.h"
+#include "src/utils/tracerecorder.h"
 #include "src/commandparser.h"
+#include "src/unionimage/decoderpool.h"
 #include "config.h"
 
 #include <DApplication>
@@ -24,7 +28,9 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QScopedPointer>
+#include <QFileInfo>
 #include <QQmlContext>
+#include <QQuickWindow>
 #include <QIcon>
 
 Q_LOGGING_CATEGORY(logImageViewer, "org.deepin.dde.imageviewer")
@@ -33,6 +39,12 @@ DCORE_USE_NAMESPACE
 
 int main(int argc, char *argv[])
 {
+    // 进程外解码辅助进程，不创建界面
+    if (DecoderPool::isHelperCommand(argc, argv)) {
+        return DecoderPool::execHelper(argc, argv);
+    }
+    StartupTrace::start();
+
     qCDebug(logImageViewer) << "Application starting...";
     qputenv("D_POPUP_MODE", "embed");
     if (qEnvironmentVariableIsEmpty("XDG_CURRENT_DESKTOP")) {
@@ -40,6 +52,7 @@ int main(int argc, char *argv[])
         qputenv("XDG_CURRENT_DESKTOP", "Deepin");
     }
 
+    TraceSpan appSpan("startup", "DApplication");
     DApplication app(argc, argv);
     app.loadTranslator();
     qCDebug(logImageViewer) << "Translator loaded.";
@@ -53,6 +66,13 @@ int main(int argc, char *argv[])
     app.setApplicationDescription(
             QObject::tr("Image Viewer is an image viewing tool with fashion interface and smooth performance."));
     app.setWindowIcon(QIcon::fromTheme("deepin-image-viewer"));
+    appSpan.finish();
+    StartupTrace::mark("application created");
+
+    // 启用跟踪时，退出前写入跟踪文件
+    if (TraceRecorder::isEnabled()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, []() { TraceRecorder::instance()->save(); });
+    }
 
     // LOG
     DLogManager::registerConsoleAppender();
@@ -66,7 +86,11 @@ int main(int argc, char *argv[])
 
     // command
     qCDebug(logImageViewer) << "CommandParser processing...";
-    CommandParser::instance()->process();
+    {
+        TraceSpan span("startup", "CommandParser::process");
+        CommandParser::instance()->process();
+    }
+    StartupTrace::mark("command line processed");
     if (CommandParser::instance()->isSet("h")) {
         qCDebug(logImageViewer) << "Help option detected, exiting application.";
         return app.exec();
@@ -116,8 +140,34 @@ int main(int argc, char *argv[])
     qCDebug(logImageViewer) << "CursorTool singleton registered.";
 
     // 解析命令行参数
-    QString cliParam = fileControl.parseCommandlineGetPath();
+    // 传入多张图片时仅浏览指定的图片，展示首张图片
+    TraceSpan parseSpan("startup", "parseCommandlineGetPath");
+    const QStringList cliFiles = fileControl.parseCommandlineGetPaths();
+    QString cliParam = cliFiles.value(0);
+    // 递归浏览传入的文件夹，未传入文件夹时浏览图片所在的文件夹
+    const bool cliRecursive = CommandParser::instance()->isSet("recursive");
+    QString cliTreeRoot;
+    if (cliRecursive) {
+        cliTreeRoot = fileControl.parseCommandlineGetDirectory();
+        if (cliTreeRoot.isEmpty() && !cliParam.isEmpty()) {
+            cliTreeRoot = QFileInfo(QUrl(cliParam).toLocalFile()).absolutePath();
+        }
+    }
+    parseSpan.finish();
     qCDebug(logImageViewer) << "Commandline parameter parsed: " << cliParam;
+    StartupTrace::mark("command line path parsed");
+
+    // 存在待机实例时转发图片，无需继续启动，递归浏览需在当前进程扫描
+    if (!StandbyController::isRequested() && !cliRecursive && !cliParam.isEmpty()) {
+        QStringList localFiles;
+        for (const QString &cliFile : cliFiles) {
+            localFiles.append(QUrl(cliFile).toLocalFile());
+        }
+        if (StandbyController::forwardToStandby(localFiles, localFiles.first())) {
+            qCInfo(logImageViewer) << "Image opened by standby instance, exiting.";
+            return 0;
+        }
+    }
 
     // 后端缩略图加载，由 QMLEngine 管理生命周期
     // 部分平台支持线程数较低时，使用同步加载
@@ -137,6 +187,7 @@ int main(int argc, char *argv[])
 
         if (!cliParam.isEmpty()) {
             qCDebug(logImageViewer) << "Preloading image from commandline parameter.";
+            TraceSpan span("startup", "preloadImage", cliParam);
             asyncImageProvider->preloadImage(cliParam);
         }
     }
@@ -145,6 +196,11 @@ int main(int argc, char *argv[])
     engine.addImageProvider(QLatin1String("ThumbnailLoad"), multiImageLoad);
     qCDebug(logImageViewer) << "ThumbnailProvider registered.";
 
+    // 待机模式，关闭窗口时隐藏常驻
+    StandbyController standby(&control, &fileControl, providerCache);
+    qmlRegisterSingletonInstance<StandbyController>(uri.toUtf8().data(), 1, 0, "Standby", &standby);
+    qCDebug(logImageViewer) << "StandbyController singleton registered.";
+
     // 关联各组件
     // 图片旋转时更新图像缓存
     QObject::connect(&control, &GlobalControl::requestRotateCacheImage, [&]() {
@@ -161,6 +217,19 @@ int main(int argc, char *argv[])
         fileControl.setEnableNavigation(status.enableNavigation());
     });
     qCDebug(logImageViewer) << "Connect signal enableNavigationChanged.";
+    // 视图或缩略图栏快速滑动时，暂缓启动非紧急的图片信息加载任务
+    auto updateLoadDeferred = [&]() { ImageInfo::setLoadDeferred(status.viewFlicking() || status.thumbnailFlicking()); };
+    QObject::connect(&status, &GlobalStatus::viewFlickingChanged, updateLoadDeferred);
+    QObject::connect(&status, &GlobalStatus::thumbnailFlickingChanged, updateLoadDeferred);
+    qCDebug(logImageViewer) << "Connect signal viewFlickingChanged and thumbnailFlickingChanged.";
+    // 滑动、全屏动画期间暂停后台预加载
+    auto updatePrewarmPaused = [&]() {
+        control.setPrewarmPaused(status.viewFlicking() || status.thumbnailFlicking() || status.fullScreenAnimating());
+    };
+    QObject::connect(&status, &GlobalStatus::viewFlickingChanged, updatePrewarmPaused);
+    QObject::connect(&status, &GlobalStatus::thumbnailFlickingChanged, updatePrewarmPaused);
+    QObject::connect(&status, &GlobalStatus::fullScreenAnimatingChanged, updatePrewarmPaused);
+    qCDebug(logImageViewer) << "Connect signal fullScreenAnimatingChanged.";
     QObject::connect(&fileControl, &FileControl::imageRenamed, &control, [&](const QUrl &oldName, const QUrl &newName) {
         qCDebug(logImageViewer) << "Image renamed from " << oldName.toLocalFile() << " to " << newName.toLocalFile();
         providerCache->renameImageCache(oldName.toLocalFile(), newName.toLocalFile());
@@ -171,43 +240,72 @@ int main(int argc, char *argv[])
     QObject::connect(&fileControl, &FileControl::imageFileChanged, [&](const QString &fileName) {
         qCDebug(logImageViewer) << "Image file changed: " << fileName << ", removing from cache.";
         providerCache->removeImageCache(fileName);
+        // 修改时间等排序键可能变化
+        control.invalidateSortKey(fileName);
     });
     qCDebug(logImageViewer) << "Connect signal imageFileChanged.";
+    // 异步扫描文件夹追加的图片，同步更新文件监控
+    QObject::connect(&control, &GlobalControl::imageFilesAppended, &fileControl, &FileControl::appendImageFiles);
+    qCDebug(logImageViewer) << "Connect signal imageFilesAppended.";
+    // 文件夹中新增的图片按文件名顺序插入
+    QObject::connect(&fileControl, &FileControl::imageFilesAdded, &control, &GlobalControl::insertImageFiles);
+    qCDebug(logImageViewer) << "Connect signal imageFilesAdded.";
 
-    // OCR分析工具
+    // OCR分析工具，识别插件在首次识别时加载
     auto liveTextAnalyzer = new LiveTextAnalyzer;
     engine.rootContext()->setContextProperty("liveTextAnalyzer", liveTextAnalyzer);
     engine.addImageProvider(QLatin1String("liveTextAnalyzer"), liveTextAnalyzer);
     qCDebug(logImageViewer) << "LiveTextAnalyzer registered.";
 
     // 判断命令行数据，在 QML 前优先加载
-    if (!cliParam.isEmpty()) {
-        qCDebug(logImageViewer) << "Commandline parameter is not empty, processing initial image.";
-        QStringList filePaths = fileControl.getDirImagePath(cliParam);
-        if (!filePaths.isEmpty()) {
-            qCDebug(logImageViewer) << "Found image files: " << filePaths.count();
-            control.setImageFiles(filePaths, cliParam);
-            fileControl.resetImageFiles(filePaths);
+    if (!cliTreeRoot.isEmpty()) {
+        qCDebug(logImageViewer) << "Recursive browsing requested, root:" << cliTreeRoot;
+        // 仅监控打开图片所在的文件夹，子文件夹中新增的图片不追加
+        TraceSpan span("startup", "loadImageTree", cliTreeRoot);
+        fileControl.resetImageFiles(cliParam.isEmpty() ? QStringList() : QStringList { cliParam });
+        control.loadImageTree(cliTreeRoot, cliParam);
+        span.finish();
 
+        // 未传入图片时，找到首张图片后切换至图片展示界面
+        if (!cliParam.isEmpty()) {
             status.setStackPage(Types::ImageViewPage);
-            qCDebug(logImageViewer) << "Set stack page to ImageViewPage.";
+        }
+    } else if (!cliParam.isEmpty()) {
+        qCDebug(logImageViewer) << "Commandline parameter is not empty, processing initial image.";
+        // 命令行参数已校验为图片，立即展示，文件夹中的其它图片在后台扫描后追加
+        TraceSpan span("startup", "loadImageDirectory", cliParam);
+        if (cliFiles.size() > 1) {
+            fileControl.resetImageFiles(cliFiles);
+            control.openImageFiles(cliFiles, cliParam);
         } else {
-            qCDebug(logImageViewer) << "No image files found for the given commandline parameter.";
+            fileControl.resetImageFiles({ cliParam });
+            control.loadImageDirectory(cliParam);
         }
+        span.finish();
+
+        status.setStackPage(Types::ImageViewPage);
+        qCDebug(logImageViewer) << "Set stack page to ImageViewPage.";
     } else {
         qCDebug(logImageViewer) << "Commandline parameter is empty, no initial image to load.";
+        // 待机模式启动时不展示窗口
+        standby.enterStandby();
     }
 
     qCDebug(logImageViewer) << "Loading QML file: qrc:/qt/qml/IVModule/qml/main.qml";
+    TraceSpan loadSpan("startup", "engine.load");
     engine.load(QUrl("qrc:/qt/qml/IVModule/qml/main.qml"));
+    loadSpan.finish();
     if (engine.rootObjects().isEmpty()) {
         qCCritical(logImageViewer) << "Failed to load QML file, root objects empty.";
         return -1;
     }
     qCDebug(logImageViewer) << "QML file loaded successfully.";
+    StartupTrace::mark("qml loaded");
+    StartupTrace::watchWindow(qobject_cast<QQuickWindow *>(engine.rootObjects().first()));
+    standby.setWindow(qobject_cast<QQuickWindow *>(engine.rootObjects().first()));
 
     // 设置DBus接口
-    ApplicationAdaptor adaptor(&fileControl);
+    ApplicationAdaptor adaptor(&fileControl, &standby);
     QDBusConnection::sessionBus().registerService("com.deepin.imageViewer");
     qCDebug(logImageViewer) << "DBus service 'com.deepin.imageViewer' registered.";
     QDBusConnection::sessionBus().registerObject("/", &fileControl);
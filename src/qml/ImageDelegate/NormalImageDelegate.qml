@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 import QtQuick
+import QtQuick.Window
 import org.deepin.image.viewer 1.0 as IV
 import "../Utils"
 
@@ -23,6 +24,23 @@ BaseImageDelegate {
         image.source = temp;
     }
 
+    // 根据当前实际显示大小选取缩小层级，层级 n 的图像宽高为原图的 1/2^n
+    function updateMipmapLevel() {
+        if (rotateAnimationLoader.active || Image.Ready !== image.status || image.sourceSize.width <= 0) {
+            mipImage.level = 0;
+            return;
+        }
+        var ratio = image.paintedWidth * image.scale * Screen.devicePixelRatio / image.sourceSize.width;
+        if (ratio <= 0 || ratio >= 0.5) {
+            mipImage.level = 0;
+            return;
+        }
+        // 缩放过程中使用更小的层级降低开销，缩放结束后使用不低于显示精度的层级
+        var exactLevel = -Math.log2(ratio);
+        var level = imageInput.interacting ? Math.ceil(exactLevel) : Math.floor(exactLevel);
+        mipImage.level = Math.max(0, Math.min(level, 6));
+    }
+
     function updateSource() {
         if (delegate.source != "") {
             // 由于会 resetSource() 破坏绑定，因此重新设置源数据
@@ -39,6 +57,30 @@ BaseImageDelegate {
     onFrameIndexChanged: updateSource()
     onSourceChanged: updateSource()
 
+    Connections {
+        function onPaintedWidthChanged() {
+            delegate.updateMipmapLevel();
+        }
+
+        function onScaleChanged() {
+            delegate.updateMipmapLevel();
+        }
+
+        function onStatusChanged() {
+            delegate.updateMipmapLevel();
+        }
+
+        target: image
+    }
+
+    Connections {
+        function onInteractingChanged() {
+            delegate.updateMipmapLevel();
+        }
+
+        target: imageInput
+    }
+
     Image {
         id: image
 
@@ -47,8 +89,10 @@ BaseImageDelegate {
         fillMode: Image.PreserveAspectFit
         height: delegate.height
         mipmap: true
+        // 缩小层级图像已覆盖显示时，跳过原图绘制
+        opacity: mipImage.visible ? 0 : 1
         scale: 1.0
-        smooth: true
+        smooth: !imageInput.interacting
         source: "image://ImageLoad/" + delegate.source + "#frame_" + delegate.frameIndex
         width: delegate.width
         // TODO: wait for Qt6.8 avoid flickering when image source change
@@ -61,6 +105,26 @@ BaseImageDelegate {
         }
     }
 
+    // 缩小显示大图时使用的低分辨率图像，由 ImageLoad 在子线程中逐级生成，避免每帧缩放原图
+    Image {
+        id: mipImage
+
+        property int level: 0
+
+        asynchronous: true
+        cache: false
+        fillMode: image.fillMode
+        height: image.height
+        rotation: image.rotation
+        scale: image.scale
+        smooth: !imageInput.interacting
+        source: level > 0 ? "image://ImageLoad/" + delegate.source + "#frame_" + delegate.frameIndex + "#mip_" + level : ""
+        visible: level > 0 && Image.Ready === status && image.visible && !rotateAnimationLoader.active
+        width: image.width
+        x: image.x
+        y: image.y
+    }
+
     // 旋转动画效果
     Loader {
         id: rotateAnimationLoader
@@ -68,6 +132,8 @@ BaseImageDelegate {
         active: false
         anchors.fill: parent
 
+        onActiveChanged: delegate.updateMipmapLevel()
+
         sourceComponent: Item {
             id: rotateItem
 
@@ -151,6 +217,7 @@ BaseImageDelegate {
                     if (!running && Image.Ready === image.status) {
                         image.visible = true;
                         rotateAnimationLoader.active = false;
+                        delegate.updateMipmapLevel();
                     }
                     rotationRunning = running;
                 }
@@ -22,9 +22,16 @@ Item {
 
     // 设置当前使用的图片源
     function setSourcePath(path) {
-        if (IV.FileControl.isCurrentWatcherDir(path)) {
+        // 指定图片列表中不包含的图片需重新加载所在文件夹
+        if (IV.FileControl.isCurrentWatcherDir(path) && IV.GControl.globalModel.indexForImagePath(path) !== -1) {
             // 更新当前文件路径
             IV.GControl.currentSource = path;
+        } else if (IV.FileControl.isImage(path)) {
+            // 立即展示打开的图片，文件夹中的其它图片在后台扫描后追加
+            IV.FileControl.resetImageFiles([path]);
+            IV.GControl.loadImageDirectory(path);
+            console.log("Load image info", path);
+            switchImageView();
         } else {
             var sourcePaths = IV.FileControl.getDirImagePath(path);
             if (sourcePaths.length > 0) {
@@ -39,6 +46,16 @@ Item {
         }
     }
 
+    // 设置指定的图片列表，仅浏览列表中的图片，不扫描图片所在的文件夹
+    function setSourcePaths(paths, current) {
+        // 先清空监控的文件，避免与当前监控的文件夹相同时不更新监控列表
+        IV.FileControl.resetImageFiles();
+        IV.FileControl.resetImageFiles(paths);
+        IV.GControl.openImageFiles(paths, current);
+        console.log("Load image list", paths.length, current);
+        switchImageView();
+    }
+
     function switchImageView() {
         IV.GStatus.stackPage = Number(IV.Types.ImageViewPage);
         contentLoader.setSource("qrc:/qt/qml/IVModule/qml/FullImageView.qml");
@@ -74,9 +91,33 @@ Item {
             setSourcePath(fileName);
         }
 
+        function onOpenImageFiles(fileNames, currentFile) {
+            setSourcePaths(fileNames, currentFile);
+        }
+
         target: IV.FileControl
     }
 
+    Connections {
+        // 进入待机状态时卸载图片展示界面，释放图像数据
+        function onActiveChanged() {
+            if (IV.Standby.active) {
+                switchOpenImage();
+            }
+        }
+
+        target: IV.Standby
+    }
+
+    Connections {
+        // 递归浏览文件夹时，找到首张图片后进入图片展示界面
+        function onTreeFirstImageFound() {
+            switchImageView();
+        }
+
+        target: IV.GControl
+    }
+
     // 标题栏
     ViewTopTitle {
         id: titleRect
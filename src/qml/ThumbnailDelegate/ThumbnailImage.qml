@@ -3,11 +3,14 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 import QtQuick
+import QtQuick.Window
 import org.deepin.image.viewer 1.0 as IV
 
 Item {
     id: thumbnailImage
 
+    // 缩略图的最大显示大小(激活状态)，用于选取缩略图层级，不跟随动画过程中的大小变更
+    property int displaySize: 50
     property alias frameCount: imageInfo.frameCount
     property int frameIndex: 0
     property alias image: contentImage
@@ -42,6 +45,8 @@ Item {
             return 1 + ((Math.sqrt(2) - 1) * ratio);
         }
         smooth: true
+        // 按设备像素比请求对应层级的缩略图，高分屏下使用较大的层级
+        sourceSize: Qt.size(Math.ceil(thumbnailImage.displaySize * Screen.devicePixelRatio), Math.ceil(thumbnailImage.displaySize * Screen.devicePixelRatio))
         width: thumbnailImage.width
     }
 
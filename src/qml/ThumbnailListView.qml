@@ -258,7 +258,11 @@ Control {
     ListView {
         id: bottomthumbnaillistView
 
+        // 轻弹速度超过此值(像素/秒)时暂缓加载缩略图
+        property real deferLoadVelocity: 1500
         property bool lastIsMultiImage: false
+        // 视图中心在内容中的位置，用于计算缩略图加载优先级
+        readonly property real viewCenter: contentX + width / 2
 
         // 重新定位图片位置
         function rePositionView(force) {
@@ -361,6 +365,9 @@ Control {
                 property url delegateSource
                 property bool isCurrentItem: thumbnailItemLoader.ListView.isCurrentItem
 
+                // 按距离视图中心的缩略图个数排序加载，离开缓存区域的缩略图销毁时取消加载
+                loadPriority: 1 + Math.floor(Math.abs(thumbnailItemLoader.x + thumbnailItemLoader.width / 2 - bottomthumbnaillistView.viewCenter) / (30 + bottomthumbnaillistView.spacing))
+
                 function checkDelegateSource() {
                     if (IV.ImageInfo.Ready !== status && IV.ImageInfo.Error !== status) {
                         return;
@@ -470,6 +477,13 @@ Control {
             target: IV.GStatus
         }
 
+        // 快速轻弹时暂缓启动新的缩略图加载任务
+        Binding {
+            property: "thumbnailFlicking"
+            target: IV.GStatus
+            value: bottomthumbnaillistView.flicking && Math.abs(bottomthumbnaillistView.horizontalVelocity) > bottomthumbnaillistView.deferLoadVelocity
+        }
+
         Timer {
             id: delayUpdateTimer
 
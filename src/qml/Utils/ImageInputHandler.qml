@@ -11,6 +11,8 @@ import org.deepin.image.viewer 1.0 as IV
 Item {
     id: imageInput
 
+    // 缩放手势(滚轮/触摸)进行中，手势结束并稳定后复位，用于外部在缩放过程中降低绘制质量
+    readonly property bool interacting: imagePinchArea.pinch.active || wheelSettleTimer.running
     // 仅部分图片允许旋转
     property bool isRotatable: false
     property Image targetImage: null
@@ -108,6 +110,9 @@ Item {
                     return;
                 }
 
+                // 滚轮缩放连续触发，延迟标记缩放结束
+                wheelSettleTimer.restart();
+
                 // 缓存当前的坐标信息
                 var mapPoint = mapToItem(imageInput.targetImage, wheel.x, wheel.y);
                 if (detla > 0) {
@@ -131,6 +136,15 @@ Item {
 
             onTriggered: mouseArea.updateDragRect()
         }
+
+        // 滚轮缩放稳定计时，超时后认为缩放结束
+        Timer {
+            id: wheelSettleTimer
+
+            interval: 200
+            repeat: false
+            running: false
+        }
     }
 
     // 和MouseArea存在先后顺序，使用触摸时优先处理触摸事件
@@ -259,6 +259,60 @@ Menu {
         }
     }
 
+    // 图片排序方式，非文件名排序时在后台读取排序键，读取完成后重新排序
+    Menu {
+        title: qsTr("Sort by")
+
+        ButtonGroup {
+            id: sortOrderGroup
+        }
+
+        RightMenuItem {
+            ButtonGroup.group: sortOrderGroup
+            checkable: true
+            checked: IV.GControl.sortOrder === IV.Types.SortByName
+            text: qsTr("Name")
+
+            onTriggered: IV.GControl.sortOrder = IV.Types.SortByName
+        }
+
+        RightMenuItem {
+            ButtonGroup.group: sortOrderGroup
+            checkable: true
+            checked: IV.GControl.sortOrder === IV.Types.SortByCaptureTime
+            text: qsTr("Date taken")
+
+            onTriggered: IV.GControl.sortOrder = IV.Types.SortByCaptureTime
+        }
+
+        RightMenuItem {
+            ButtonGroup.group: sortOrderGroup
+            checkable: true
+            checked: IV.GControl.sortOrder === IV.Types.SortByModifiedTime
+            text: qsTr("Date modified")
+
+            onTriggered: IV.GControl.sortOrder = IV.Types.SortByModifiedTime
+        }
+
+        RightMenuItem {
+            ButtonGroup.group: sortOrderGroup
+            checkable: true
+            checked: IV.GControl.sortOrder === IV.Types.SortByFileSize
+            text: qsTr("File size")
+
+            onTriggered: IV.GControl.sortOrder = IV.Types.SortByFileSize
+        }
+
+        RightMenuItem {
+            ButtonGroup.group: sortOrderGroup
+            checkable: true
+            checked: IV.GControl.sortOrder === IV.Types.SortByPixelCount
+            text: qsTr("Dimensions")
+
+            onTriggered: IV.GControl.sortOrder = IV.Types.SortByPixelCount
+        }
+    }
+
     RightMenuItem {
         text: qsTr("Display in file manager")
 
@@ -29,7 +29,8 @@ ApplicationWindow {
     height: IV.FileControl.getlastHeight()
     minimumHeight: IV.GStatus.minHeight
     minimumWidth: IV.GStatus.minWidth
-    visible: true
+    // 待机状态时隐藏窗口
+    visible: !IV.Standby.active
     width: IV.FileControl.getlastWidth()
 
     Component.onCompleted: {
@@ -38,9 +39,15 @@ ApplicationWindow {
             setY(screen.height / 2 - height / 2);
         }
     }
-    onClosing: {
+    onClosing: function (close) {
         IV.FileControl.saveSetting(); //保存信息
         IV.FileControl.terminateShortcutPanelProcess(); //结束快捷键面板进程
+        if (IV.Standby.enabled) {
+            // 待机模式下不退出，隐藏窗口并释放缓存
+            close.accepted = false;
+            IV.Standby.enterStandby();
+            return;
+        }
         IV.GControl.forceExit();
     }
     onHeightChanged: {
@@ -90,6 +90,17 @@ void CommandParser::initOptions()
     QCommandLineOption printOption("print");
     addOption(printOption);
     qCDebug(logImageViewer) << "Added 'print' command line option.";
+    // 待机模式，隐藏窗口常驻，通过 DBus 打开图片
+    QCommandLineOption standbyOption("standby", "Start hidden and stay resident to open images through DBus.");
+    addOption(standbyOption);
+    QCommandLineOption standbyIdleOption(
+            "standby-idle", "Minutes in standby before the process exits, 0 for never.", "minutes", "30");
+    addOption(standbyIdleOption);
+    qCDebug(logImageViewer) << "Added 'standby' command line options.";
+    // 递归浏览传入的文件夹或图片所在的文件夹
+    QCommandLineOption recursiveOption("recursive", "Browse images in the folder and all of its subfolders.");
+    addOption(recursiveOption);
+    qCDebug(logImageViewer) << "Added 'recursive' command line option.";
 }
 
 void CommandParser::addOption(const QCommandLineOption &option)
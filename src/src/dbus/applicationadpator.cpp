@@ -3,12 +3,15 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "applicationadpator.h"
+#include "../standbycontroller.h"
 
+#include <QSet>
 #include <QUrl>
 
-ApplicationAdaptor::ApplicationAdaptor(FileControl *controller)
+ApplicationAdaptor::ApplicationAdaptor(FileControl *controller, StandbyController *standby)
     : QDBusAbstractAdaptor(controller)
     , fileControl(controller)
+    , standbyController(standby)
 {
 }
 
@@ -22,6 +25,10 @@ bool ApplicationAdaptor::openImageFile(const QString &fileName)
     if (fileControl) {
         QString urlPath = QUrl::fromLocalFile(fileName).toString();
         if (fileControl->isCanReadable(urlPath)) {
+            // 待机状态时先开始解码并展示窗口
+            if (standbyController) {
+                standbyController->wake(urlPath);
+            }
             Q_EMIT fileControl->openImageFile(urlPath);
             return true;
         }
@@ -29,3 +36,67 @@ bool ApplicationAdaptor::openImageFile(const QString &fileName)
 
     return false;
 }
+
+/**
+ * @brief 仅当前实例处于待机状态时打开传入的图片文件，用于新启动的进程转发图片
+ * @param fileName 文件路径
+ * @return 是否已打开图片文件，未处于待机状态时返回 false
+ */
+bool ApplicationAdaptor::openImageFileInStandby(const QString &fileName)
+{
+    if (!standbyController || !standbyController->isActive()) {
+        return false;
+    }
+
+    return openImageFile(fileName);
+}
+
+/**
+ * @brief 打开传入的图片列表，仅浏览列表中的图片，不扫描图片所在的文件夹
+ * @param fileNames 文件路径列表，不可读取或非图片的文件将被忽略
+ * @param currentFile 首个展示的文件路径，不在列表中时展示列表中的首张图片
+ * @return 是否允许打开图片文件
+ */
+bool ApplicationAdaptor::openImageFiles(const QStringList &fileNames, const QString &currentFile)
+{
+    if (!fileControl) {
+        return false;
+    }
+
+    QStringList urlPaths;
+    QSet<QString> visited;
+    for (const QString &fileName : fileNames) {
+        QString urlPath = QUrl::fromLocalFile(fileName).toString();
+        if (!visited.contains(urlPath) && fileControl->isCanReadable(urlPath) && fileControl->isImage(urlPath)) {
+            visited.insert(urlPath);
+            urlPaths.append(urlPath);
+        }
+    }
+    if (urlPaths.isEmpty()) {
+        return false;
+    }
+
+    QString currentUrl = QUrl::fromLocalFile(currentFile).toString();
+    if (!urlPaths.contains(currentUrl)) {
+        currentUrl = urlPaths.first();
+    }
+
+    if (standbyController) {
+        standbyController->wake(currentUrl);
+    }
+    Q_EMIT fileControl->openImageFiles(urlPaths, currentUrl);
+    return true;
+}
+
+/**
+ * @brief 仅当前实例处于待机状态时打开传入的图片列表，参数同 openImageFiles()
+ * @return 是否已打开图片文件，未处于待机状态时返回 false
+ */
+bool ApplicationAdaptor::openImageFilesInStandby(const QStringList &fileNames, const QString &currentFile)
+{
+    if (!standbyController || !standbyController->isActive()) {
+        return false;
+    }
+
+    return openImageFiles(fileNames, currentFile);
+}
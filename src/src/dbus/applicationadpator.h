@@ -9,6 +9,8 @@
 
 #include <QtDBus>
 
+class StandbyController;
+
 class ApplicationAdaptor : public QDBusAbstractAdaptor
 {
     Q_OBJECT
@@ -18,17 +20,38 @@ class ApplicationAdaptor : public QDBusAbstractAdaptor
                 "    <method name=\"openImageFile\">\n"
                 "        <arg direction=\"in\" type=\"s\" name=\"fileName\"/>\n"
                 "    </method>\n"
+                "    <method name=\"openImageFileInStandby\">\n"
+                "        <arg direction=\"in\" type=\"s\" name=\"fileName\"/>\n"
+                "        <arg direction=\"out\" type=\"b\"/>\n"
+                "    </method>\n"
+                "    <method name=\"openImageFiles\">\n"
+                "        <arg direction=\"in\" type=\"as\" name=\"fileNames\"/>\n"
+                "        <arg direction=\"in\" type=\"s\" name=\"currentFile\"/>\n"
+                "        <arg direction=\"out\" type=\"b\"/>\n"
+                "    </method>\n"
+                "    <method name=\"openImageFilesInStandby\">\n"
+                "        <arg direction=\"in\" type=\"as\" name=\"fileNames\"/>\n"
+                "        <arg direction=\"in\" type=\"s\" name=\"currentFile\"/>\n"
+                "        <arg direction=\"out\" type=\"b\"/>\n"
+                "    </method>\n"
                 "</interface>\n")
 
 public:
-    explicit ApplicationAdaptor(FileControl *controller);
+    explicit ApplicationAdaptor(FileControl *controller, StandbyController *standby = nullptr);
 
 public Q_SLOTS:
     // 打开图片文件
     bool openImageFile(const QString &fileName);
+    // 仅当处于待机状态时打开图片文件
+    bool openImageFileInStandby(const QString &fileName);
+    // 打开指定的图片列表，仅浏览列表中的图片
+    bool openImageFiles(const QStringList &fileNames, const QString &currentFile);
+    // 仅当处于待机状态时打开指定的图片列表
+    bool openImageFilesInStandby(const QStringList &fileNames, const QString &currentFile);
 
 private:
     FileControl *fileControl = nullptr;
+    StandbyController *standbyController = nullptr;
 };
 
 #endif  // APPLICATIONADPATOR_H
@@ -6,18 +6,23 @@
 #include "types.h"
 #include "unionimage/unionimage_global.h"
 #include "unionimage/unionimage.h"
+#include "unionimage/imageformatregistry.h"
 #include "printdialog/printhelper.h"
 #include "ocr/ocrinterface.h"
 #include "imagedata/imageinfo.h"
+#include "imagedata/imagedirscanner.h"
+#include "imagedata/imagenamecollator.h"
+#include "commandparser.h"
+#include "utils/tracerecorder.h"
 
 #include <DSysInfo>
 
 #include <QFileInfo>
 #include <QDir>
-#include <QMimeDatabase>
-#include <QCollator>
+#include <QImageReader>
 #include <QUrl>
 #include <QDBusInterface>
+#include <QSet>
 #include <QThread>
 #include <QProcess>
 #include <QGuiApplication>
@@ -46,13 +51,6 @@ const QString SETTINGS_ENABLE_NAVIGATION = "EnableNavigation";
 const int MAINWIDGET_MINIMUN_HEIGHT = 300;
 const int MAINWIDGET_MINIMUN_WIDTH = 628;
 
-bool compareByFileInfo(const QFileInfo &str1, const QFileInfo &str2)
-{
-    static QCollator sortCollator;
-    sortCollator.setNumericMode(true);
-    return sortCollator.compare(str1.baseName(), str2.baseName()) < 0;
-}
-
 // 转换路径
 QUrl UrlInfo(QString path)
 {
@@ -87,13 +85,13 @@ FileControl::FileControl(QObject *parent)
     : QObject(parent)
 {
     qCDebug(logImageViewer) << "FileControl constructor entered.";
-    m_ocrInterface = new OcrInterface("com.deepin.Ocr", "/com/deepin/Ocr", QDBusConnection::sessionBus(), this);
-    m_shortcutViewProcess = new QProcess(this);
+    // OCR 接口和快捷键面板进程在首次使用时创建
     m_config = LibConfigSetter::instance();
     imageFileWatcher = ImageFileWatcher::instance();
-    qCDebug(logImageViewer) << "OCR interface, shortcut view process, config, and image file watcher initialized.";
+    qCDebug(logImageViewer) << "Config and image file watcher initialized.";
 
     QObject::connect(imageFileWatcher, &ImageFileWatcher::imageFileChanged, this, &FileControl::imageFileChanged);
+    QObject::connect(imageFileWatcher, &ImageFileWatcher::imageFilesAdded, this, &FileControl::imageFilesAdded);
     qCDebug(logImageViewer) << "Connected imageFileWatcher::imageFileChanged signal.";
 
     // 在1000ms以内只保存一次配置信息
@@ -102,19 +100,6 @@ FileControl::FileControl(QObject *parent)
         connect(m_tSaveSetting, &QTimer::timeout, this, [=]() { saveSetting(); });
         qCDebug(logImageViewer) << "Save setting timer initialized and connected.";
     }
-
-    listsupportWallPaper << "bmp"
-                         << "cod"
-                         << "png"
-                         << "gif"
-                         << "ief"
-                         << "jpe"
-                         << "jpeg"
-                         << "jpg"
-                         << "jfif"
-                         << "tif"
-                         << "tiff";
-    qCDebug(logImageViewer) << "Supported wallpaper formats initialized.";
 }
 
 FileControl::~FileControl()
@@ -137,19 +122,20 @@ QStringList FileControl::getDirImagePath(const QString &path)
         return QStringList();
     }
 
+    TraceSpan span("directory", "getDirImagePath", path);
     QStringList image_list;
     QString DirPath = QFileInfo(QUrl(path).toLocalFile()).dir().path();
     qCDebug(logImageViewer) << "Directory path:" << DirPath;
 
     QDir _dirinit(DirPath);
-    QFileInfoList m_AllPath = _dirinit.entryInfoList(QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
+    QStringList m_AllPath = _dirinit.entryList(QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
     qCDebug(logImageViewer) << "Found" << m_AllPath.size() << "entries in directory.";
 
-    // 修复Ｑt带后缀排序错误的问题
-    std::sort(m_AllPath.begin(), m_AllPath.end(), compareByFileInfo);
-    qCDebug(logImageViewer) << "Sorted file info list.";
+    // 修复Ｑt带后缀排序错误的问题，预先生成排序键后排序
+    ImageNameCollator::sort(m_AllPath);
+    qCDebug(logImageViewer) << "Sorted file name list.";
     for (int i = 0; i < m_AllPath.size(); i++) {
-        QString tmpPath = m_AllPath.at(i).filePath();
+        QString tmpPath = _dirinit.filePath(m_AllPath.at(i));
         if (tmpPath.isEmpty()) {
             qCDebug(logImageViewer) << "Skipping empty file path at index" << i;
             continue;
@@ -201,13 +187,10 @@ QString FileControl::getNamePath(const QString &oldPath, const QString &newName)
 bool FileControl::isImage(const QString &path)
 {
     qCDebug(logImageViewer) << "Checking if path is an image:" << path;
-    bool bRet = false;
-    QMimeDatabase db;
-    QMimeType mt = db.mimeTypeForFile(path, QMimeDatabase::MatchContent);
-    QMimeType mt1 = db.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
-    qCDebug(logImageViewer) << "Mime type by content:" << mt.name() << ", by extension:" << mt1.name();
-    if (mt.name().startsWith("image/") || mt.name().startsWith("video/x-mng") || mt1.name().startsWith("image/") || mt1.name().startsWith("video/x-mng")) {
-        bRet = true;
+    // 后缀为已注册的格式时无需读取文件，其次通过文件头识别，均无法识别时由图片插件判断
+    const QString localPath = path.startsWith("file://") ? QUrl(path).toLocalFile() : path;
+    bool bRet = ImageDirScanner::isImageFile(localPath);
+    if (bRet) {
         qCDebug(logImageViewer) << "Path identified as image.";
     }
     qCDebug(logImageViewer) << "isImage returning:" << bRet;
@@ -457,7 +440,7 @@ void FileControl::ocrImage(const QString &path, int index)
 
     if (Types::MultiImage != info.type()) {   // 非多页图使用路径直接进行识别
         qCDebug(logImageViewer) << "Processing single page image for OCR";
-        m_ocrInterface->openFile(localPath);
+        ocrInterface()->openFile(localPath);
         qCDebug(logImageViewer) << "Called OCR interface openFile for single image.";
     } else {   // 多页图需要确定识别哪一页
         qCDebug(logImageViewer) << "Processing multi-page image for OCR, page:" << index;
@@ -478,11 +461,23 @@ void FileControl::ocrImage(const QString &path, int index)
 
         image.save(tempFileName);
         qCDebug(logImageViewer) << "Saved temporary image for OCR:" << tempFileName;
-        m_ocrInterface->openFile(tempFileName);
+        ocrInterface()->openFile(tempFileName);
         qCDebug(logImageViewer) << "Called OCR interface openFile for temporary image.";
     }
 }
 
+/**
+   @return 返回 OCR 的 DBus 接口，首次识别时创建
+ */
+OcrInterface *FileControl::ocrInterface()
+{
+    if (!m_ocrInterface) {
+        qCDebug(logImageViewer) << "Creating OCR interface.";
+        m_ocrInterface = new OcrInterface("com.deepin.Ocr", "/com/deepin/Ocr", QDBusConnection::sessionBus(), this);
+    }
+    return m_ocrInterface;
+}
+
 QString FileControl::parseCommandlineGetPath()
 {
     qCDebug(logImageViewer) << "Parsing commandline to get path.";
@@ -503,6 +498,49 @@ QString FileControl::parseCommandlineGetPath()
     return filepath;
 }
 
+/**
+   @return 返回命令行参数中的全部图片(url路径)，保持传入顺序并去除重复的图片
+ */
+QStringList FileControl::parseCommandlineGetPaths()
+{
+    qCDebug(logImageViewer) << "Parsing commandline to get all image paths.";
+    QStringList imageFiles;
+    QSet<QString> visited;
+    const QStringList arguments = QCoreApplication::arguments();
+    for (QString path : arguments) {
+        path = UrlInfo(path).toLocalFile();
+        if (visited.contains(path) || !QFileInfo(path).isFile()) {
+            continue;
+        }
+        visited.insert(path);
+
+        if (isImage(path)) {
+            imageFiles.append(QUrl::fromLocalFile(path).toString());
+        }
+    }
+
+    qCDebug(logImageViewer) << "Found" << imageFiles.size() << "image files in commandline arguments.";
+    return imageFiles;
+}
+
+/**
+   @return 返回命令行参数中的首个文件夹(本地路径)，用于递归浏览，无文件夹时返回空
+ */
+QString FileControl::parseCommandlineGetDirectory()
+{
+    qCDebug(logImageViewer) << "Parsing commandline to get directory.";
+    const QStringList arguments = CommandParser::instance()->positionalArguments();
+    for (const QString &argument : arguments) {
+        const QString path = UrlInfo(argument).toLocalFile();
+        if (QFileInfo(path).isDir()) {
+            qCDebug(logImageViewer) << "Found directory in commandline arguments:" << path;
+            return QFileInfo(path).absoluteFilePath();
+        }
+    }
+
+    return {};
+}
+
 QString FileControl::slotGetFileName(const QString &path)
 {
     qCDebug(logImageViewer) << "Getting file name for path: " << path;
@@ -781,9 +819,9 @@ bool FileControl::isSupportSetWallpaper(const QString &path)
     qCDebug(logImageViewer) << "FileControl::isSupportSetWallpaper() called for path: " << path;
     QString path1 = QUrl(path).toLocalFile();
     QFileInfo fileinfo(path1);
-    QString format = fileinfo.suffix().toLower();
+    QString format = fileinfo.suffix();
     // 设置为壁纸需要判断是否有读取权限
-    if (listsupportWallPaper.contains(format) && fileinfo.isReadable()) {
+    if (ImageFormatRegistry::hasCapability(format, ImageFormatRegistry::WallPaper) && fileinfo.isReadable()) {
         qCDebug(logImageViewer) << "Image format " << format << " is supported and readable for wallpaper. Returning true.";
         return true;
     }
@@ -888,6 +926,15 @@ void FileControl::resetImageFiles(const QStringList &filePaths)
     qCDebug(logImageViewer) << "Image files reset complete.";
 }
 
+/**
+   @brief 追加监控的图片文件 \a filePaths ，用于异步扫描文件夹时分批追加，不清理缓存
+ */
+void FileControl::appendImageFiles(const QStringList &filePaths)
+{
+    qCDebug(logImageViewer) << "FileControl::appendImageFiles() called, count:" << filePaths.size();
+    imageFileWatcher->appendImageFiles(filePaths);
+}
+
 /**
  * @return 返回公司Logo图标地址
  */
@@ -902,6 +949,9 @@ QUrl FileControl::getCompanyLogo()
 void FileControl::terminateShortcutPanelProcess()
 {
     qCDebug(logImageViewer) << "FileControl::terminateShortcutPanelProcess() called.";
+    if (!m_shortcutViewProcess) {
+        return;
+    }
     m_shortcutViewProcess->terminate();
     qCDebug(logImageViewer) << "Shortcut panel process terminated.";
     m_shortcutViewProcess->waitForFinished(2000);
@@ -922,6 +972,9 @@ void FileControl::showShortcutPanel(int windowCenterX, int windowCenterY)
     qCDebug(logImageViewer) << "Shortcut parameters: " << shortcutString;
 
     terminateShortcutPanelProcess();
+    if (!m_shortcutViewProcess) {
+        m_shortcutViewProcess = new QProcess(this);
+    }
     m_shortcutViewProcess->start("deepin-shortcut-viewer", shortcutString);
     qCDebug(logImageViewer) << "Shortcut panel process started.";
 }
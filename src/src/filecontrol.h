@@ -30,6 +30,7 @@ public:
     Q_INVOKABLE QString standardPicturesPath() const;
 
     Q_INVOKABLE void resetImageFiles(const QStringList &filePaths = {});       // 重设当前展示图片列表
+    Q_SLOT void appendImageFiles(const QStringList &filePaths);                // 追加当前展示图片列表
     Q_INVOKABLE QStringList getDirImagePath(const QString &path);              // 获得路径下的所有图片路径
     Q_INVOKABLE bool isCurrentWatcherDir(const QUrl &path);                    // 判断是否为当前正在监控的文件路径
     Q_INVOKABLE QString slotGetInfo(const QString &key, const QString &path);  // 获取某项info
@@ -46,6 +47,8 @@ public:
     Q_INVOKABLE void ocrImage(const QString &path, int index);   // 进行ocr识别
     Q_INVOKABLE void showPrintDialog(const QString &path);       // 调用打印接口
     Q_INVOKABLE QString parseCommandlineGetPath();               // 解析命令行
+    Q_INVOKABLE QStringList parseCommandlineGetPaths();          // 解析命令行中的全部图片
+    Q_INVOKABLE QString parseCommandlineGetDirectory();          // 解析命令行中的文件夹
 
     Q_INVOKABLE bool isCheckOnly();                               // 判断当前进程是否为唯一看图实例
     Q_INVOKABLE bool isSupportSetWallpaper(const QString &path);  // 是否支持设置壁纸
@@ -78,21 +81,25 @@ public:
 
     // 打开文件，触发 OpenImageWidget.qml:openImageFile 处理，fileName需为url路径
     Q_SIGNAL void openImageFile(const QString &fileName);
+    // 打开指定的图片列表，仅浏览列表中的图片，触发 MainStack.qml:setSourcePaths 处理，均需为url路径
+    Q_SIGNAL void openImageFiles(const QStringList &fileNames, const QString &currentFile);
     // 文件被重命名
     Q_SIGNAL void imageRenamed(const QUrl &oldName, const QUrl &newName);
     // 文件变更通知信号，文件被移动、删除、覆盖等操作时触发
     Q_SIGNAL void imageFileChanged(const QString &fileName);
+    // 当前文件夹中新增图片文件，已按文件名排序
+    Q_SIGNAL void imageFilesAdded(const QStringList &sortedFiles);
 
 private:
     // 生成用于快捷键面板的字符串
     QString createShortcutString();
+    OcrInterface *ocrInterface();
 
 private:
-    OcrInterface *m_ocrInterface;
+    OcrInterface *m_ocrInterface = nullptr;  // OCR 接口，懒加载，需要通过ocrInterface()函数使用
 
     QString m_shortcutString;  // 快捷键字符串，将采用懒加载模式，需要通过createShortcutString()函数使用
-    QProcess *m_shortcutViewProcess;               // 快捷键面板进程
-    QStringList listsupportWallPaper;              // 支持设置壁纸的图片后缀类型
+    QProcess *m_shortcutViewProcess = nullptr;     // 快捷键面板进程，首次展示时创建
     ImageFileWatcher *imageFileWatcher = nullptr;  // 图片文件变更监控
 
     QString m_currentPath;                    // 当前操作的旋转图片路径
@@ -5,9 +5,17 @@
 #include "globalcontrol.h"
 #include "types.h"
 #include "imagedata/imagesourcemodel.h"
+#include "imagedata/imageprewarmer.h"
+#include "imagedata/imagedirscanner.h"
+#include "imagedata/imagetreescanner.h"
+#include "imagedata/imagesortkeyloader.h"
+#include "configsetter.h"
 #include "utils/rotateimagehelper.h"
+#include "utils/tracerecorder.h"
 
+#include <QDir>
 #include <QEvent>
+#include <QFileInfo>
 #include <QThread>
 #include <QDebug>
 #include <QApplication>
@@ -16,6 +24,8 @@
 Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
 
 static const int sc_SubmitInterval = 200;   // 图片变更提交定时间隔 200ms
+static const QString sc_SettingsGroup = "MAINWINDOW";
+static const QString sc_SortOrderKey = "ImageSortOrder";
 
 /**
    @class GlobalControl
@@ -29,6 +39,27 @@ GlobalControl::GlobalControl(QObject *parent)
     sourceModel = new ImageSourceModel(this);
     viewSourceModel = new PathViewProxyModel(sourceModel, this);
     qCDebug(logImageViewer) << "ImageSourceModel and PathViewProxyModel initialized.";
+    prewarmer = new ImagePrewarmer(sourceModel, this);
+    dirScanner = new ImageDirScanner(this);
+    connect(dirScanner, &ImageDirScanner::imageFilesFound, this, &GlobalControl::insertImageFiles);
+    // 扫描完成后，以当前图片为中心重新预加载，并按设置的排序方式重新排序
+    connect(dirScanner, &ImageDirScanner::scanFinished, this, [this]() {
+        prewarmer->reset(curIndex);
+        requestSort();
+    });
+
+    treeScanner = new ImageTreeScanner(this);
+    connect(treeScanner, &ImageTreeScanner::directoryFound, this, &GlobalControl::insertImageDirectory);
+    connect(treeScanner, &ImageTreeScanner::scanFinished, this, [this]() {
+        prewarmer->reset(curIndex);
+        requestSort();
+    });
+
+    sortKeyLoader = new ImageSortKeyLoader(this);
+    connect(sortKeyLoader, &ImageSortKeyLoader::keysReady, this, &GlobalControl::applySortKeys);
+    connect(sortKeyLoader, &ImageSortKeyLoader::filesReady, this, &GlobalControl::insertFilesBySortKeys);
+    const int order = LibConfigSetter::instance()->value(sc_SettingsGroup, sc_SortOrderKey, Types::SortByName).toInt();
+    imageSortOrder = qBound<int>(Types::SortByName, order, Types::SortByPixelCount);
 
     // 图片旋转完成后触发信息变更
     connect(RotateImageHelper::instance(), &RotateImageHelper::rotateImageFinished, this, [this](const QString &path, bool ret) {
@@ -326,20 +357,74 @@ bool GlobalControl::lastImage()
 void GlobalControl::forceExit()
 {
     qCDebug(logImageViewer) << "GlobalControl::forceExit() called, exiting application.";
+    // 直接退出进程不会触发 aboutToQuit ，需在此写入跟踪文件
+    if (TraceRecorder::isEnabled()) {
+        TraceRecorder::instance()->save();
+    }
     QApplication::exit(0);
     _Exit(0);
 }
 
+/**
+   @brief 设置图片排序方式为 \a order (Types::ImageSortOrder)，非文件名排序时在后台读取排序键，
+    读取完成前保持文件名顺序
+ */
+void GlobalControl::setSortOrder(int order)
+{
+    if (order < Types::SortByName || order > Types::SortByPixelCount || imageSortOrder == order) {
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Setting image sort order:" << order;
+    imageSortOrder = order;
+    LibConfigSetter::instance()->setValue(sc_SettingsGroup, sc_SortOrderKey, order);
+    Q_EMIT sortOrderChanged();
+
+    if (Types::SortByName == order) {
+        sortKeyLoader->cancel();
+        sourceModel->sortByName();
+        syncCurrentIndex();
+        prewarmer->reset(curIndex);
+    } else {
+        requestSort();
+    }
+}
+
+/**
+   @return 返回当前的图片排序方式
+ */
+int GlobalControl::sortOrder() const
+{
+    return imageSortOrder;
+}
+
 /**
    @brief 设置打开图片列表 \a filePaths ， 其中 \a openFile 是首个展示的图片路径，
     将更新全局数据源并发送状态变更信号
  */
 void GlobalControl::setImageFiles(const QStringList &filePaths, const QString &openFile)
 {
-    qCDebug(logImageViewer) << "Setting image files, count:" << filePaths.size() << "initial file:" << openFile;
+    applyImageFiles(filePaths, openFile, false);
+    requestSort();
+}
+
+/**
+   @brief 设置图片列表 \a filePaths 并展示 \a openFile ， \a explicitList 为 true 时表示列表为用户指定的
+    图片，不扫描及追加文件夹中的其它图片，并立即开始预加载列表中的图片
+ */
+void GlobalControl::applyImageFiles(const QStringList &filePaths, const QString &openFile, bool explicitList)
+{
+    qCDebug(logImageViewer) << "Setting image files, count:" << filePaths.size() << "initial file:" << openFile
+                            << "explicit:" << explicitList;
+    explicitSession = explicitList;
     Q_ASSERT(sourceModel);
+    // 取消未完成的文件夹扫描，以传入的列表为准
+    dirScanner->cancel();
+    treeScanner->cancel();
+    sortKeyLoader->clear();
     // 优先更新数据源
-    sourceModel->setImageFiles(QUrl::fromStringList(filePaths));
+    // 指定的图片列表保持传入的顺序，而非文件名顺序
+    sourceModel->setImageFiles(filePaths, explicitList);
     qCDebug(logImageViewer) << "Source model image files set.";
 
     int index = filePaths.indexOf(openFile);
@@ -364,9 +449,223 @@ void GlobalControl::setImageFiles(const QStringList &filePaths, const QString &o
 
     // 更新视图展示模型
     viewSourceModel->resetModel(index, 0);
+    // 首张图片展示后，空闲时在后台预加载其它图片信息，指定的图片列表通常较少，立即预加载
+    prewarmer->reset(index, explicitList);
     qCDebug(logImageViewer) << "Image files set complete";
 }
 
+/**
+   @brief 设置打开的图片 \a openFile 并立即展示，在后台扫描图片所在的文件夹，
+    扫描到的图片按文件名顺序分批次追加，并通过 imageFilesAppended() 通知
+ */
+void GlobalControl::loadImageDirectory(const QString &openFile)
+{
+    qCDebug(logImageViewer) << "Loading image directory asynchronously, initial file:" << openFile;
+    // 扫描完成后再排序
+    applyImageFiles({ openFile }, openFile, false);
+    dirScanner->start(openFile);
+}
+
+/**
+   @brief 递归浏览文件夹 \a rootDir (本地路径)及其子文件夹中的图片，存在打开的图片 \a openFile 时立即展示，
+    并优先扫描其所在的文件夹。扫描到的图片按文件夹分组追加，无打开的图片时，首个找到的图片
+    通过 treeFirstImageFound() 通知
+ */
+void GlobalControl::loadImageTree(const QString &rootDir, const QString &openFile)
+{
+    qCDebug(logImageViewer) << "Loading image tree asynchronously, root:" << rootDir << "initial file:" << openFile;
+    if (openFile.isEmpty()) {
+        applyImageFiles({}, QString(), false);
+    } else {
+        applyImageFiles({ openFile }, openFile, false);
+    }
+
+    const QString rootPath = QDir(rootDir).absolutePath();
+    sourceModel->setTreeRoot(rootPath);
+    const QString priorityDir = openFile.isEmpty() ? QString() : QFileInfo(QUrl(openFile).toLocalFile()).absolutePath();
+    treeScanner->start(rootPath, priorityDir);
+}
+
+/**
+   @brief 合并递归浏览时扫描到的文件夹 \a dirPath 中已排序的图片 \a sortedNames ，更新当前图片的索引
+ */
+void GlobalControl::insertImageDirectory(const QString &dirPath, const QStringList &sortedNames)
+{
+    qCDebug(logImageViewer) << "Inserting image directory:" << dirPath << "count:" << sortedNames.size();
+    const bool wasEmpty = 0 == sourceModel->rowCount();
+    sourceModel->insertDirectory(dirPath, sortedNames);
+
+    if (wasEmpty) {
+        // 未指定打开的图片，展示首个找到的图片
+        const QUrl firstFile = sourceModel->data(sourceModel->index(0), Types::ImageUrlRole).toUrl();
+        setIndexAndFrameIndex(0, 0);
+        currentImage.setSource(firstFile);
+        Q_EMIT currentSourceChanged();
+        viewSourceModel->resetModel(0, 0);
+        checkSwitchEnable();
+        Q_EMIT imageCountChanged();
+        Q_EMIT treeFirstImageFound();
+        return;
+    }
+
+    syncCurrentIndex();
+    Q_EMIT imageCountChanged();
+}
+
+/**
+   @brief 打开指定的图片列表 \a imageFiles 并展示其中的 \a openFile ，用于命令行或 DBus 传入多个文件，
+    直接构造数据模型，无需扫描所在文件夹
+ */
+void GlobalControl::openImageFiles(const QStringList &imageFiles, const QString &openFile)
+{
+    qCDebug(logImageViewer) << "Opening explicit image files, count:" << imageFiles.size() << "initial file:" << openFile;
+    applyImageFiles(imageFiles, imageFiles.contains(openFile) ? openFile : imageFiles.value(0), true);
+    requestSort();
+}
+
+/**
+   @brief 合并异步扫描或文件夹新增的已排序图片列表 \a sortedFiles ，更新当前图片的索引
+   @note 指定的图片列表不追加文件夹中新增的图片。已按其它方式排序时，先读取新增图片的排序键，
+    再由 insertFilesBySortKeys() 插入至当前顺序中对应的位置，不恢复文件名顺序及重新排序整个列表
+ */
+void GlobalControl::insertImageFiles(const QStringList &sortedFiles)
+{
+    if (explicitSession) {
+        qCDebug(logImageViewer) << "Explicit image list, ignore inserted files:" << sortedFiles.size();
+        return;
+    }
+
+    if (Types::SortByName != imageSortOrder && !sourceModel->isNameOrder()) {
+        QList<QUrl> urls;
+        urls.reserve(sortedFiles.size());
+        for (const QString &file : sortedFiles) {
+            urls.append(QUrl(file));
+        }
+        sortKeyLoader->loadFiles(urls, imageSortOrder);
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Inserting sorted image files, count:" << sortedFiles.size();
+    sourceModel->insertImageFiles(sortedFiles);
+
+    // 插入的图片可能位于当前图片之前，当前图片不变，仅更新索引
+    syncCurrentIndex();
+    Q_EMIT imageCountChanged();
+    Q_EMIT imageFilesAppended(sortedFiles);
+
+    // 文件夹扫描中追加的图片在扫描完成后统一排序
+    if (!dirScanner->isScanning() && !treeScanner->isScanning()) {
+        requestSort();
+    }
+}
+
+/**
+   @brief 新增图片 \a files 按排序方式 \a order 的排序键读取完成，逐个插入至当前顺序中对应的位置
+ */
+void GlobalControl::insertFilesBySortKeys(const QList<QUrl> &files, int order)
+{
+    if (explicitSession) {
+        return;
+    }
+
+    QStringList filePaths;
+    std::vector<qint64> values;
+    filePaths.reserve(files.size());
+    values.reserve(static_cast<size_t>(files.size()));
+    for (const QUrl &url : files) {
+        qint64 value = 0;
+        sortKeyLoader->sortValue(url, order, value);
+        filePaths.append(url.toString());
+        values.push_back(value);
+    }
+
+    // 读取期间排序方式已变更，按文件名合并后由 insertImageFiles() 处理排序
+    if (order != imageSortOrder || sourceModel->isNameOrder()) {
+        insertImageFiles(filePaths);
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Inserting image files by sort keys, count:" << filePaths.size();
+    sourceModel->insertImageFilesByValues(filePaths, values);
+    syncCurrentIndex();
+    Q_EMIT imageCountChanged();
+    Q_EMIT imageFilesAppended(filePaths);
+}
+
+/**
+   @brief 图片文件 \a filePath (本地路径)变更后，清除缓存的排序键，图片仍在列表中且按其它方式排序时重新排序
+ */
+void GlobalControl::invalidateSortKey(const QString &filePath)
+{
+    const QUrl url = QUrl::fromLocalFile(filePath);
+    sortKeyLoader->invalidate(url);
+    // 文件移动或删除时由移除流程处理
+    if (QFileInfo::exists(filePath) && -1 != sourceModel->indexForImagePath(url)) {
+        requestSort();
+    }
+}
+
+/**
+   @brief 数据模型变更顺序后，当前图片不变，更新当前图片的索引及两侧的图片
+ */
+void GlobalControl::syncCurrentIndex()
+{
+    int index = sourceModel->indexForImagePath(currentImage.source());
+    if (-1 != index && index != curIndex) {
+        curIndex = index;
+        Q_EMIT currentIndexChanged();
+    }
+    viewSourceModel->updateSourceIndex(curIndex);
+
+    checkSwitchEnable();
+}
+
+/**
+   @brief 非文件名排序时，在后台读取当前图片列表的排序键，读取完成后通过 applySortKeys() 重新排序
+ */
+void GlobalControl::requestSort()
+{
+    if (Types::SortByName == imageSortOrder || dirScanner->isScanning() || treeScanner->isScanning()) {
+        return;
+    }
+
+    if (sourceModel->rowCount() < 2) {
+        sortKeyLoader->cancel();
+        return;
+    }
+
+    sortKeyLoader->start(sourceModel->imageFiles(), imageSortOrder);
+}
+
+/**
+   @brief 排序方式 \a order 的排序键读取完成，按排序键一次性重新排列数据模型
+ */
+void GlobalControl::applySortKeys(int order)
+{
+    if (order != imageSortOrder) {
+        return;
+    }
+
+    TraceSpan span("sort", "apply");
+    const QList<QUrl> files = sourceModel->imageFiles();
+    std::vector<qint64> values;
+    values.reserve(static_cast<size_t>(files.size()));
+    for (const QUrl &url : files) {
+        qint64 value = 0;
+        if (!sortKeyLoader->sortValue(url, order, value)) {
+            // 读取期间图片列表发生变更(如重命名)，重新读取缺失的排序键
+            qCDebug(logImageViewer) << "Sort key missing, reload:" << url;
+            requestSort();
+            return;
+        }
+        values.push_back(value);
+    }
+
+    sourceModel->sortByValues(values);
+    syncCurrentIndex();
+    prewarmer->reset(curIndex);
+}
+
 /**
    @brief 移除当前图片列表中文件路径为 \a removeImage 的图片，更新当前图片索引
  */
@@ -446,10 +745,15 @@ void GlobalControl::renameImage(const QUrl &oldName, const QUrl &newName)
             currentImage.setSource(newName);
             currentImage.reloadData();
 
+            // 按文件名排序时重命名的图片可能移动位置
+            syncCurrentIndex();
             setIndexAndFrameIndex(curIndex, 0);
             Q_EMIT currentSourceChanged();
             Q_EMIT currentIndexChanged();
             qCDebug(logImageViewer) << "Emitted currentSourceChanged and currentIndexChanged signals.";
+        } else {
+            // 重命名的图片移动位置后，当前图片的索引可能变化
+            syncCurrentIndex();
         }
     } else {
         qCDebug(logImageViewer) << "Image not found in model for rename";
@@ -508,6 +812,14 @@ void GlobalControl::timerEvent(QTimerEvent *event)
     }
 }
 
+/**
+   @brief 设置是否暂停后台预加载 \a paused
+ */
+void GlobalControl::setPrewarmPaused(bool paused)
+{
+    prewarmer->setPaused(paused);
+}
+
 /**
    @brief 根据当前展示图片索引判断是否允许切换前后图片
  */
@@ -539,6 +851,11 @@ void GlobalControl::checkSwitchEnable()
 void GlobalControl::setIndexAndFrameIndex(int index, int frameIndex)
 {
     qCDebug(logImageViewer) << "Setting index:" << index << "frame index:" << frameIndex;
+    // 记录切换耗时，包含同步触发的视图更新及图片请求
+    const QString navigation = TraceRecorder::isEnabled()
+                                       ? QString("%1:%2 -> %3:%4").arg(curIndex).arg(curFrameIndex).arg(index).arg(frameIndex)
+                                       : QString();
+    TraceSpan span("navigation", "navigate", navigation);
     int validIndex = qBound(0, index, imageCount() - 1);
     if (this->curIndex != validIndex) {
         qCDebug(logImageViewer) << "Current index changed from " << this->curIndex << " to " << validIndex << ", submitting image change.";
@@ -554,6 +871,9 @@ void GlobalControl::setIndexAndFrameIndex(int index, int frameIndex)
         this->curIndex = index;
         Q_EMIT currentIndexChanged();
         qCDebug(logImageViewer) << "Emitted currentIndexChanged signal.";
+
+        // 切换图片时暂停预加载，让出线程
+        prewarmer->notifyNavigation(validIndex);
     }
 
     int validFrameIndex = qBound(0, frameIndex, qMax(0, currentImage.frameCount() - 1));
@@ -14,6 +14,10 @@
 #include <QUrl>
 #include <QBasicTimer>
 
+class ImagePrewarmer;
+class ImageDirScanner;
+class ImageTreeScanner;
+class ImageSortKeyLoader;
 class GlobalControl : public QObject
 {
     Q_OBJECT
@@ -26,6 +30,7 @@ class GlobalControl : public QObject
     Q_PROPERTY(int currentRotation READ currentRotation WRITE setCurrentRotation NOTIFY currentRotationChanged)
     Q_PROPERTY(bool hasPreviousImage READ hasPreviousImage NOTIFY hasPreviousImageChanged)
     Q_PROPERTY(bool hasNextImage READ hasNextImage NOTIFY hasNextImageChanged)
+    Q_PROPERTY(int sortOrder READ sortOrder WRITE setSortOrder NOTIFY sortOrderChanged)
 
 public:
     explicit GlobalControl(QObject *parent = nullptr);
@@ -71,12 +76,30 @@ public:
     Q_INVOKABLE bool lastImage();
     Q_INVOKABLE void forceExit();
 
+    // 图片排序方式 Types::ImageSortOrder
+    void setSortOrder(int order);
+    int sortOrder() const;
+    Q_SIGNAL void sortOrderChanged();
+
     // 图像文件变更操作
     Q_SLOT void setImageFiles(const QStringList &imageFiles, const QString &openFile);
+    // 立即展示图片 openFile ，异步扫描所在文件夹并分批追加其它图片
+    Q_INVOKABLE void loadImageDirectory(const QString &openFile);
+    // 递归浏览文件夹 rootDir 及其子文件夹中的图片，按文件夹分组追加
+    Q_INVOKABLE void loadImageTree(const QString &rootDir, const QString &openFile);
+    Q_SIGNAL void treeFirstImageFound();
+    // 打开指定的图片列表，不扫描所在文件夹，文件夹中新增的图片不追加
+    Q_INVOKABLE void openImageFiles(const QStringList &imageFiles, const QString &openFile);
+    Q_SLOT void insertImageFiles(const QStringList &sortedFiles);
+    Q_SIGNAL void imageFilesAppended(const QStringList &imageFiles);
     Q_SLOT void removeImage(const QUrl &removeImage);
     Q_SLOT void renameImage(const QUrl &oldName, const QUrl &newName);
+    // 图片文件变更后清除缓存的排序键
+    Q_SLOT void invalidateSortKey(const QString &filePath);
 
     Q_SLOT void submitImageChangeImmediately();
+    // 暂停后台预加载，用于视图滑动、动画等期间
+    Q_SLOT void setPrewarmPaused(bool paused);
     Q_SIGNAL void requestRotateImage(const QString &localPath, int rotation);
 
     // 判断当前设备是否支持多线程处理
@@ -87,6 +110,12 @@ protected:
 
 private:
     void checkSwitchEnable();
+    void applyImageFiles(const QStringList &filePaths, const QString &openFile, bool explicitList);
+    void insertImageDirectory(const QString &dirPath, const QStringList &sortedNames);
+    void syncCurrentIndex();
+    void requestSort();
+    void applySortKeys(int order);
+    void insertFilesBySortKeys(const QList<QUrl> &files, int order);
 
 private:
     int curIndex = 0;
@@ -95,8 +124,14 @@ private:
 
     ImageSourceModel *sourceModel { nullptr };
     PathViewProxyModel *viewSourceModel { nullptr };
+    ImagePrewarmer *prewarmer { nullptr };
+    ImageDirScanner *dirScanner { nullptr };
+    ImageTreeScanner *treeScanner { nullptr };
+    ImageSortKeyLoader *sortKeyLoader { nullptr };
+    int imageSortOrder = Types::SortByName;
     bool hasPrevious = false;
     bool hasNext = false;
+    bool explicitSession = false;  // 是否为指定的图片列表，而非图片所在的文件夹
 
     int imageRotation = 0;    // 当前图片旋转角度
     QBasicTimer submitTimer;  // 图片变更提交定时器
@@ -171,6 +171,28 @@ void GlobalStatus::setViewFlicking(bool value)
     }
 }
 
+/**
+   @return 返回缩略图栏是否处于快速轻弹状态
+ */
+bool GlobalStatus::thumbnailFlicking() const
+{
+    qCDebug(logImageViewer) << "GlobalStatus::thumbnailFlicking() called, returning: " << storethumbnailFlicking;
+    return storethumbnailFlicking;
+}
+
+/**
+   @brief 设置缩略图栏是否处于快速轻弹状态，轻弹速度超过阈值时设置，用于暂缓缩略图加载
+ */
+void GlobalStatus::setThumbnailFlicking(bool value)
+{
+    qCDebug(logImageViewer) << "GlobalStatus::setThumbnailFlicking() called with value: " << value;
+    if (value != storethumbnailFlicking) {
+        storethumbnailFlicking = value;
+        Q_EMIT thumbnailFlickingChanged();
+        qCDebug(logImageViewer) << "thumbnailFlicking changed to: " << storethumbnailFlicking << ", emitting thumbnailFlickingChanged.";
+    }
+}
+
 /**
    @return 返回当前是否允许标题栏、底栏动画效果
  */
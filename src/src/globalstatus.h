@@ -65,6 +65,12 @@ public:
     void setViewFlicking(bool value);
     Q_SIGNAL void viewFlickingChanged();
 
+    // 缩略图栏是否处于快速轻弹状态 (ThumbnailListView)
+    Q_PROPERTY(bool thumbnailFlicking READ thumbnailFlicking WRITE setThumbnailFlicking NOTIFY thumbnailFlickingChanged)
+    bool thumbnailFlicking() const;
+    void setThumbnailFlicking(bool value);
+    Q_SIGNAL void thumbnailFlickingChanged();
+
     // 屏蔽标题栏/底部栏动画效果
     Q_PROPERTY(bool animationBlock READ animationBlock WRITE setAnimationBlock NOTIFY animationBlockChanged)
     bool animationBlock() const;
@@ -117,6 +123,7 @@ private:
     bool storeshowImageInfo = false;
     bool storeviewInteractive = true;
     bool storeviewFlicking = false;
+    bool storethumbnailFlicking = false;
     bool storeanimationBlock = false;
     bool storefullScreenAnimating = false;
     int storethumbnailVaildWidth = 0;
@@ -0,0 +1,314 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagedirscanner.h"
+#include "imagenamecollator.h"
+#include "unionimage/imageformatregistry.h"
+#include "utils/tracerecorder.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QUrl>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static const int sc_NearbyCount = 100;    // 优先发送打开图片前后的图片数量，用于立即切换上/下一张
+static const int sc_ChunkSize = 2000;     // 其余图片每批次发送的数量
+static const int sc_VerifyBatchSize = 64; // 每个任务校验文件内容的文件数量
+
+/**
+   @brief 遍历文件夹并按后缀分类文件的任务，后缀无法识别的文件交由 VerifyImageRunnable 校验文件内容
+ */
+class ScanDirRunnable : public QRunnable
+{
+public:
+    ScanDirRunnable(ImageDirScanner *scanner, int generation, const QString &openFile)
+        : scanner(scanner)
+        , generation(generation)
+        , openFile(openFile)
+    {
+    }
+
+    void run() override;
+
+private:
+    void postRange(const QDir &dir, const QStringList &fileNames, int begin, int end);
+
+    ImageDirScanner *scanner;
+    int generation;
+    QString openFile;
+};
+
+/**
+   @brief 校验后缀未注册的文件内容是否为图片的任务
+ */
+class VerifyImageRunnable : public QRunnable
+{
+public:
+    VerifyImageRunnable(ImageDirScanner *scanner, int generation, const QDir &dir, const QStringList &fileNames)
+        : scanner(scanner)
+        , generation(generation)
+        , dir(dir)
+        , fileNames(fileNames)
+    {
+    }
+
+    void run() override;
+
+private:
+    ImageDirScanner *scanner;
+    int generation;
+    QDir dir;
+    QStringList fileNames;
+};
+
+void ScanDirRunnable::run()
+{
+    const QFileInfo openInfo(openFile);
+    const QDir dir = openInfo.absoluteDir();
+    const QString openName = openInfo.fileName();
+    qCDebug(logImageViewer) << "Scanning image directory:" << dir.path();
+    TraceSpan listSpan("directory", "list", dir.path());
+
+    // 仅读取目录项，按后缀分类，不打开文件
+    QStringList imageNames;
+    QStringList unknownNames;
+    QDirIterator itr(dir.path(), QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
+    while (itr.hasNext()) {
+        itr.next();
+        if (scanner->isCanceled(generation)) {
+            qCDebug(logImageViewer) << "Directory scan canceled:" << dir.path();
+            scanner->postTaskFinished(generation, 0);
+            return;
+        }
+
+        const QString fileName = itr.fileName();
+        if (fileName == openName) {
+            continue;
+        }
+
+        const ImageFormatRegistry::Format *format = ImageFormatRegistry::findForPath(fileName);
+        if (format && format->readableBySuffix()) {
+            imageNames.append(fileName);
+        } else {
+            unknownNames.append(fileName);
+        }
+    }
+
+    listSpan.finish();
+    TraceSpan sortSpan("directory", "sort", dir.path());
+    const std::vector<QCollatorSortKey> keys = ImageNameCollator::sort(imageNames);
+    sortSpan.finish();
+    qCDebug(logImageViewer) << "Directory listed:" << dir.path() << "images:" << imageNames.size() << "unknown:" << unknownNames.size();
+
+    // 优先发送打开图片附近的图片，其次向后、向前分批发送
+    const QCollatorSortKey openKey = ImageNameCollator().sortKey(openName);
+    int openPos = 0;
+    int upper = imageNames.size();
+    while (openPos < upper) {
+        const int mid = (openPos + upper) / 2;
+        if (ImageNameCollator::lessThan(keys[static_cast<size_t>(mid)], imageNames.at(mid), openKey, openName)) {
+            openPos = mid + 1;
+        } else {
+            upper = mid;
+        }
+    }
+    const int nearbyBegin = qMax(0, openPos - sc_NearbyCount);
+    const int nearbyEnd = qMin(imageNames.size(), openPos + sc_NearbyCount);
+    postRange(dir, imageNames, nearbyBegin, nearbyEnd);
+    for (int begin = nearbyEnd; begin < imageNames.size(); begin += sc_ChunkSize) {
+        postRange(dir, imageNames, begin, qMin(imageNames.size(), begin + sc_ChunkSize));
+    }
+    for (int end = nearbyBegin; end > 0; end -= sc_ChunkSize) {
+        postRange(dir, imageNames, qMax(0, end - sc_ChunkSize), end);
+    }
+
+    // 先提交任务计数再启动校验任务，保证完成通知的顺序
+    QList<VerifyImageRunnable *> verifyTasks;
+    for (int i = 0; i < unknownNames.size(); i += sc_VerifyBatchSize) {
+        verifyTasks.append(new VerifyImageRunnable(scanner, generation, dir, unknownNames.mid(i, sc_VerifyBatchSize)));
+    }
+    scanner->postTaskFinished(generation, verifyTasks.size());
+    for (VerifyImageRunnable *task : verifyTasks) {
+        scanner->localPoolPtr->start(task);
+    }
+}
+
+/**
+   @brief 发送已排序的文件名列表 \a fileNames 中 [ \a begin , \a end ) 区间的图片
+ */
+void ScanDirRunnable::postRange(const QDir &dir, const QStringList &fileNames, int begin, int end)
+{
+    if (begin >= end || scanner->isCanceled(generation)) {
+        return;
+    }
+
+    QStringList files;
+    files.reserve(end - begin);
+    for (int i = begin; i < end; ++i) {
+        files.append(QUrl::fromLocalFile(dir.filePath(fileNames.at(i))).toString());
+    }
+    scanner->postFound(generation, files);
+}
+
+void VerifyImageRunnable::run()
+{
+    TraceSpan span("directory", "verify", dir.path());
+    QStringList imageNames;
+    for (const QString &fileName : fileNames) {
+        if (scanner->isCanceled(generation)) {
+            break;
+        }
+        if (ImageDirScanner::checkImageContent(dir.filePath(fileName))) {
+            imageNames.append(fileName);
+        }
+    }
+
+    if (!imageNames.isEmpty() && !scanner->isCanceled(generation)) {
+        ImageNameCollator::sort(imageNames);
+
+        QStringList files;
+        files.reserve(imageNames.size());
+        for (const QString &fileName : imageNames) {
+            files.append(QUrl::fromLocalFile(dir.filePath(fileName)).toString());
+        }
+        scanner->postFound(generation, files);
+    }
+
+    scanner->postTaskFinished(generation, 0);
+}
+
+/**
+   @class ImageDirScanner
+   @brief 异步扫描图片所在文件夹，在后台线程遍历目录并按后缀识别图片，
+        排序后分批次通过 imageFilesFound() 发送，打开的图片无需等待扫描完成即可展示。
+   @note 后缀未注册的文件延后在后台校验文件内容。每批次的文件均已排序，
+        但批次之间不保证顺序，接收方需按 ImageNameCollator 的顺序合并。
+ */
+
+ImageDirScanner::ImageDirScanner(QObject *parent)
+    : QObject(parent)
+    , localPoolPtr(new QThreadPool)
+{
+    localPoolPtr->setMaxThreadCount(2);
+}
+
+ImageDirScanner::~ImageDirScanner()
+{
+    cancel();
+    localPoolPtr->waitForDone();
+}
+
+/**
+   @brief 扫描图片文件 \a openFile (url路径) 所在的文件夹，结果不包含 \a openFile ，
+    将取消之前未完成的扫描
+ */
+void ImageDirScanner::start(const QString &openFile)
+{
+    cancel();
+
+    const QString localPath = QUrl(openFile).toLocalFile();
+    if (localPath.isEmpty()) {
+        qCWarning(logImageViewer) << "Invalid image path for directory scan:" << openFile;
+        return;
+    }
+
+    runningTasks = 1;
+    localPoolPtr->start(new ScanDirRunnable(this, currentGeneration.loadAcquire(), localPath));
+}
+
+/**
+   @brief 取消当前的扫描，后台任务将尽快退出，已发送的结果将被丢弃
+ */
+void ImageDirScanner::cancel()
+{
+    currentGeneration.ref();
+    runningTasks = 0;
+}
+
+/**
+   @return 是否存在未完成的扫描
+ */
+bool ImageDirScanner::isScanning() const
+{
+    return runningTasks > 0;
+}
+
+/**
+   @return 文件 \a path 是否为支持的图片，优先通过后缀判断，无法识别时读取文件头
+ */
+bool ImageDirScanner::isImageFile(const QString &path)
+{
+    const ImageFormatRegistry::Format *format = ImageFormatRegistry::findForPath(path);
+    if (format && format->readableBySuffix()) {
+        return true;
+    }
+    return checkImageContent(path);
+}
+
+/**
+   @return 后缀未注册或需校验内容的文件 \a path 是否为图片，通过文件头识别，均无法识别时由图片插件判断
+   @threadsafe
+ */
+bool ImageDirScanner::checkImageContent(const QString &path)
+{
+    if (ImageFormatRegistry::formatForFamily(ImageFormatRegistry::sniffFile(path))) {
+        return true;
+    }
+
+    const ImageFormatRegistry::Format *format = ImageFormatRegistry::findForPath(path);
+    if (format && format->has(ImageFormatRegistry::ContentCheck)) {
+        // 后缀不足以确定为图片，由图片插件读取文件头判断
+        return QImageReader(path).canRead();
+    }
+
+    static const QList<QByteArray> s_pluginFormats = QImageReader::supportedImageFormats();
+    return s_pluginFormats.contains(QFileInfo(path).suffix().toLower().toLatin1());
+}
+
+bool ImageDirScanner::isCanceled(int generation) const
+{
+    return generation != currentGeneration.loadAcquire();
+}
+
+/**
+   @brief 后台任务发送找到的图片，在主线程过滤已过期的扫描结果
+ */
+void ImageDirScanner::postFound(int generation, const QStringList &sortedFiles)
+{
+    QMetaObject::invokeMethod(
+            this,
+            [this, generation, sortedFiles]() {
+                if (!isCanceled(generation)) {
+                    Q_EMIT imageFilesFound(sortedFiles);
+                }
+            },
+            Qt::QueuedConnection);
+}
+
+/**
+   @brief 后台任务完成，并追加 \a newTasks 个新任务，所有任务完成后发送 scanFinished()
+ */
+void ImageDirScanner::postTaskFinished(int generation, int newTasks)
+{
+    QMetaObject::invokeMethod(
+            this,
+            [this, generation, newTasks]() {
+                if (isCanceled(generation)) {
+                    return;
+                }
+
+                runningTasks += newTasks - 1;
+                if (0 == runningTasks) {
+                    qCDebug(logImageViewer) << "Image directory scan finished.";
+                    Q_EMIT scanFinished();
+                }
+            },
+            Qt::QueuedConnection);
+}
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEDIRSCANNER_H
+#define IMAGEDIRSCANNER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QScopedPointer>
+
+class QThreadPool;
+
+class ImageDirScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageDirScanner(QObject *parent = nullptr);
+    ~ImageDirScanner() override;
+
+    void start(const QString &openFile);
+    void cancel();
+    bool isScanning() const;
+
+    static bool isImageFile(const QString &path);
+    static bool checkImageContent(const QString &path);
+
+    // 找到的已排序的图片文件(url路径)，分批次发送
+    Q_SIGNAL void imageFilesFound(const QStringList &sortedFiles);
+    Q_SIGNAL void scanFinished();
+
+private:
+    friend class ScanDirRunnable;
+    friend class VerifyImageRunnable;
+
+    bool isCanceled(int generation) const;
+    void postFound(int generation, const QStringList &sortedFiles);
+    void postTaskFinished(int generation, int newTasks);
+
+private:
+    QAtomicInt currentGeneration { 0 };   ///< 扫描代数，重新扫描或取消时递增，丢弃过期的结果
+    int runningTasks { 0 };               ///< 当前扫描未完成的任务数
+    QScopedPointer<QThreadPool> localPoolPtr;
+
+    Q_DISABLE_COPY(ImageDirScanner)
+};
+
+#endif  // IMAGEDIRSCANNER_H
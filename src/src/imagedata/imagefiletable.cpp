@@ -0,0 +1,498 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagefiletable.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+
+static const int sc_MinCompactSize = 1 << 20;   // 无效文件名超过此长度且超过一半时整理 namePool
+static const size_t sc_BlockSize = 1024;                   // 分块的目标条目数
+static const size_t sc_MaxBlockSize = sc_BlockSize * 2;    // 分块超过此条目数时拆分
+static const size_t sc_MinBlockSize = sc_BlockSize / 4;    // 分块少于此条目数时尝试与后一分块合并
+
+/**
+   @class ImageFileTable
+   @brief 紧凑存储的图片文件列表，由文件夹路径表及连续存储的文件名组成，
+        每个文件仅占用 16 字节的条目及文件名本身，不保存完整路径或 QUrl 。
+   @note 用于存储数十万张图片的递归文件夹，完整路径及 QUrl 在访问时生成。
+        移除或替换的文件名在 namePool 中保留，无效部分较多时统一整理。
+        条目按行顺序分块存储(每块约 sc_BlockSize 个)，按行号访问时二分查找所在分块；
+        插入或移除条目仅移动所在分块内的条目并更新各分块的首行，开销与分块大小及分块数量相关，与总行数无关。
+        按路径查找通过文件夹及文件名的哈希值定位条目的 slot ，再由 slotPositions 取得所在分块及位置。
+ */
+
+int ImageFileTable::size() const
+{
+    return count;
+}
+
+bool ImageFileTable::isEmpty() const
+{
+    return 0 == count;
+}
+
+void ImageFileTable::clear()
+{
+    count = 0;
+    blocks.clear();
+    blocks.shrink_to_fit();
+    blockOrder.clear();
+    freeBlocks.clear();
+    directories.clear();
+    dirIds.clear();
+    namePool.clear();
+    namePool.squeeze();
+    garbageSize = 0;
+    pathSlots.clear();
+    slotPositions.clear();
+    slotPositions.shrink_to_fit();
+    freeSlots.clear();
+}
+
+void ImageFileTable::reserve(int count)
+{
+    blocks.reserve(static_cast<size_t>(count) / sc_BlockSize + 1);
+    blockOrder.reserve(static_cast<size_t>(count) / sc_BlockSize + 1);
+    slotPositions.reserve(static_cast<size_t>(count));
+    pathSlots.reserve(count);
+}
+
+/**
+   @return 返回文件夹 \a dirPath 的索引，不存在时添加
+ */
+quint32 ImageFileTable::addDirectory(const QString &dirPath)
+{
+    auto itr = dirIds.constFind(dirPath);
+    if (itr != dirIds.constEnd()) {
+        return itr.value();
+    }
+
+    const quint32 dirId = static_cast<quint32>(directories.size());
+    directories.append(dirPath);
+    dirIds.insert(dirPath, dirId);
+    return dirId;
+}
+
+/**
+   @return 返回文件夹 \a dirPath 的索引，不存在时返回 UINT_MAX
+ */
+quint32 ImageFileTable::findDirectory(const QString &dirPath) const
+{
+    return dirIds.value(dirPath, UINT_MAX);
+}
+
+QString ImageFileTable::directory(quint32 dirId) const
+{
+    return directories.value(static_cast<int>(dirId));
+}
+
+int ImageFileTable::directoryCount() const
+{
+    return directories.size();
+}
+
+quint32 ImageFileTable::directoryId(int row) const
+{
+    return entryAt(row).dirId;
+}
+
+/**
+   @return 返回第 \a row 行条目的 slot ，条目移动时不变，移除后由新条目复用
+ */
+quint32 ImageFileTable::slot(int row) const
+{
+    return entryAt(row).slot;
+}
+
+/**
+   @return 返回已分配的 slot 数量，所有 slot 均小于此值
+ */
+int ImageFileTable::slotCount() const
+{
+    return static_cast<int>(slotPositions.size());
+}
+
+/**
+   @return 返回第 \a row 行的文件名，不分配内存，仅在数据变更前有效
+ */
+QStringView ImageFileTable::fileNameView(int row) const
+{
+    const Entry &entry = entryAt(row);
+    return QStringView(namePool).mid(entry.nameOffset, entry.nameLength);
+}
+
+QString ImageFileTable::fileName(int row) const
+{
+    return fileNameView(row).toString();
+}
+
+/**
+   @return 返回第 \a row 行的完整文件路径
+ */
+QString ImageFileTable::filePath(int row) const
+{
+    const Entry &entry = entryAt(row);
+    const QString &dirPath = directories.at(static_cast<int>(entry.dirId));
+    const QStringView name = QStringView(namePool).mid(entry.nameOffset, entry.nameLength);
+
+    QString path;
+    path.reserve(dirPath.size() + 1 + name.size());
+    path.append(dirPath);
+    if (!dirPath.endsWith('/')) {
+        path.append('/');
+    }
+    path.append(name.data(), name.size());
+    return path;
+}
+
+QUrl ImageFileTable::url(int row) const
+{
+    return QUrl::fromLocalFile(filePath(row));
+}
+
+/**
+   @return 返回文件路径 \a filePath 所在的行，无此文件时返回 -1
+ */
+int ImageFileTable::indexOf(const QString &filePath) const
+{
+    QString dirPath;
+    QString name;
+    splitPath(filePath, dirPath, name);
+
+    const quint32 dirId = findDirectory(dirPath);
+    if (UINT_MAX == dirId) {
+        return -1;
+    }
+
+    const uint hash = pathHash(dirId, name);
+    for (auto itr = pathSlots.constFind(hash); itr != pathSlots.constEnd() && itr.key() == hash; ++itr) {
+        const SlotPosition &pos = slotPositions[itr.value()];
+        const Block &block = blocks[pos.block];
+        const Entry &entry = block.entries[pos.offset];
+        if (entry.dirId == dirId && QStringView(namePool).mid(entry.nameOffset, entry.nameLength) == name) {
+            return block.begin + static_cast<int>(pos.offset);
+        }
+    }
+    return -1;
+}
+
+/**
+   @brief 在末尾追加文件夹 \a dirId 中的文件 \a fileName
+ */
+void ImageFileTable::append(quint32 dirId, const QString &fileName)
+{
+    if (blockOrder.empty() || blocks[blockOrder.back()].entries.size() >= sc_BlockSize) {
+        const quint32 blockId = newBlock();
+        blocks[blockId].begin = count;
+        blockOrder.push_back(blockId);
+    }
+
+    const quint32 blockId = blockOrder.back();
+    Block &block = blocks[blockId];
+    block.entries.push_back(makeEntry(dirId, fileName));
+    slotPositions[block.entries.back().slot] = { blockId, static_cast<quint32>(block.entries.size() - 1) };
+    ++count;
+}
+
+/**
+   @brief 在第 \a row 行之前插入文件夹 \a dirId 中的文件 \a fileNames 的 [ \a begin , \a end ) 区间
+ */
+void ImageFileTable::insert(int row, quint32 dirId, const QStringList &fileNames, int begin, int end)
+{
+    if (row >= count) {
+        for (int i = begin; i < end; ++i) {
+            append(dirId, fileNames.at(i));
+        }
+        return;
+    }
+
+    std::vector<Entry> inserted;
+    inserted.reserve(static_cast<size_t>(end - begin));
+    for (int i = begin; i < end; ++i) {
+        inserted.push_back(makeEntry(dirId, fileNames.at(i)));
+    }
+
+    // 插入至所在分块，过大时拆分，之后的分块仅更新首行
+    const int orderPos = locate(row);
+    const quint32 blockId = blockOrder[static_cast<size_t>(orderPos)];
+    Block &block = blocks[blockId];
+    const size_t offset = static_cast<size_t>(row - block.begin);
+    block.entries.insert(block.entries.begin() + static_cast<std::ptrdiff_t>(offset), inserted.begin(), inserted.end());
+    updatePositions(blockId, offset);
+    count += static_cast<int>(inserted.size());
+
+    splitBlock(orderPos);
+    updateBegins(orderPos + 1);
+}
+
+/**
+   @brief 将第 \a row 行替换为文件路径 \a filePath ，用于重命名
+ */
+void ImageFileTable::replace(int row, const QString &filePath)
+{
+    QString dirPath;
+    QString name;
+    splitPath(filePath, dirPath, name);
+    const quint32 dirId = addDirectory(dirPath);
+
+    const quint32 blockId = blockOrder[static_cast<size_t>(locate(row))];
+    Block &block = blocks[blockId];
+    const quint32 offset = static_cast<quint32>(row - block.begin);
+    Entry &entry = block.entries[offset];
+    releaseEntry(entry);
+    entry = makeEntry(dirId, name);
+    slotPositions[entry.slot] = { blockId, offset };
+    compactPool();
+}
+
+void ImageFileTable::removeAt(int row)
+{
+    const int orderPos = locate(row);
+    const quint32 blockId = blockOrder[static_cast<size_t>(orderPos)];
+    Block &block = blocks[blockId];
+    const size_t offset = static_cast<size_t>(row - block.begin);
+    releaseEntry(block.entries[offset]);
+    block.entries.erase(block.entries.begin() + static_cast<std::ptrdiff_t>(offset));
+    --count;
+
+    if (block.entries.empty()) {
+        removeBlock(orderPos);
+        updateBegins(orderPos);
+    } else {
+        updatePositions(blockId, offset);
+
+        // 过小的分块与后一分块合并，避免频繁删除后分块数量过多
+        const size_t nextPos = static_cast<size_t>(orderPos) + 1;
+        if (block.entries.size() < sc_MinBlockSize && nextPos < blockOrder.size()) {
+            Block &next = blocks[blockOrder[nextPos]];
+            if (block.entries.size() + next.entries.size() <= sc_BlockSize) {
+                const size_t oldSize = block.entries.size();
+                block.entries.insert(block.entries.end(), next.entries.begin(), next.entries.end());
+                updatePositions(blockId, oldSize);
+                removeBlock(static_cast<int>(nextPos));
+            }
+        }
+        updateBegins(orderPos + 1);
+    }
+    compactPool();
+}
+
+/**
+   @brief 按 \a order 重新排列条目， \a order[i] 为新的第 i 行在原数据中的行号
+ */
+void ImageFileTable::reorder(const std::vector<int> &order)
+{
+    std::vector<Entry> flat;
+    flat.reserve(static_cast<size_t>(count));
+    for (quint32 blockId : blockOrder) {
+        const std::vector<Entry> &entries = blocks[blockId].entries;
+        flat.insert(flat.end(), entries.begin(), entries.end());
+    }
+
+    // 按新的顺序重新分块
+    blocks.clear();
+    blockOrder.clear();
+    freeBlocks.clear();
+    for (size_t row = 0; row < order.size(); ++row) {
+        if (0 == row % sc_BlockSize) {
+            const quint32 blockId = newBlock();
+            blocks[blockId].begin = static_cast<int>(row);
+            blocks[blockId].entries.reserve(std::min(sc_BlockSize, order.size() - row));
+            blockOrder.push_back(blockId);
+        }
+
+        const quint32 blockId = blockOrder.back();
+        std::vector<Entry> &entries = blocks[blockId].entries;
+        entries.push_back(flat[static_cast<size_t>(order[row])]);
+        slotPositions[entries.back().slot] = { blockId, static_cast<quint32>(entries.size() - 1) };
+    }
+}
+
+/**
+   @brief 将文件路径 \a filePath 拆分为文件夹路径 \a dirPath 及文件名 \a fileName
+ */
+void ImageFileTable::splitPath(const QString &filePath, QString &dirPath, QString &fileName)
+{
+    const int slash = filePath.lastIndexOf('/');
+    if (slash < 0) {
+        dirPath.clear();
+        fileName = filePath;
+        return;
+    }
+
+    // 根目录保留 '/'
+    dirPath = filePath.left(qMax(1, slash));
+    fileName = filePath.mid(slash + 1);
+}
+
+/**
+   @return 返回第 \a row 行所在分块在 blockOrder 中的位置
+ */
+int ImageFileTable::locate(int row) const
+{
+    // 二分查找首行不大于 row 的最后一个分块，分块均不为空
+    int lower = 0;
+    int upper = static_cast<int>(blockOrder.size()) - 1;
+    while (lower < upper) {
+        const int mid = (lower + upper + 1) / 2;
+        if (blocks[blockOrder[static_cast<size_t>(mid)]].begin <= row) {
+            lower = mid;
+        } else {
+            upper = mid - 1;
+        }
+    }
+    return lower;
+}
+
+const ImageFileTable::Entry &ImageFileTable::entryAt(int row) const
+{
+    const Block &block = blocks[blockOrder[static_cast<size_t>(locate(row))]];
+    return block.entries[static_cast<size_t>(row - block.begin)];
+}
+
+/**
+   @return 返回新的空分块的索引，优先复用已移除的分块
+ */
+quint32 ImageFileTable::newBlock()
+{
+    if (!freeBlocks.empty()) {
+        const quint32 blockId = freeBlocks.back();
+        freeBlocks.pop_back();
+        return blockId;
+    }
+
+    blocks.emplace_back();
+    return static_cast<quint32>(blocks.size() - 1);
+}
+
+/**
+   @brief 更新分块 \a blockId 中第 \a begin 个及之后条目的位置
+ */
+void ImageFileTable::updatePositions(quint32 blockId, size_t begin)
+{
+    const std::vector<Entry> &entries = blocks[blockId].entries;
+    for (size_t i = begin; i < entries.size(); ++i) {
+        slotPositions[entries[i].slot] = { blockId, static_cast<quint32>(i) };
+    }
+}
+
+/**
+   @brief 由前一分块计算 blockOrder 中 \a orderPos 及之后分块的首行
+ */
+void ImageFileTable::updateBegins(int orderPos)
+{
+    int row = 0;
+    if (orderPos > 0) {
+        const Block &prev = blocks[blockOrder[static_cast<size_t>(orderPos) - 1]];
+        row = prev.begin + static_cast<int>(prev.entries.size());
+    }
+
+    for (size_t pos = static_cast<size_t>(orderPos); pos < blockOrder.size(); ++pos) {
+        Block &block = blocks[blockOrder[pos]];
+        block.begin = row;
+        row += static_cast<int>(block.entries.size());
+    }
+}
+
+/**
+   @brief 将 blockOrder 中 \a orderPos 位置过大的分块拆分为多个 sc_BlockSize 大小的分块，首行由调用方更新
+ */
+void ImageFileTable::splitBlock(int orderPos)
+{
+    const quint32 blockId = blockOrder[static_cast<size_t>(orderPos)];
+    if (blocks[blockId].entries.size() <= sc_MaxBlockSize) {
+        return;
+    }
+
+    std::vector<quint32> newIds;
+    size_t pos = sc_BlockSize;
+    while (pos < blocks[blockId].entries.size()) {
+        // newBlock() 可能重新分配 blocks ，不持有分块的引用
+        const quint32 newId = newBlock();
+        const std::vector<Entry> &source = blocks[blockId].entries;
+        const size_t end = std::min(pos + sc_BlockSize, source.size());
+        blocks[newId].entries.assign(source.begin() + static_cast<std::ptrdiff_t>(pos), source.begin() + static_cast<std::ptrdiff_t>(end));
+        updatePositions(newId, 0);
+        newIds.push_back(newId);
+        pos = end;
+    }
+
+    blocks[blockId].entries.resize(sc_BlockSize);
+    blocks[blockId].entries.shrink_to_fit();
+    blockOrder.insert(blockOrder.begin() + orderPos + 1, newIds.begin(), newIds.end());
+}
+
+/**
+   @brief 从 blockOrder 中移除 \a orderPos 位置的分块并回收，首行由调用方更新
+ */
+void ImageFileTable::removeBlock(int orderPos)
+{
+    const quint32 blockId = blockOrder[static_cast<size_t>(orderPos)];
+    std::vector<Entry>().swap(blocks[blockId].entries);
+    freeBlocks.push_back(blockId);
+    blockOrder.erase(blockOrder.begin() + orderPos);
+}
+
+ImageFileTable::Entry ImageFileTable::makeEntry(quint32 dirId, const QString &fileName)
+{
+    Entry entry;
+    entry.dirId = dirId;
+    entry.nameOffset = static_cast<quint32>(namePool.size());
+    entry.nameLength = static_cast<quint32>(fileName.size());
+    namePool.append(fileName);
+
+    // 优先复用已移除条目的 slot ，位置由调用方设置
+    if (freeSlots.empty()) {
+        entry.slot = static_cast<quint32>(slotPositions.size());
+        slotPositions.push_back(SlotPosition());
+    } else {
+        entry.slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    pathSlots.insert(pathHash(dirId, fileName), entry.slot);
+    return entry;
+}
+
+/**
+   @brief 移除条目 \a entry 的路径索引并回收 slot ，文件名在 namePool 中标记为无效
+ */
+void ImageFileTable::releaseEntry(const Entry &entry)
+{
+    const QStringView name = QStringView(namePool).mid(entry.nameOffset, entry.nameLength);
+    pathSlots.remove(pathHash(entry.dirId, name), entry.slot);
+    freeSlots.push_back(entry.slot);
+    garbageSize += static_cast<int>(entry.nameLength);
+}
+
+/**
+   @brief 无效的文件名较多时，按条目顺序重新存储文件名
+ */
+void ImageFileTable::compactPool()
+{
+    if (garbageSize < sc_MinCompactSize || garbageSize < namePool.size() / 2) {
+        return;
+    }
+
+    QString pool;
+    pool.reserve(namePool.size() - garbageSize);
+    for (quint32 blockId : blockOrder) {
+        for (Entry &entry : blocks[blockId].entries) {
+            const quint32 offset = static_cast<quint32>(pool.size());
+            pool.append(namePool.constData() + entry.nameOffset, static_cast<int>(entry.nameLength));
+            entry.nameOffset = offset;
+        }
+    }
+    namePool.swap(pool);
+    garbageSize = 0;
+}
+
+/**
+   @return 返回文件夹 \a dirId 中文件 \a fileName 的哈希值
+ */
+uint ImageFileTable::pathHash(quint32 dirId, QStringView fileName)
+{
+    return static_cast<uint>(qHash(fileName, dirId));
+}
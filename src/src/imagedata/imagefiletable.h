@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEFILETABLE_H
+#define IMAGEFILETABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QHash>
+#include <QMultiHash>
+#include <QUrl>
+
+#include <vector>
+
+class ImageFileTable
+{
+public:
+    int size() const;
+    bool isEmpty() const;
+    void clear();
+    void reserve(int count);
+
+    quint32 addDirectory(const QString &dirPath);
+    quint32 findDirectory(const QString &dirPath) const;
+    QString directory(quint32 dirId) const;
+    int directoryCount() const;
+
+    quint32 directoryId(int row) const;
+    quint32 slot(int row) const;
+    int slotCount() const;
+    QStringView fileNameView(int row) const;
+    QString fileName(int row) const;
+    QString filePath(int row) const;
+    QUrl url(int row) const;
+    int indexOf(const QString &filePath) const;
+
+    void append(quint32 dirId, const QString &fileName);
+    void insert(int row, quint32 dirId, const QStringList &fileNames, int begin, int end);
+    void replace(int row, const QString &filePath);
+    void removeAt(int row);
+    void reorder(const std::vector<int> &order);
+
+    static void splitPath(const QString &filePath, QString &dirPath, QString &fileName);
+
+private:
+    /**
+       @brief 图片文件条目，文件名保存在 namePool 中
+     */
+    struct Entry
+    {
+        quint32 dirId = 0;       ///< 所在文件夹在 directories 中的索引
+        quint32 nameOffset = 0;  ///< 文件名在 namePool 中的起始位置
+        quint32 nameLength = 0;  ///< 文件名长度
+        quint32 slot = 0;        ///< 在 slotPositions 中的位置，条目移动时不变
+    };
+
+    /**
+       @brief 连续存储的一段条目，插入或移除条目时仅移动所在分块内的条目
+     */
+    struct Block
+    {
+        std::vector<Entry> entries;
+        int begin = 0;           ///< 首个条目的行号
+    };
+
+    /**
+       @brief 条目所在的分块及在分块中的位置
+     */
+    struct SlotPosition
+    {
+        quint32 block = 0;       ///< 分块在 blocks 中的索引，分块增删时不变
+        quint32 offset = 0;
+    };
+
+    int locate(int row) const;
+    const Entry &entryAt(int row) const;
+    quint32 newBlock();
+    void updatePositions(quint32 blockId, size_t begin);
+    void updateBegins(int orderPos);
+    void splitBlock(int orderPos);
+    void removeBlock(int orderPos);
+
+    Entry makeEntry(quint32 dirId, const QString &fileName);
+    void releaseEntry(const Entry &entry);
+    void compactPool();
+    static uint pathHash(quint32 dirId, QStringView fileName);
+
+private:
+    int count { 0 };                   ///< 条目总数
+    std::vector<Block> blocks;         ///< 分块，已移除的分块在 freeBlocks 中复用
+    std::vector<quint32> blockOrder;   ///< 按行顺序排列的分块索引
+    std::vector<quint32> freeBlocks;
+    QStringList directories;           ///< 文件夹路径表
+    QHash<QString, quint32> dirIds;    ///< 文件夹路径到索引的映射
+    QString namePool;                  ///< 连续存储的文件名
+    int garbageSize { 0 };             ///< namePool 中已移除或替换的文件名长度
+
+    QMultiHash<uint, quint32> pathSlots;         ///< 文件夹及文件名的哈希值到 slot 的映射，用于按路径查找
+    std::vector<SlotPosition> slotPositions;   ///< slot 对应条目的位置，行号由所在分块的首行计算
+    std::vector<quint32> freeSlots;              ///< 已移除条目的 slot ，供新条目复用
+};
+
+#endif  // IMAGEFILETABLE_H
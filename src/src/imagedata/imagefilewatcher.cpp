@@ -3,7 +3,10 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "imagefilewatcher.h"
+#include "imagedirscanner.h"
 #include "imageinfo.h"
+#include "imagenamecollator.h"
+#include "unionimage/imageformatregistry.h"
 
 #include <QDir>
 #include <QFileInfo>
@@ -100,6 +103,28 @@ void ImageFileWatcher::resetImageFiles(const QStringList &filePaths)
     }
 }
 
+/**
+   @brief 追加监控文件列表 \a filePaths ，文件需位于当前监控的文件夹中，用于异步扫描文件夹时分批追加
+ */
+void ImageFileWatcher::appendImageFiles(const QStringList &filePaths)
+{
+    qCDebug(logImageViewer) << "ImageFileWatcher::appendImageFiles() called with filePaths count: " << filePaths.count();
+    QStringList localPaths;
+    localPaths.reserve(filePaths.size());
+    for (const QString &filePath : filePaths) {
+        const QString tempPath = QUrl(filePath).toLocalFile();
+        if (!cacheFileInfo.contains(tempPath)) {
+            cacheFileInfo.insert(tempPath, filePath);
+            localPaths.append(tempPath);
+        }
+    }
+
+    // 文件由扫描得到，无需再次判断是否存在
+    if (!localPaths.isEmpty()) {
+        fileWatcher->addPaths(localPaths);
+    }
+}
+
 /**
    @brief 监控的文件 \a oldPath 重命名为 \a newPath 更新监控列表
  */
@@ -205,7 +230,7 @@ void ImageFileWatcher::onImageDirChanged(const QString &dir)
     qCDebug(logImageViewer) << "ImageFileWatcher::onImageDirChanged() called for directory:" << dir;
     // 文件夹变更，判断是否存在新增已移除的文件
     QDir imageDir(dir);
-    QStringList dirFiles = imageDir.entryList();
+    QStringList dirFiles = imageDir.entryList(QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
     qCDebug(logImageViewer) << "Files in directory: " << dirFiles.count();
 
     for (auto itr = removedFile.begin(); itr != removedFile.end();) {
@@ -226,5 +251,33 @@ void ImageFileWatcher::onImageDirChanged(const QString &dir)
             ++itr;
         }
     }
+
+    // 新增的图片文件，除少量需校验内容的后缀外仅通过后缀判断，避免文件夹频繁变更时读取文件内容
+    QStringList addedNames;
+    for (const QString &fileName : dirFiles) {
+        const QString filePath = imageDir.absoluteFilePath(fileName);
+        if (cacheFileInfo.contains(filePath) || removedFile.contains(filePath)) {
+            continue;
+        }
+
+        const ImageFormatRegistry::Format *format = ImageFormatRegistry::findForPath(fileName);
+        if (format && format->readableBySuffix()) {
+            addedNames.append(fileName);
+        } else if (format && format->has(ImageFormatRegistry::ContentCheck) && ImageDirScanner::checkImageContent(filePath)) {
+            addedNames.append(fileName);
+        }
+    }
+
+    if (!addedNames.isEmpty()) {
+        qCInfo(logImageViewer) << "New image files detected in directory:" << dir << "count:" << addedNames.size();
+        // 排序后由数据模型二分查找插入位置，无需重新排序整个文件夹
+        ImageNameCollator::sort(addedNames);
+        QStringList addedFiles;
+        addedFiles.reserve(addedNames.size());
+        for (const QString &fileName : addedNames) {
+            addedFiles.append(QUrl::fromLocalFile(imageDir.absoluteFilePath(fileName)).toString());
+        }
+        Q_EMIT imageFilesAdded(addedFiles);
+    }
     qCDebug(logImageViewer) << "Directory change processing complete.";
 }
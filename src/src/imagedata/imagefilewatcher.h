@@ -17,11 +17,14 @@ public:
     static ImageFileWatcher *instance();
 
     void resetImageFiles(const QStringList &filePaths);
+    void appendImageFiles(const QStringList &filePaths);
     void fileRename(const QString &oldPath, const QString &newPath);
     bool isCurrentDir(const QString &filePath);
 
     // 文件变更通知信号
     Q_SIGNAL void imageFileChanged(const QString &imagePath);
+    // 监控的文件夹中新增图片文件(url路径)，已按文件名排序
+    Q_SIGNAL void imageFilesAdded(const QStringList &sortedFiles);
 
     // internal 用于异步处理图片旋转状态
     Q_SLOT void recordRotateImage(const QString &targetPath);
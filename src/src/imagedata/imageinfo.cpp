@@ -5,10 +5,18 @@
 #include "imageinfo.h"
 #include "types.h"
 #include "thumbnailcache.h"
+#include "thumbnailpackstore.h"
+#include "imageinfoindex.h"
+#include "imagesubscribers.h"
 #include "unionimage/unionimage.h"
+#include "unionimage/imageutils.h"
+#include "unionimage/decoderpool.h"
+#include "unionimage/imageframescanner.h"
+#include "unionimage/imageheaderreader.h"
 #include "globalcontrol.h"
 
 #include <QSet>
+#include <QMap>
 #include <QSize>
 #include <QFile>
 #include <QImageReader>
@@ -19,6 +27,11 @@
 
 Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
 
+static const int sc_MaxInfoCacheCost = 16 * 1024 * 1024;  // 图片信息缓存的内存上限 16MB ，约 5 万张图片
+static const int sc_InfoEntryOverhead = 160;              // 单个缓存条目除路径外的估算开销(数据、哈希节点及 LRU 索引)
+static const int sc_MaxBatchSize = 16;                    // 单个线程任务批量处理的最大图片数
+static const int sc_ReservedUrgentThreads = 1;            // 保留给紧急任务的线程数，批量任务不占用
+
 class ImageInfoData
 {
 public:
@@ -41,6 +54,14 @@ public:
         return other;
     }
 
+    /**
+       @return 返回缓存此数据估算占用的内存字节数
+     */
+    inline int cost() const
+    {
+        return sc_InfoEntryOverhead + static_cast<int>(sizeof(ImageInfoData)) + path.size() * static_cast<int>(sizeof(QChar));
+    }
+
     inline bool isError() const
     {
         qCDebug(logImageViewer) << "ImageInfoData::isError called";
@@ -62,16 +83,33 @@ public:
     qreal y = 0;   ///< 相对坐标Y轴偏移
 };
 
+/**
+   @brief 图片信息加载任务及加载结果
+ */
+struct LoadImageInfoItem
+{
+    QString path;
+    int frameIndex = 0;
+    bool cacheThumbnail = true;   ///< 是否将缩略图保存至内存缓存，预加载时仅写入磁盘缓存
+    ImageInfoData::Ptr data;
+};
+
 class LoadImageInfoRunnable : public QRunnable
 {
 public:
-    explicit LoadImageInfoRunnable(const QString &path, int index = 0);
+    explicit LoadImageInfoRunnable(const QList<LoadImageInfoItem> &items);
     void run() override;
+    void loadCurrent();
     bool loadImage(QImage &image, QSize &sourceSize) const;
-    void notifyFinished(const QString &path, int frameIndex, ImageInfoData::Ptr data) const;
+    bool loadFromIndex(ImageInfoData::Ptr data) const;
+    void notifyFinished(const QString &path, int frameIndex, ImageInfoData::Ptr data);
 
 private:
+    QList<LoadImageInfoItem> items;   ///< 批量处理的任务，处理完成后一次性通知
+    int current = 0;                  ///< 当前处理的任务索引
+    QImageReader reader;              ///< 批量任务间复用的读取器
     int frameIndex = 0;
+    bool cacheThumbnail = true;
     QString loadPath;
 };
 
@@ -79,30 +117,73 @@ class ImageInfoCache : public QObject
 {
     Q_OBJECT
 public:
-    typedef QPair<QString, int> KeyType;
+    typedef ImageKey KeyType;
 
     ImageInfoCache();
     ~ImageInfoCache() override;
 
     ImageInfoData::Ptr find(const QString &path, int frameIndex);
-    void load(const QString &path, int frameIndex, bool reload = false);
-    void loadFinished(const QString &path, int frameIndex, ImageInfoData::Ptr data);
+    void load(const QString &path, int frameIndex, bool reload = false, int priority = 0, bool cacheThumbnail = true);
+    void cancel(const QString &path, int frameIndex);
+    void updatePriority(const QString &path, int frameIndex, int priority);
+    void setDeferred(bool deferred);
+    void loadFinished(const QList<LoadImageInfoItem> &items);
     void removeCache(const QString &path, int frameIndex);
     void clearCache();
 
-    Q_SIGNAL void imageDataChanged(const QString &path, int frameIndex);
-    Q_SIGNAL void imageSizeChanged(const QString &path, int frameIndex);
+    void subscribe(const KeyType &key, ImageInfo *info);
+    void unsubscribe(const KeyType &key, ImageInfo *info);
+    void notifyDataChanged(const KeyType &key);
+    void notifySizeChanged(const KeyType &key);
+
+private:
+    // 排序依据：优先级(距离视图中心的距离)，相同优先级按请求先后
+    typedef QPair<int, quint64> OrderType;
+    struct PendingTask
+    {
+        QString path;
+        int frameIndex = 0;
+        int requests = 0;   ///< 请求此任务的 ImageInfo 计数，为 0 时取消任务
+        bool cacheThumbnail = true;
+        OrderType order;
+    };
+
+    // 缓存条目，按最近访问顺序淘汰
+    struct CacheEntry
+    {
+        ImageInfoData::Ptr data;
+        int cost = 0;
+        quint64 lastUse = 0;
+    };
+
+    void enqueue(const KeyType &key, const QString &path, int frameIndex, int priority, bool cacheThumbnail);
+    void reorder(PendingTask &task, int priority);
+    void dispatch();
+
+    void insertEntry(const KeyType &key, const ImageInfoData::Ptr &data);
+    void removeEntry(const KeyType &key);
+    void touchEntry(CacheEntry &entry, const KeyType &key);
+    void trimEntries();
 
 private:
     bool aboutToQuit { false };
-    QHash<KeyType, ImageInfoData::Ptr> cache;
+    bool deferred { false };   ///< 暂缓启动非紧急的加载任务
+    int runningCount { 0 };
+    quint64 requestCounter { 0 };
+    quint64 useCounter { 0 };    ///< 访问计数，用于 LRU 淘汰
+    int totalCost { 0 };         ///< 缓存条目估算占用的内存
+    QHash<KeyType, CacheEntry> cache;
+    QMap<quint64, KeyType> lruQueue;   ///< 按访问先后排序的缓存 key ，首部为最久未访问的条目
     QSet<KeyType> waitSet;
+    QHash<KeyType, PendingTask> pendingTasks;
+    QMap<OrderType, KeyType> pendingQueue;
+    ImageSubscribers<ImageInfo> subscribers;   ///< 按 key 记录的 ImageInfo ，仅通知对应的订阅者
     QScopedPointer<QThreadPool> localPoolPtr;
 };
 Q_GLOBAL_STATIC(ImageInfoCache, CacheInstance)
 
-LoadImageInfoRunnable::LoadImageInfoRunnable(const QString &path, int index)
-    : frameIndex(index), loadPath(path)
+LoadImageInfoRunnable::LoadImageInfoRunnable(const QList<LoadImageInfoItem> &items)
+    : items(items)
 {
 }
 
@@ -132,16 +213,37 @@ Types::ImageType imageTypeAdapator(imageViewerSpace::ImageType type)
 }
 
 /**
-   @brief 在线程中读取及构造图片信息，包含图片路径、类型、大小等，并读取图片内容创建缩略图。
+   @brief 在线程中依次处理批量任务，处理完成后一次性通知缓存管理，
+    减少逐个任务投递线程池及返回GUI线程的开销
  */
 void LoadImageInfoRunnable::run()
 {
-    qCDebug(logImageViewer) << "LoadImageInfoRunnable::run() entered for path:" << loadPath << ", frameIndex:" << frameIndex;
-    if (qApp->closingDown()) {
-        qCDebug(logImageViewer) << "Application is closing down, LoadImageInfoRunnable exiting.";
-        return;
+    qCDebug(logImageViewer) << "LoadImageInfoRunnable::run() entered, tasks:" << items.size();
+    for (current = 0; current < items.size(); ++current) {
+        if (qApp->closingDown()) {
+            qCDebug(logImageViewer) << "Application is closing down, LoadImageInfoRunnable exiting.";
+            return;
+        }
+
+        const LoadImageInfoItem &item = items.at(current);
+        loadPath = item.path;
+        frameIndex = item.frameIndex;
+        cacheThumbnail = item.cacheThumbnail;
+        loadCurrent();
     }
 
+    const QList<LoadImageInfoItem> results = items;
+    QMetaObject::invokeMethod(
+            CacheInstance(), [results]() { CacheInstance()->loadFinished(results); }, Qt::QueuedConnection);
+    qCDebug(logImageViewer) << "Invoked CacheInstance()->loadFinished in queued connection.";
+}
+
+/**
+   @brief 读取及构造当前任务的图片信息，包含图片路径、类型、大小等，并读取图片内容创建缩略图。
+ */
+void LoadImageInfoRunnable::loadCurrent()
+{
+    qCDebug(logImageViewer) << "LoadImageInfoRunnable::loadCurrent() entered for path:" << loadPath << ", frameIndex:" << frameIndex;
     ImageInfoData::Ptr data(new ImageInfoData);
     data->path = loadPath;
     data->exist = QFileInfo::exists(loadPath);
@@ -155,6 +257,12 @@ void LoadImageInfoRunnable::run()
         return;
     }
 
+    // 优先使用持久化索引中的图片信息，文件未变更时无需探测格式及解码
+    if (loadFromIndex(data)) {
+        notifyFinished(data->path, frameIndex, data);
+        return;
+    }
+
     imageViewerSpace::ImageType type = LibUnionImage_NameSpace::getImageType(loadPath);
     data->type = imageTypeAdapator(type);
     qCDebug(logImageViewer) << "Image type adapted to:" << data->type;
@@ -165,27 +273,43 @@ void LoadImageInfoRunnable::run()
         return;
     }
 
-    QImageReader reader(loadPath);
     if (Types::MultiImage == data->type) {
-        qCDebug(logImageViewer) << "Image is multi-image type. Jumping to image frame:" << frameIndex;
-        reader.jumpToImage(frameIndex);
-        QImage image = reader.read();
-        if (image.isNull()) {
-            // 数据获取异常
-            data->type = Types::DamagedImage;
-            qCWarning(logImageViewer) << "Failed to read multi-image frame" << frameIndex << ", setting type to DamagedImage.";
-            notifyFinished(data->path, frameIndex, data);
-            return;
+        // 优先读取文件结构获取帧数及帧大小，仅在需要缩略图时解码当前帧
+        ImageFrameScanner::FrameInfo frames;
+        const bool scanned = ImageFrameScanner::scan(loadPath, frames) && frameIndex < frames.frameCount;
+        if (scanned) {
+            data->size = frames.frameSizes.at(frameIndex);
+            data->frameCount = frames.frameCount;
+            qCDebug(logImageViewer) << "Multi-image scanned without decoding. Size:" << data->size << ", frame count:" << data->frameCount;
         }
 
-        data->size = image.size();
-        data->frameCount = reader.imageCount();
-        qCDebug(logImageViewer) << "Multi-image size:" << data->size << ", frame count:" << data->frameCount;
-        // 保存图片比例缩放
-        image = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-        // 缓存缩略图信息
-        ThumbnailCache::instance()->add(data->path, frameIndex, image);
-        qCDebug(logImageViewer) << "Thumbnail added to cache for multi-image.";
+        if (!scanned || cacheThumbnail) {
+            qCDebug(logImageViewer) << "Image is multi-image type. Jumping to image frame:" << frameIndex;
+            reader.setFileName(loadPath);
+            reader.jumpToImage(frameIndex);
+            QImage image = reader.read();
+            if (image.isNull()) {
+                // 数据获取异常
+                data->type = Types::DamagedImage;
+                qCWarning(logImageViewer) << "Failed to read multi-image frame" << frameIndex << ", setting type to DamagedImage.";
+                notifyFinished(data->path, frameIndex, data);
+                return;
+            }
+
+            if (!scanned) {
+                data->size = image.size();
+                data->frameCount = reader.imageCount();
+                qCDebug(logImageViewer) << "Multi-image size:" << data->size << ", frame count:" << data->frameCount;
+            }
+
+            // 缓存缩略图信息
+            if (cacheThumbnail) {
+                // 保存图片比例缩放
+                image = ThumbnailCache::scaledThumbnail(image);
+                ThumbnailCache::instance()->add(data->path, frameIndex, image);
+                qCDebug(logImageViewer) << "Thumbnail added to cache for multi-image.";
+            }
+        }
 
     } else if (0 != frameIndex) {
         // 非多页图类型，但指定了索引，存在异常
@@ -199,8 +323,10 @@ void LoadImageInfoRunnable::run()
         if (loadImage(image, data->size)) {
             qCDebug(logImageViewer) << "Image loaded successfully. Size:" << data->size;
             // 缓存缩略图信息
-            ThumbnailCache::instance()->add(data->path, frameIndex, image);
-            qCDebug(logImageViewer) << "Thumbnail added to cache.";
+            if (cacheThumbnail) {
+                ThumbnailCache::instance()->add(data->path, frameIndex, image);
+                qCDebug(logImageViewer) << "Thumbnail added to cache.";
+            }
         } else {
             // 读取图片数据存在异常，调整图片类型
             data->type = Types::DamagedImage;
@@ -208,8 +334,48 @@ void LoadImageInfoRunnable::run()
         }
     }
 
+    // 记录探测结果，损坏的图片可能由解码超时等临时异常导致，不进行记录
+    if (Types::DamagedImage != data->type) {
+        ImageInfoIndex::Record record;
+        record.type = data->type;
+        record.size = data->size;
+        record.frameCount = data->frameCount;
+        // 同时记录拍摄时间，按拍摄时间排序时无需再次读取文件头
+        if (0 == frameIndex) {
+            record.captureTime = ImageHeaderReader::readCaptureTime(loadPath);
+        }
+        ImageInfoIndex::instance()->insert(loadPath, frameIndex, record);
+    }
+
     notifyFinished(data->path, frameIndex, data);
-    qCDebug(logImageViewer) << "LoadImageInfoRunnable::run() finished for path:" << loadPath;
+    qCDebug(logImageViewer) << "LoadImageInfoRunnable::loadCurrent() finished for path:" << loadPath;
+}
+
+/**
+   @brief 从持久化索引中读取图片信息至 \a data ，并尝试从打包缓存中读取缩略图
+   @return 索引中是否存在有效的记录
+ */
+bool LoadImageInfoRunnable::loadFromIndex(ImageInfoData::Ptr data) const
+{
+    ImageInfoIndex::Record record;
+    if (!ImageInfoIndex::instance()->find(loadPath, frameIndex, record)) {
+        return false;
+    }
+
+    data->type = static_cast<Types::ImageType>(record.type);
+    data->size = record.size;
+    data->frameCount = record.frameCount;
+    qCDebug(logImageViewer) << "Using indexed image info:" << loadPath << "type:" << data->type << "size:" << data->size;
+
+    // 打包缓存直接引用映射内存，未命中时由缩略图加载器按需读取
+    if (cacheThumbnail && 0 == frameIndex && !ThumbnailCache::instance()->contains(loadPath, frameIndex)) {
+        QImage image;
+        QSize sourceSize;
+        if (ThumbnailPackStore::find(loadPath, image, sourceSize)) {
+            ThumbnailCache::instance()->add(loadPath, frameIndex, ThumbnailCache::scaledThumbnail(image));
+        }
+    }
+    return true;
 }
 
 /**
@@ -221,12 +387,31 @@ void LoadImageInfoRunnable::run()
 bool LoadImageInfoRunnable::loadImage(QImage &image, QSize &sourceSize) const
 {
     qCDebug(logImageViewer) << "LoadImageInfoRunnable::loadImage() entered for path:" << loadPath;
+    // 优先使用目录打包缓存中的缩略图，直接引用映射内存，无需打开文件及解码
+    if (ThumbnailPackStore::find(loadPath, image, sourceSize) && sourceSize.isValid()) {
+        image = ThumbnailCache::scaledThumbnail(image);
+        qCDebug(logImageViewer) << "Using packed thumbnail. Source size:" << sourceSize;
+        return true;
+    }
+
+    // 其次使用磁盘中有效的缩略图，无需解码原图
+    image = Libutils::image::loadCachedThumbnail(loadPath, &sourceSize);
+    if (!image.isNull() && sourceSize.isValid()) {
+        ThumbnailPackStore::insert(loadPath, image, sourceSize);
+        image = ThumbnailCache::scaledThumbnail(image);
+        qCDebug(logImageViewer) << "Using disk cached thumbnail. Source size:" << sourceSize;
+        return true;
+    }
+
+    // 仅需缩略图，解码后缩小至 large 缩略图大小，启用解码辅助进程时减少传递的数据
     QString error;
-    bool ret = LibUnionImage_NameSpace::loadStaticImageFromFile(loadPath, image, error);
+    bool ret = DecoderPool::loadImage(loadPath, 0, QSize(256, 256), image, &sourceSize, error);
     if (ret) {
-        sourceSize = image.size();
+        // 写入目录打包缓存，并异步写入磁盘缩略图缓存，下次启动时复用
+        ThumbnailPackStore::insert(loadPath, image, sourceSize);
+        Libutils::image::saveCachedThumbnailAsync(loadPath, image, sourceSize);
         // 保存图片比例缩放
-        image = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        image = ThumbnailCache::scaledThumbnail(image);
         qCDebug(logImageViewer) << "Static image loaded successfully. Source size:" << sourceSize;
     } else {
         qCWarning(logImageViewer) << "Failed to load image:" << loadPath << "Error:" << error;
@@ -237,17 +422,15 @@ bool LoadImageInfoRunnable::loadImage(QImage &image, QSize &sourceSize) const
 }
 
 /**
-   @brief 提示缓存管理图像数据已加载完成
+   @brief 记录当前任务的图像数据已加载完成，批量任务全部完成后统一提示缓存管理
    @param path 图片文件路径
    @param frameIndex 多页图图片索引
    @param data 图像数据
  */
-void LoadImageInfoRunnable::notifyFinished(const QString &path, int frameIndex, ImageInfoData::Ptr data) const
+void LoadImageInfoRunnable::notifyFinished(const QString &path, int frameIndex, ImageInfoData::Ptr data)
 {
     qCDebug(logImageViewer) << "LoadImageInfoRunnable::notifyFinished() entered for path:" << path << ", frameIndex:" << frameIndex;
-    QMetaObject::invokeMethod(
-            CacheInstance(), [=]() { CacheInstance()->loadFinished(path, frameIndex, data); }, Qt::QueuedConnection);
-    qCDebug(logImageViewer) << "Invoked CacheInstance()->loadFinished in queued connection.";
+    items[current].data = data;
 }
 
 ImageInfoCache::ImageInfoCache()
@@ -281,24 +464,49 @@ ImageInfoData::Ptr ImageInfoCache::find(const QString &path, int frameIndex)
 {
     qCDebug(logImageViewer) << "ImageInfoCache::find() called for path:" << path << ", frameIndex:" << frameIndex;
     ThumbnailCache::Key key = ThumbnailCache::toFindKey(path, frameIndex);
-    return cache.value(key);
+    auto itr = cache.find(key);
+    if (itr == cache.end()) {
+        return ImageInfoData::Ptr();
+    }
+
+    touchEntry(itr.value(), key);
+    return itr->data;
 }
 
 /**
    @brief 加载文件路径 \a path 指向的帧索引为 \a frameIndex 的图像文件，
     \a reload 标识用于重新加载图片文件数据
+   @param priority 加载优先级，值越小越先加载，0 为紧急任务，不会被暂缓
+   @param cacheThumbnail 是否将缩略图保存至内存缓存，为 false 时仅写入图片信息和磁盘缩略图缓存
+   @note 任务不会直接投递到线程池，而是进入按优先级排序的等待队列，线程空闲时取队首任务执行，
+    以便滑动缩略图栏时，仍在视图中的图片优先加载，已离开视图的请求可以被取消
  */
-void ImageInfoCache::load(const QString &path, int frameIndex, bool reload)
+void ImageInfoCache::load(const QString &path, int frameIndex, bool reload, int priority, bool cacheThumbnail)
 {
-    qCDebug(logImageViewer) << "ImageInfoCache::load() called for path:" << path << ", frameIndex:" << frameIndex << ", reload:" << reload;
+    qCDebug(logImageViewer) << "ImageInfoCache::load() called for path:" << path << ", frameIndex:" << frameIndex << ", reload:" << reload
+                            << ", priority:" << priority;
     if (aboutToQuit) {
         qCDebug(logImageViewer) << "Skipping image load during application shutdown:" << path;
         return;
     }
 
     ThumbnailCache::Key key = ThumbnailCache::toFindKey(path, frameIndex);
+    if (!key.isValid()) {
+        // 路径驻留表已满，无法缓存加载结果
+        qCWarning(logImageViewer) << "No path id available, skip loading image:" << path;
+        return;
+    }
 
     if (waitSet.contains(key)) {
+        // 仍在等待队列中，增加请求计数并提升优先级
+        auto itr = pendingTasks.find(key);
+        if (itr != pendingTasks.end()) {
+            itr->requests++;
+            itr->cacheThumbnail |= cacheThumbnail;
+            if (priority < itr->order.first) {
+                reorder(itr.value(), priority);
+            }
+        }
         qCDebug(logImageViewer) << "Image already in loading queue:" << path << "frame:" << frameIndex;
         return;
     }
@@ -311,40 +519,187 @@ void ImageInfoCache::load(const QString &path, int frameIndex, bool reload)
     if (!GlobalControl::enableMultiThread()) {
         qCDebug(logImageViewer) << "Loading image synchronously:" << path << "frame:" << frameIndex;
         // 低于2逻辑线程，直接加载，防止部分平台出现卡死等情况
-        LoadImageInfoRunnable runnable(path, frameIndex);
+        runningCount++;
+        LoadImageInfoItem item;
+        item.path = path;
+        item.frameIndex = frameIndex;
+        item.cacheThumbnail = cacheThumbnail;
+        LoadImageInfoRunnable runnable({ item });
         runnable.run();
     } else {
-        qCDebug(logImageViewer) << "Loading image asynchronously:" << path << "frame:" << frameIndex;
-        LoadImageInfoRunnable *runnable = new LoadImageInfoRunnable(path, frameIndex);
+        qCDebug(logImageViewer) << "Queue image loading asynchronously:" << path << "frame:" << frameIndex;
+        enqueue(key, path, frameIndex, priority, cacheThumbnail);
+        dispatch();
+    }
+}
+
+/**
+   @brief 取消文件路径 \a path 第 \a frameIndex 帧的加载请求，
+    所有请求方均已取消且任务还未开始执行时，从等待队列中移除任务
+ */
+void ImageInfoCache::cancel(const QString &path, int frameIndex)
+{
+    ThumbnailCache::Key key = ThumbnailCache::toFindKey(path, frameIndex);
+    auto itr = pendingTasks.find(key);
+    if (itr == pendingTasks.end()) {
+        return;
+    }
+
+    if (--itr->requests > 0) {
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Cancel pending image loading:" << path << "frame:" << frameIndex;
+    pendingQueue.remove(itr->order);
+    pendingTasks.erase(itr);
+    waitSet.remove(key);
+}
+
+/**
+   @brief 调整文件路径 \a path 第 \a frameIndex 帧等待中的加载任务的优先级为 \a priority ，
+    存在多个请求方时，仅允许提升优先级
+ */
+void ImageInfoCache::updatePriority(const QString &path, int frameIndex, int priority)
+{
+    auto itr = pendingTasks.find(ThumbnailCache::toFindKey(path, frameIndex));
+    if (itr == pendingTasks.end() || itr->order.first == priority) {
+        return;
+    }
+
+    if (1 == itr->requests || priority < itr->order.first) {
+        reorder(itr.value(), priority);
+    }
+}
+
+/**
+   @brief 设置是否暂缓启动非紧急的加载任务 \a deferred ，用于视图快速滑动时，
+    避免为一闪而过的缩略图解码，恢复后按最新的优先级继续加载
+ */
+void ImageInfoCache::setDeferred(bool deferred)
+{
+    if (this->deferred != deferred) {
+        qCDebug(logImageViewer) << "ImageInfoCache deferred loading changed to:" << deferred;
+        this->deferred = deferred;
+        if (!deferred) {
+            dispatch();
+        }
+    }
+}
+
+/**
+   @brief 将任务添加到等待队列，优先级为 \a priority
+ */
+void ImageInfoCache::enqueue(const KeyType &key, const QString &path, int frameIndex, int priority, bool cacheThumbnail)
+{
+    PendingTask task;
+    task.path = path;
+    task.frameIndex = frameIndex;
+    task.requests = 1;
+    task.cacheThumbnail = cacheThumbnail;
+    task.order = qMakePair(priority, requestCounter++);
+
+    pendingQueue.insert(task.order, key);
+    pendingTasks.insert(key, task);
+}
+
+/**
+   @brief 调整等待任务 \a task 的优先级为 \a priority ，并更新在队列中的位置
+ */
+void ImageInfoCache::reorder(PendingTask &task, int priority)
+{
+    KeyType key = pendingQueue.take(task.order);
+    task.order = qMakePair(priority, requestCounter++);
+    pendingQueue.insert(task.order, key);
+}
+
+/**
+   @brief 在线程池存在空闲线程时，从等待队列中按优先级取出任务，分组后批量执行
+   @note 等待的任务平均分配至空闲线程，每组不超过 sc_MaxBatchSize 个；紧急任务单独执行，不等待其它任务。
+        批量任务不占用保留的线程，其它线程均在执行批量任务时，紧急任务在保留的线程上立即执行
+ */
+void ImageInfoCache::dispatch()
+{
+    const int maxThreadCount = localPoolPtr->maxThreadCount();
+    while (!pendingQueue.isEmpty()) {
+        const bool urgentFirst = (0 == pendingQueue.firstKey().first);
+        // 暂缓状态下仅执行紧急任务
+        if (deferred && !urgentFirst) {
+            break;
+        }
+
+        const int threadLimit = urgentFirst ? maxThreadCount : qMax(1, maxThreadCount - sc_ReservedUrgentThreads);
+        if (runningCount >= threadLimit) {
+            break;
+        }
+
+        const int idleCount = threadLimit - runningCount;
+        const int batchSize = qBound(1, (pendingQueue.size() + idleCount - 1) / idleCount, sc_MaxBatchSize);
+
+        QList<LoadImageInfoItem> items;
+        while (!pendingQueue.isEmpty() && items.size() < batchSize) {
+            auto first = pendingQueue.begin();
+            const bool urgent = (0 == first.key().first);
+            if (urgent && !items.isEmpty()) {
+                break;
+            }
+
+            KeyType key = first.value();
+            pendingQueue.erase(first);
+            PendingTask task = pendingTasks.take(key);
+
+            LoadImageInfoItem item;
+            item.path = task.path;
+            item.frameIndex = task.frameIndex;
+            item.cacheThumbnail = task.cacheThumbnail;
+            items.append(item);
+
+            if (urgent) {
+                break;
+            }
+        }
+
+        runningCount++;
+        LoadImageInfoRunnable *runnable = new LoadImageInfoRunnable(items);
         localPoolPtr->start(runnable, QThread::LowPriority);
     }
 }
 
 /**
-   @brief 图像信息加载完成，接收来自 LoadImageInfoRunnable 的完成信号，根据文件路径 \a path
-    和图像帧索引 \a frameIndex 区分加载的数据 \a data ，并保存至缓存中
+   @brief 图像信息批量加载完成，接收来自 LoadImageInfoRunnable 的完成通知，根据文件路径
+    和图像帧索引区分加载的数据，保存至缓存后通知对应的 ImageInfo
+   @note 先保存整组数据再统一通知，界面每组仅刷新一次
  */
-void ImageInfoCache::loadFinished(const QString &path, int frameIndex, ImageInfoData::Ptr data)
+void ImageInfoCache::loadFinished(const QList<LoadImageInfoItem> &items)
 {
-    qCDebug(logImageViewer) << "ImageInfoCache::loadFinished called for path:" << path << "frameIndex:" << frameIndex;
+    qCDebug(logImageViewer) << "ImageInfoCache::loadFinished called, items:" << items.size();
     if (aboutToQuit) {
-        qCDebug(logImageViewer) << "Skipping load finished during application shutdown:" << path;
+        qCDebug(logImageViewer) << "Skipping load finished during application shutdown.";
         return;
     }
 
-    ThumbnailCache::Key key = ThumbnailCache::toFindKey(path, frameIndex);
+    runningCount = qMax(0, runningCount - 1);
 
-    if (data && waitSet.contains(key)) {
-        cache.insert(key, data);
-        qCDebug(logImageViewer) << "Image loaded successfully:" << path << "frame:" << frameIndex
-                                << "type:" << data->type << "size:" << data->size;
-    } else {
-        qCWarning(logImageViewer) << "Failed to load image data:" << path << "frame:" << frameIndex;
+    QList<KeyType> keys;
+    keys.reserve(items.size());
+    for (const LoadImageInfoItem &item : items) {
+        ThumbnailCache::Key key = ThumbnailCache::toFindKey(item.path, item.frameIndex);
+        if (item.data && waitSet.contains(key)) {
+            insertEntry(key, item.data);
+            qCDebug(logImageViewer) << "Image loaded successfully:" << item.path << "frame:" << item.frameIndex
+                                    << "type:" << item.data->type << "size:" << item.data->size;
+        } else {
+            qCWarning(logImageViewer) << "Failed to load image data:" << item.path << "frame:" << item.frameIndex;
+        }
+        waitSet.remove(key);
+        keys.append(key);
+    }
+
+    for (const KeyType &key : keys) {
+        notifyDataChanged(key);
     }
-    waitSet.remove(key);
 
-    Q_EMIT imageDataChanged(path, frameIndex);
-    qCDebug(logImageViewer) << "Emitted imageDataChanged signal.";
+    // 线程空闲，继续执行等待队列中的任务
+    dispatch();
 }
 
 /**
@@ -353,11 +708,12 @@ void ImageInfoCache::loadFinished(const QString &path, int frameIndex, ImageInfo
 void ImageInfoCache::removeCache(const QString &path, int frameIndex)
 {
     qCDebug(logImageViewer) << "Removing image cache:" << path << "frame:" << frameIndex;
-    cache.remove(ThumbnailCache::toFindKey(path, frameIndex));
+    ThumbnailCache::Key key = ThumbnailCache::toFindKey(path, frameIndex);
+    removeEntry(key);
     // 同时移除缓存的图像数据
     ThumbnailCache::instance()->remove(path, frameIndex);
 
-    Q_EMIT imageDataChanged(path, frameIndex);
+    notifyDataChanged(key);
 }
 
 /**
@@ -366,10 +722,110 @@ void ImageInfoCache::removeCache(const QString &path, int frameIndex)
 void ImageInfoCache::clearCache()
 {
     qCDebug(logImageViewer) << "Clearing all image caches";
-    // 清理还未启动的线程任务
-    localPoolPtr->clear();
+    // 清理还未启动的线程任务，已启动的任务在完成时更新运行计数
+    pendingQueue.clear();
+    pendingTasks.clear();
     waitSet.clear();
     cache.clear();
+    lruQueue.clear();
+    totalCost = 0;
+}
+
+/**
+   @brief 保存 \a key 对应的图片信息 \a data ，超过内存上限时淘汰最久未访问的条目
+ */
+void ImageInfoCache::insertEntry(const KeyType &key, const ImageInfoData::Ptr &data)
+{
+    removeEntry(key);
+
+    CacheEntry &entry = cache[key];
+    entry.data = data;
+    entry.cost = data->cost();
+    totalCost += entry.cost;
+    touchEntry(entry, key);
+
+    trimEntries();
+}
+
+/**
+   @brief 移除 \a key 对应的缓存条目
+ */
+void ImageInfoCache::removeEntry(const KeyType &key)
+{
+    auto itr = cache.find(key);
+    if (itr != cache.end()) {
+        lruQueue.remove(itr->lastUse);
+        totalCost -= itr->cost;
+        cache.erase(itr);
+    }
+}
+
+/**
+   @brief 更新缓存条目 \a entry 的访问顺序
+ */
+void ImageInfoCache::touchEntry(CacheEntry &entry, const KeyType &key)
+{
+    if (entry.lastUse) {
+        lruQueue.remove(entry.lastUse);
+    }
+    entry.lastUse = ++useCounter;
+    lruQueue.insert(entry.lastUse, key);
+}
+
+/**
+   @brief 超过内存上限时，按访问先后淘汰缓存条目
+   @note 仍被 ImageInfo 订阅(界面展示中)的条目不会被淘汰，运行时属性(缩放、偏移)需保留；
+    淘汰的条目再次访问时重新加载，将直接读取打包或磁盘缩略图缓存，无需解码原图
+ */
+void ImageInfoCache::trimEntries()
+{
+    auto itr = lruQueue.begin();
+    while (totalCost > sc_MaxInfoCacheCost && itr != lruQueue.end()) {
+        const KeyType key = itr.value();
+        if (subscribers.contains(key)) {
+            ++itr;
+            continue;
+        }
+
+        itr = lruQueue.erase(itr);
+        auto entryItr = cache.find(key);
+        if (entryItr != cache.end()) {
+            totalCost -= entryItr->cost;
+            cache.erase(entryItr);
+        }
+    }
+}
+
+/**
+   @brief 订阅 \a key 对应图片的数据变更，数据加载完成或变更时通知 \a info
+ */
+void ImageInfoCache::subscribe(const KeyType &key, ImageInfo *info)
+{
+    subscribers.insert(key, info);
+}
+
+/**
+   @brief 取消 \a info 对 \a key 对应图片的订阅
+ */
+void ImageInfoCache::unsubscribe(const KeyType &key, ImageInfo *info)
+{
+    subscribers.remove(key, info);
+}
+
+/**
+   @brief 通知订阅 \a key 的 ImageInfo 图片数据已变更
+ */
+void ImageInfoCache::notifyDataChanged(const KeyType &key)
+{
+    subscribers.notify(key, [](ImageInfo *info) { info->onLoadFinished(); });
+}
+
+/**
+   @brief 通知订阅 \a key 的 ImageInfo 图片大小已变更
+ */
+void ImageInfoCache::notifySizeChanged(const KeyType &key)
+{
+    subscribers.notify(key, [](ImageInfo *info) { info->onSizeChanged(); });
 }
 
 /**
@@ -384,24 +840,27 @@ ImageInfo::ImageInfo(QObject *parent)
     : QObject(parent)
 {
     qCDebug(logImageViewer) << "ImageInfo constructor called";
-    // TODO(renbin): 这种方式效率不佳，应调整为记录文件对应的 ImageInfo 对象进行直接调用(均在同一线程)
-    connect(CacheInstance(), &ImageInfoCache::imageDataChanged, this, &ImageInfo::onLoadFinished);
-    connect(CacheInstance(), &ImageInfoCache::imageSizeChanged, this, &ImageInfo::onSizeChanged);
-    qCDebug(logImageViewer) << "Connected ImageInfoCache signals to onLoadFinished and onSizeChanged.";
 }
 
 ImageInfo::ImageInfo(const QUrl &source, QObject *parent)
     : QObject(parent)
 {
     qCDebug(logImageViewer) << "ImageInfo constructor called with source:" << source;
-    connect(CacheInstance(), &ImageInfoCache::imageDataChanged, this, &ImageInfo::onLoadFinished);
-    connect(CacheInstance(), &ImageInfoCache::imageSizeChanged, this, &ImageInfo::onSizeChanged);
     setSource(source);
 }
 
 ImageInfo::~ImageInfo()
 {
     qCDebug(logImageViewer) << "ImageInfo destructor called";
+    if (CacheInstance.isDestroyed()) {
+        return;
+    }
+
+    // 组件销毁(例如缩略图离开列表缓存区域)时，取消还未执行的加载任务
+    cancelLoading();
+    if (imageKey.isValid()) {
+        CacheInstance()->unsubscribe(imageKey, this);
+    }
 }
 
 ImageInfo::Status ImageInfo::status() const
@@ -419,11 +878,18 @@ void ImageInfo::setSource(const QUrl &source)
     qCDebug(logImageViewer) << "ImageInfo::setSource called with source:" << source;
     if (imageUrl != source) {
         qCDebug(logImageViewer) << "ImageInfo::setSource changed source from:" << imageUrl << "to:" << source;
+        cancelLoading();
         imageUrl = source;
+        localPath = source.toLocalFile();
+        updateSubscription();
         Q_EMIT sourceChanged();
 
-        // 刷新数据
-        refreshDataFromCache(true);
+        // 刷新数据，QML 创建组件期间延后至 componentComplete() ，以使用同时设置的加载优先级
+        if (componentBuilding) {
+            refreshPending = true;
+        } else {
+            refreshDataFromCache(true);
+        }
     }
 }
 
@@ -476,8 +942,8 @@ void ImageInfo::swapWidthAndHeight()
     if (data) {
         qCDebug(logImageViewer) << "ImageInfo::swapWidthAndHeight swapping width and height";
         data->size = QSize(data->size.height(), data->size.width());
-        // 广播大小变更信号
-        Q_EMIT CacheInstance()->imageSizeChanged(imageUrl.toLocalFile(), currentIndex);
+        // 通知使用相同图片的 ImageInfo 大小变更
+        CacheInstance()->notifySizeChanged(imageKey);
     }
 }
 
@@ -490,11 +956,17 @@ void ImageInfo::setFrameIndex(int index)
     qCDebug(logImageViewer) << "ImageInfo::setFrameIndex called with index:" << index;
     if (currentIndex != index) {
         qCDebug(logImageViewer) << "ImageInfo::setFrameIndex changing currentIndex from:" << currentIndex << "to:" << index;
+        cancelLoading();
         currentIndex = index;
+        updateSubscription();
         Q_EMIT frameIndexChanged();
 
         // 刷新数据
-        refreshDataFromCache(true);
+        if (componentBuilding) {
+            refreshPending = true;
+        } else {
+            refreshDataFromCache(true);
+        }
     }
 }
 
@@ -598,20 +1070,84 @@ bool ImageInfo::hasCachedThumbnail() const
             break;
         }
 
-        bool ret = ThumbnailCache::instance()->contains(imageUrl.toLocalFile(), frameIndex());
+        bool ret = ThumbnailCache::instance()->contains(localPath, frameIndex());
         qCDebug(logImageViewer) << "ImageInfo::hasCachedThumbnail returning:" << ret;
         return ret;
     }
 }
 
+/**
+   @brief 设置图片信息的加载优先级为 \a priority ，值越小越先加载，默认为 0 ，
+    0 为紧急任务，在滑动暂缓期间仍会加载。缩略图列表根据缩略图距离视图中心的距离设置此值
+ */
+void ImageInfo::setLoadPriority(int priority)
+{
+    priority = qMax(0, priority);
+    if (this->priority != priority) {
+        this->priority = priority;
+        Q_EMIT loadPriorityChanged();
+
+        if (Loading == imageStatus) {
+            CacheInstance()->updatePriority(localPath, currentIndex, priority);
+        }
+    }
+}
+
+/**
+   @return 返回图片信息的加载优先级
+ */
+int ImageInfo::loadPriority() const
+{
+    return priority;
+}
+
+/**
+   @brief 设置加载时是否将缩略图保存至内存缓存 \a cache ，默认保存。
+    后台预加载远离当前图片的文件时不保存，避免淘汰视图中正在使用的缩略图，仅写入图片信息和磁盘缩略图缓存
+   @note 需在 setSource() 前设置，QML 中在组件创建完成前设置均可
+ */
+void ImageInfo::setCacheThumbnail(bool cache)
+{
+    cacheThumbnail = cache;
+}
+
+/**
+   @brief 设置是否暂缓启动非紧急 (优先级大于 0) 的加载任务，用于视图快速滑动期间
+ */
+void ImageInfo::setLoadDeferred(bool deferred)
+{
+    CacheInstance()->setDeferred(deferred);
+}
+
+/**
+   @brief QML 开始创建组件，此后设置的 source 及 frameIndex 延后至 componentComplete() 加载
+ */
+void ImageInfo::classBegin()
+{
+    componentBuilding = true;
+}
+
+/**
+   @brief QML 组件创建完成，各属性(包括 loadPriority 及绑定)均已设置，按设置的优先级请求加载。
+    QML 中属性的赋值顺序不固定，在 source 赋值时立即加载将以默认的紧急优先级投递任务
+ */
+void ImageInfo::componentComplete()
+{
+    componentBuilding = false;
+    if (refreshPending) {
+        refreshPending = false;
+        refreshDataFromCache(true);
+    }
+}
+
 /**
    @brief 强制重新加载当前图片信息
  */
 void ImageInfo::reloadData()
 {
-    qCDebug(logImageViewer) << "Reloading image data:" << imageUrl.toLocalFile() << "frame:" << currentIndex;
+    qCDebug(logImageViewer) << "Reloading image data:" << localPath << "frame:" << currentIndex;
     setStatus(Loading);
-    CacheInstance()->load(imageUrl.toLocalFile(), currentIndex, true);
+    CacheInstance()->load(localPath, currentIndex, true, priority, cacheThumbnail);
 }
 
 /**
@@ -621,17 +1157,17 @@ void ImageInfo::clearCurrentCache()
 {
     qCDebug(logImageViewer) << "ImageInfo::clearCurrentCache called";
     if (data) {
-        qCDebug(logImageViewer) << "Clearing current image cache:" << imageUrl.toLocalFile()
+        qCDebug(logImageViewer) << "Clearing current image cache:" << localPath
                                 << "frames:" << data->frameCount;
         for (int i = 0; i < data->frameCount; ++i) {
-            CacheInstance()->removeCache(imageUrl.toLocalFile(), i);
+            CacheInstance()->removeCache(localPath, i);
         }
     }
 }
 
 /**
    @brief 清空缓存数据，包括缩略图缓存和图片属性缓存
-   @note 这不会影响处于加载队列中的任务
+   @note 这不会影响处于加载队列中的任务。路径驻留表不回收，预载及加载线程持有的路径 ID 保持有效
  */
 void ImageInfo::clearCache()
 {
@@ -653,6 +1189,31 @@ void ImageInfo::setStatus(ImageInfo::Status status)
     }
 }
 
+/**
+   @brief 图片路径或帧号变更时，更新在缓存中订阅的 key
+ */
+void ImageInfo::updateSubscription()
+{
+    if (imageKey.isValid()) {
+        CacheInstance()->unsubscribe(imageKey, this);
+    }
+
+    imageKey = localPath.isEmpty() ? ImageKey() : ThumbnailCache::toFindKey(localPath, currentIndex);
+    if (imageKey.isValid()) {
+        CacheInstance()->subscribe(imageKey, this);
+    }
+}
+
+/**
+   @brief 取消当前图片还未执行的加载请求
+ */
+void ImageInfo::cancelLoading()
+{
+    if (Loading == imageStatus && !localPath.isEmpty()) {
+        CacheInstance()->cancel(localPath, currentIndex);
+    }
+}
+
 /**
    @brief 更新图像数据，将发送部分关键数据的更新信号
    @param newData 新图像数据
@@ -707,7 +1268,6 @@ bool ImageInfo::updateData(const QSharedPointer<ImageInfoData> &newData)
 void ImageInfo::refreshDataFromCache(bool reload)
 {
     qCDebug(logImageViewer) << "ImageInfo::refreshDataFromCache called with reload:" << reload;
-    QString localPath = imageUrl.toLocalFile();
     if (localPath.isEmpty()) {
         qCWarning(logImageViewer) << "Empty image path";
         qCDebug(logImageViewer) << "ImageInfo::refreshDataFromCache setting status to Error";
@@ -737,7 +1297,7 @@ void ImageInfo::refreshDataFromCache(bool reload)
         if (reload) {
             qCDebug(logImageViewer) << "Requesting image reload:" << localPath << "frame:" << currentIndex;
             setStatus(Loading);
-            CacheInstance()->load(localPath, currentIndex);
+            CacheInstance()->load(localPath, currentIndex, false, priority, cacheThumbnail);
         } else {
             qCWarning(logImageViewer) << "Image data not found:" << localPath << "frame:" << currentIndex;
             setStatus(Error);
@@ -747,36 +1307,26 @@ void ImageInfo::refreshDataFromCache(bool reload)
 }
 
 /**
-   @brief 内部数据异步加载完成，返回处理的文件路径 \a path ,
+   @brief 订阅的图片数据加载完成或变更，由 ImageInfoCache 直接调用，
         根据加载结果，设置图片信息状态
  */
-void ImageInfo::onLoadFinished(const QString &path, int frameIndex)
+void ImageInfo::onLoadFinished()
 {
-    qCDebug(logImageViewer) << "ImageInfo::onLoadFinished called with path:" << path << "frameIndex:" << frameIndex;
-    if (imageUrl.toLocalFile() == path && currentIndex == frameIndex) {
-        // 从缓存刷新数据，不重新加载
-        refreshDataFromCache(false);
-    } else {
-        qCDebug(logImageViewer) << "Loaded image does not match current image, skipping update.";
-    }
-    qCDebug(logImageViewer) << "ImageInfo::onLoadFinished finished";
+    qCDebug(logImageViewer) << "ImageInfo::onLoadFinished called for:" << localPath << "frameIndex:" << currentIndex;
+    // 从缓存刷新数据，不重新加载
+    refreshDataFromCache(false);
 }
 
 /**
-   @brief 图片 \a path 的第 \a frameIndex 帧的图片大小出现变更
+   @brief 订阅的图片大小出现变更
  */
-void ImageInfo::onSizeChanged(const QString &path, int frameIndex)
+void ImageInfo::onSizeChanged()
 {
-    qCDebug(logImageViewer) << "ImageInfo::onSizeChanged called with path:" << path << "frameIndex:" << frameIndex;
-    if (imageUrl.toLocalFile() == path && currentIndex == frameIndex) {
-        qCDebug(logImageViewer) << "ImageInfo::onSizeChanged updating width and height";
-        if (data) {
-            qCDebug(logImageViewer) << "ImageInfo::onSizeChanged emitting widthChanged and heightChanged";
-            Q_EMIT widthChanged();
-            Q_EMIT heightChanged();
-        }
+    qCDebug(logImageViewer) << "ImageInfo::onSizeChanged called for:" << localPath << "frameIndex:" << currentIndex;
+    if (data) {
+        Q_EMIT widthChanged();
+        Q_EMIT heightChanged();
     }
-    qCDebug(logImageViewer) << "ImageInfo::onSizeChanged finished";
 }
 
 #include "imageinfo.moc"
@@ -5,14 +5,19 @@
 #ifndef IMAGEINFO_H
 #define IMAGEINFO_H
 
+#include "imagepathtable.h"
+
 #include <QObject>
 #include <QUrl>
 #include <QSharedPointer>
+#include <QQmlParserStatus>
 
 class ImageInfoData;
-class ImageInfo : public QObject
+class ImageInfoCache;
+class ImageInfo : public QObject, public QQmlParserStatus
 {
     Q_OBJECT
+    Q_INTERFACES(QQmlParserStatus)
     Q_ENUMS(Status)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
@@ -23,6 +28,7 @@ class ImageInfo : public QObject
     Q_PROPERTY(int frameCount READ frameCount NOTIFY frameCountChanged)
     Q_PROPERTY(bool exists READ exists NOTIFY existsChanged)
     Q_PROPERTY(bool hasCachedThumbnail READ hasCachedThumbnail)
+    Q_PROPERTY(int loadPriority READ loadPriority WRITE setLoadPriority NOTIFY loadPriorityChanged)
 
     // runtime properties
     Q_PROPERTY(qreal scale READ scale WRITE setScale FINAL)
@@ -69,24 +75,43 @@ public:
     Q_SIGNAL void existsChanged();
     bool hasCachedThumbnail() const;
 
+    void setLoadPriority(int priority);
+    int loadPriority() const;
+    Q_SIGNAL void loadPriorityChanged();
+    void setCacheThumbnail(bool cache);
+    static void setLoadDeferred(bool deferred);
+
     Q_SIGNAL void infoChanged();
     Q_INVOKABLE void reloadData();
 
     void clearCurrentCache();
     static void clearCache();
 
+    void classBegin() override;
+    void componentComplete() override;
+
 protected:
     void setStatus(Status status);
+    void cancelLoading();
+    void updateSubscription();
     bool updateData(const QSharedPointer<ImageInfoData> &newData);
     void refreshDataFromCache(bool reload = false);
-    Q_SLOT void onLoadFinished(const QString &path, int frameIndex = 0);
-    Q_SLOT void onSizeChanged(const QString &path, int frameIndex = 0);
+    void onLoadFinished();
+    void onSizeChanged();
 
 protected:
     QUrl imageUrl;
+    QString localPath;   ///< imageUrl 对应的本地路径，避免重复转换
+    ImageKey imageKey;   ///< 当前订阅的图片 key (路径, 帧号)
     Status imageStatus = Null;
     int currentIndex = 0;
+    int priority = 0;
+    bool cacheThumbnail = true;
+    bool componentBuilding = false;  ///< QML 组件创建中，属性尚未全部设置
+    bool refreshPending = false;     ///< 组件创建完成后需刷新数据
     QSharedPointer<ImageInfoData> data;
+
+    friend class ImageInfoCache;
 };
 
 #endif  // IMAGEINFO_H
@@ -0,0 +1,410 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imageinfoindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QLoggingCategory>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+namespace {
+
+const char s_indexMagic[8] = { 'D', 'I', 'V', 'I', 'N', 'D', 'E', 'X' };
+const quint32 s_indexVersion = 3;
+const quint32 s_slotCount = 1u << 18;     // 记录槽数量，文件约 16MB ，未写入的页面不占用磁盘及内存
+const quint32 s_maxProbe = 8;             // 冲突时线性探测的槽数量，均被占用时替换其中一个
+const off_t s_dataOffset = 64;            // 首个记录槽的偏移，文件头占用一个槽的大小
+const off_t s_indexFileSize = s_dataOffset + off_t(s_slotCount) * 64;
+
+/**
+   @brief 索引文件头，位于文件起始位置
+ */
+struct IndexHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 recordSize;
+    quint32 slotCount;
+    quint32 reserved;
+};
+
+/**
+   @brief 索引文件记录，按键的哈希值存放于固定的槽，同一文件的新记录覆盖之前的记录
+ */
+struct IndexRecord
+{
+    quint64 dev;
+    quint64 inode;
+    qint64 size;
+    qint64 mtime;
+    qint32 frameIndex;
+    qint32 type;
+    qint32 width;
+    qint32 height;
+    qint32 frameCount;
+    quint32 captureTime[2];   ///< EXIF 拍摄时间(ms)的低、高 32 位，拆分存放以保持记录 64 字节且无填充
+    quint32 checksum;   ///< 校验前述字段，丢弃不完整写入的记录
+};
+
+static_assert(sizeof(IndexHeader) == 24, "unexpected index header layout");
+static_assert(sizeof(IndexRecord) == 64, "unexpected index record layout");
+static_assert(off_t(sizeof(IndexHeader)) <= s_dataOffset, "index header overlaps records");
+
+quint32 recordChecksum(const IndexRecord &record)
+{
+    // FNV-1a
+    quint32 hash = 2166136261u;
+    const uchar *data = reinterpret_cast<const uchar *>(&record);
+    for (size_t i = 0; i < offsetof(IndexRecord, checksum); ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+   @return 返回键 \a key 的哈希值，多个进程共享索引文件，不使用带随机种子的 qHash()
+ */
+quint64 keyHash(const ImageFileKey &key)
+{
+    // splitmix64 混合
+    quint64 hash = key.inode ^ (key.dev << 48) ^ (quint64(key.mtime) * 0x9E3779B97F4A7C15ull) ^ quint64(key.size)
+                   ^ (quint64(quint32(key.frameIndex)) << 32);
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+bool writeAll(int fd, const char *data, size_t len, off_t offset)
+{
+    while (len > 0) {
+        ssize_t ret = ::pwrite(fd, data, len, offset);
+        if (ret < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        offset += ret;
+        len -= static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+IndexRecord toIndexRecord(const ImageFileKey &key, const ImageInfoIndex::Record &record)
+{
+    IndexRecord value;
+    std::memset(&value, 0, sizeof(value));
+    value.dev = key.dev;
+    value.inode = key.inode;
+    value.size = key.size;
+    value.mtime = key.mtime;
+    value.frameIndex = key.frameIndex;
+    value.type = record.type;
+    value.width = record.size.width();
+    value.height = record.size.height();
+    value.frameCount = record.frameCount;
+    value.captureTime[0] = quint32(quint64(record.captureTime));
+    value.captureTime[1] = quint32(quint64(record.captureTime) >> 32);
+    value.checksum = recordChecksum(value);
+    return value;
+}
+
+bool isHeaderValid(const IndexHeader &header)
+{
+    return (0 == std::memcmp(header.magic, s_indexMagic, sizeof(s_indexMagic))) && (s_indexVersion == header.version)
+           && (sizeof(IndexRecord) == header.recordSize) && (s_slotCount == header.slotCount);
+}
+
+}  // namespace
+
+/**
+   @class ImageInfoIndex
+   @brief 持久化的图片信息索引，以 (dev, inode, size, mtime, 帧索引) 为键保存图片类型、大小、帧数及拍摄时间，
+        再次打开相同的图片或按拍摄时间、像素数排序时直接读取，无需探测文件格式、解码图片及读取文件头。
+   @note 索引文件为定长的哈希表，每条记录按键的哈希值存放于固定的槽，查询时直接读取只读映射，
+        仅访问到的页面由内核按需读入，不在进程内保存记录副本；槽被占满时新记录替换旧记录，文件大小固定无需压缩。
+        多个看图进程通过 pwrite 写入单条记录，不完整的记录由校验和丢弃。
+        索引文件仅在无效时整体替换，写入前检查路径对应的 inode ，被其它进程替换后重新打开。
+   @threadsafe
+ */
+ImageInfoIndex::ImageInfoIndex()
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    indexPath = cacheDir + "/imageinfo-v2.index";
+    // 移除旧版本追加写入格式的索引文件
+    QFile::remove(cacheDir + "/imageinfo.index");
+}
+
+ImageInfoIndex::~ImageInfoIndex()
+{
+    closeIndex();
+}
+
+ImageInfoIndex *ImageInfoIndex::instance()
+{
+    static ImageInfoIndex ins;
+    return &ins;
+}
+
+/**
+   @brief 查询 \a path 第 \a frameIndex 帧的图片信息 \a record
+   @return 是否存在有效的记录，文件变更后记录自动失效
+ */
+bool ImageInfoIndex::find(const QString &path, int frameIndex, Record &record)
+{
+    ImageFileKey key;
+    if (!readFileKey(path, frameIndex, key)) {
+        return false;
+    }
+
+    QMutexLocker _locker(&mutex);
+    if (!ensureOpened()) {
+        return false;
+    }
+
+    const quint64 hash = keyHash(key);
+    for (quint32 i = 0; i < s_maxProbe; ++i) {
+        if (readSlot(static_cast<quint32>((hash + i) % s_slotCount), key, &record)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+   @brief 保存 \a path 第 \a frameIndex 帧的图片信息 \a record
+ */
+void ImageInfoIndex::insert(const QString &path, int frameIndex, const Record &record)
+{
+    ImageFileKey key;
+    if (!readFileKey(path, frameIndex, key)) {
+        return;
+    }
+
+    QMutexLocker _locker(&mutex);
+    if (!ensureOpened() || !reopenIfReplaced()) {
+        return;
+    }
+
+    // 优先写入相同键或空闲(含无效记录)的槽，探测范围内均被占用时按哈希值选择替换的槽
+    const quint64 hash = keyHash(key);
+    quint32 target = static_cast<quint32>((hash + (hash >> 32) % s_maxProbe) % s_slotCount);
+    quint32 freeSlot = s_slotCount;
+    for (quint32 i = 0; i < s_maxProbe; ++i) {
+        const quint32 slot = static_cast<quint32>((hash + i) % s_slotCount);
+        Record current;
+        if (readSlot(slot, key, &current)) {
+            if (current.type == record.type && current.size == record.size && current.frameCount == record.frameCount
+                && current.captureTime == record.captureTime) {
+                return;
+            }
+            freeSlot = slot;
+            break;
+        }
+
+        if (s_slotCount == freeSlot && !readSlot(slot, key, nullptr)) {
+            freeSlot = slot;
+        }
+    }
+    if (s_slotCount != freeSlot) {
+        target = freeSlot;
+    }
+
+    const IndexRecord value = toIndexRecord(key, record);
+    const off_t offset = s_dataOffset + off_t(target) * off_t(sizeof(value));
+    if (!writeAll(indexFd, reinterpret_cast<const char *>(&value), sizeof(value), offset)) {
+        qCWarning(logImageViewer) << "Failed to write image info index:" << indexPath << strerror(errno);
+    }
+}
+
+/**
+   @brief 解除索引文件的映射并关闭文件，用于进入待机状态时释放资源，下次访问时重新打开
+ */
+void ImageInfoIndex::release()
+{
+    QMutexLocker _locker(&mutex);
+    closeIndex();
+    opened = false;
+}
+
+/**
+   @brief 读取文件 \a path 的唯一标识 \a key
+ */
+bool ImageInfoIndex::readFileKey(const QString &path, int frameIndex, ImageFileKey &key)
+{
+    struct stat st;
+    if (path.isEmpty() || 0 != ::stat(QFile::encodeName(path).constData(), &st)) {
+        return false;
+    }
+
+    key.dev = static_cast<quint64>(st.st_dev);
+    key.inode = static_cast<quint64>(st.st_ino);
+    key.size = static_cast<qint64>(st.st_size);
+    key.mtime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    key.frameIndex = frameIndex;
+    return true;
+}
+
+/**
+   @brief 首次访问时打开并映射索引文件，需持有锁调用
+ */
+bool ImageInfoIndex::ensureOpened()
+{
+    if (!opened) {
+        opened = true;
+        if (!openIndex()) {
+            qCWarning(logImageViewer) << "Failed to open image info index:" << indexPath;
+        }
+    }
+    return nullptr != mapping;
+}
+
+/**
+   @brief 打开并映射索引文件，文件不存在或格式不匹配时重新创建
+ */
+bool ImageInfoIndex::openIndex()
+{
+    QDir().mkpath(QFileInfo(indexPath).absolutePath());
+    indexFd = ::open(QFile::encodeName(indexPath).constData(), O_RDWR | O_CLOEXEC);
+
+    bool valid = indexFd >= 0;
+    if (valid) {
+        struct stat st;
+        IndexHeader header;
+        valid = (0 == ::fstat(indexFd, &st)) && (st.st_size >= s_indexFileSize)
+                && (::pread(indexFd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))) && isHeaderValid(header);
+    }
+
+    if (!valid) {
+        if (indexFd >= 0) {
+            ::close(indexFd);
+            indexFd = -1;
+        }
+        if (!createIndex()) {
+            return false;
+        }
+    }
+
+    void *addr = ::mmap(nullptr, static_cast<size_t>(s_indexFileSize), PROT_READ, MAP_SHARED, indexFd, 0);
+    if (MAP_FAILED == addr) {
+        ::close(indexFd);
+        indexFd = -1;
+        return false;
+    }
+
+    mapping = static_cast<const uchar *>(addr);
+    qCDebug(logImageViewer) << "Opened image info index:" << indexPath;
+    return true;
+}
+
+/**
+   @brief 在临时文件中创建空的索引文件并原子替换，不在原文件上截断，避免其它进程访问映射时出错
+ */
+bool ImageInfoIndex::createIndex()
+{
+    qCDebug(logImageViewer) << "Initializing image info index:" << indexPath;
+    const QString tempPath = indexPath + QString(".%1.tmp").arg(::getpid());
+    int tempFd = ::open(QFile::encodeName(tempPath).constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tempFd < 0) {
+        return false;
+    }
+
+    IndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, s_indexMagic, sizeof(s_indexMagic));
+    header.version = s_indexVersion;
+    header.recordSize = sizeof(IndexRecord);
+    header.slotCount = s_slotCount;
+
+    // 记录槽保持为稀疏文件，全零的槽校验失败即为空闲
+    bool ret = (0 == ::ftruncate(tempFd, s_indexFileSize))
+               && writeAll(tempFd, reinterpret_cast<const char *>(&header), sizeof(header), 0)
+               && (0 == ::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(indexPath).constData()));
+    if (!ret) {
+        ::close(tempFd);
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    indexFd = tempFd;
+    return true;
+}
+
+/**
+   @brief 解除映射并关闭索引文件，需持有锁调用
+ */
+void ImageInfoIndex::closeIndex()
+{
+    if (mapping) {
+        ::munmap(const_cast<uchar *>(mapping), static_cast<size_t>(s_indexFileSize));
+        mapping = nullptr;
+    }
+    if (indexFd >= 0) {
+        ::close(indexFd);
+        indexFd = -1;
+    }
+}
+
+/**
+   @brief 索引文件被其它进程替换(或删除)时重新打开，避免写入已被移除的 inode 导致记录丢失，需持有锁调用
+   @return 返回索引文件是否可用
+ */
+bool ImageInfoIndex::reopenIfReplaced()
+{
+    struct stat pathStat;
+    struct stat fdStat;
+    if (0 == ::stat(QFile::encodeName(indexPath).constData(), &pathStat) && 0 == ::fstat(indexFd, &fdStat)
+        && pathStat.st_dev == fdStat.st_dev && pathStat.st_ino == fdStat.st_ino) {
+        return true;
+    }
+
+    qCDebug(logImageViewer) << "Image info index replaced, reopen:" << indexPath;
+    closeIndex();
+    return openIndex();
+}
+
+/**
+   @brief 读取槽 \a slot 中的记录，校验通过且键与 \a key 相同时通过 \a record 传出
+   @return 返回记录是否有效且匹配，\a record 为空时仅判断记录是否有效，不比较键
+ */
+bool ImageInfoIndex::readSlot(quint32 slot, const ImageFileKey &key, Record *record) const
+{
+    IndexRecord value;
+    std::memcpy(&value, mapping + s_dataOffset + static_cast<size_t>(slot) * sizeof(IndexRecord), sizeof(IndexRecord));
+    if (value.checksum != recordChecksum(value)) {
+        return false;
+    }
+    if (!record) {
+        return true;
+    }
+
+    if (value.dev != key.dev || value.inode != key.inode || value.size != key.size || value.mtime != key.mtime
+        || value.frameIndex != key.frameIndex) {
+        return false;
+    }
+
+    record->type = value.type;
+    record->size = QSize(value.width, value.height);
+    record->frameCount = value.frameCount;
+    record->captureTime = qint64((quint64(value.captureTime[1]) << 32) | value.captureTime[0]);
+    return true;
+}
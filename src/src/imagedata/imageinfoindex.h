@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEINFOINDEX_H
+#define IMAGEINFOINDEX_H
+
+#include <QString>
+#include <QSize>
+#include <QMutex>
+
+/**
+   @brief 图片文件唯一标识，由设备号、inode、文件大小、修改时间及帧索引组成，
+        文件内容变更后 mtime 或 size 随之变化，索引记录自动失效
+ */
+struct ImageFileKey
+{
+    quint64 dev = 0;
+    quint64 inode = 0;
+    qint64 size = 0;
+    qint64 mtime = 0;   ///< 纳秒精度
+    int frameIndex = 0;
+};
+
+inline bool operator==(const ImageFileKey &a, const ImageFileKey &b)
+{
+    return a.dev == b.dev && a.inode == b.inode && a.size == b.size && a.mtime == b.mtime && a.frameIndex == b.frameIndex;
+}
+
+class ImageInfoIndex
+{
+public:
+    /**
+       @brief 索引中保存的图片信息
+     */
+    struct Record
+    {
+        int type = 0;               ///< 图片类型 Types::ImageType
+        QSize size;                 ///< 图片大小
+        int frameCount = 0;         ///< 多页图总帧数
+        qint64 captureTime = 0;     ///< EXIF 拍摄时间(ms)，0 表示无拍摄时间，仅首帧记录
+    };
+
+    static ImageInfoIndex *instance();
+
+    bool find(const QString &path, int frameIndex, Record &record);
+    void insert(const QString &path, int frameIndex, const Record &record);
+    void release();
+
+private:
+    ImageInfoIndex();
+    ~ImageInfoIndex();
+
+    static bool readFileKey(const QString &path, int frameIndex, ImageFileKey &key);
+    bool ensureOpened();
+    bool openIndex();
+    bool createIndex();
+    void closeIndex();
+    bool reopenIfReplaced();
+    bool readSlot(quint32 slot, const ImageFileKey &key, Record *record) const;
+
+private:
+    QString indexPath;                 ///< 索引文件路径
+    QMutex mutex;
+    bool opened { false };
+    int indexFd { -1 };                ///< 索引文件描述符，通过 pwrite 写入记录
+    const uchar *mapping { nullptr };  ///< 索引文件的只读映射，查询时按需读入页面
+
+    Q_DISABLE_COPY(ImageInfoIndex)
+};
+
+#endif  // IMAGEINFOINDEX_H
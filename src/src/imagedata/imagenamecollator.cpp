@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagenamecollator.h"
+
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <iterator>
+
+static const int sc_ParallelThreshold = 4096;   // 文件数超过此数量时并行排序
+static const int sc_MinChunkSize = 2048;        // 并行排序时每个分段的最小文件数
+
+namespace {
+
+struct SortEntry
+{
+    QCollatorSortKey key;
+    int index;
+};
+using SortRun = std::vector<SortEntry>;
+
+}  // namespace
+
+/**
+   @class ImageNameCollator
+   @brief 图片文件名的自然排序(数字按数值比较)，比较首个 '.' 之前的名称，相同时按完整文件名排序。
+   @note 通过 QCollatorSortKey 预先生成排序键，排序过程中无需重复调用 QCollator::compare() 及分配字符串。
+        QCollator 不可跨线程共享，每个线程需使用独立的 ImageNameCollator 。
+ */
+
+ImageNameCollator::ImageNameCollator()
+{
+    collator.setNumericMode(true);
+}
+
+/**
+   @return 返回文件名 \a fileName 的排序键
+ */
+QCollatorSortKey ImageNameCollator::sortKey(const QString &fileName) const
+{
+    // 同 QFileInfo::baseName()
+    const int dot = fileName.indexOf('.');
+    return collator.sortKey(dot < 0 ? fileName : fileName.left(dot));
+}
+
+/**
+   @return 排序键为 \a key1 的文件名 \a fileName1 是否在排序键为 \a key2 的文件名 \a fileName2 之前
+ */
+bool ImageNameCollator::lessThan(const QCollatorSortKey &key1, const QString &fileName1, const QCollatorSortKey &key2,
+                                 const QString &fileName2)
+{
+    const int ret = key1.compare(key2);
+    if (0 != ret) {
+        return ret < 0;
+    }
+    return fileName1 < fileName2;
+}
+
+/**
+   @brief 按自然顺序排序文件名列表 \a fileNames ，每个文件名仅生成一次排序键，
+    文件数较多时分段并行生成排序键及排序，再两两归并
+   @return 返回与排序后的 \a fileNames 一一对应的排序键
+ */
+std::vector<QCollatorSortKey> ImageNameCollator::sort(QStringList &fileNames)
+{
+    const int count = fileNames.size();
+    if (0 == count) {
+        return {};
+    }
+
+    const int chunkCount = (count < sc_ParallelThreshold) ? 1 : qBound(1, count / sc_MinChunkSize, QThread::idealThreadCount());
+    const int chunkSize = (count + chunkCount - 1) / chunkCount;
+    const QStringList &names = fileNames;
+    auto entryLessThan = [&names](const SortEntry &entry1, const SortEntry &entry2) {
+        return lessThan(entry1.key, names.at(entry1.index), entry2.key, names.at(entry2.index));
+    };
+
+    std::vector<SortRun> runs(static_cast<size_t>(chunkCount));
+    QVector<int> chunks;
+    for (int i = 0; i < chunkCount; ++i) {
+        chunks.append(i);
+    }
+
+    auto sortChunk = [&](int chunk) {
+        ImageNameCollator collator;
+        const int begin = chunk * chunkSize;
+        const int end = qMin(count, begin + chunkSize);
+        SortRun &run = runs[static_cast<size_t>(chunk)];
+        run.reserve(static_cast<size_t>(qMax(0, end - begin)));
+        for (int i = begin; i < end; ++i) {
+            run.push_back({ collator.sortKey(names.at(i)), i });
+        }
+        std::sort(run.begin(), run.end(), entryLessThan);
+    };
+
+    if (1 == chunkCount) {
+        sortChunk(0);
+    } else {
+        QtConcurrent::blockingMap(chunks, sortChunk);
+    }
+
+    // 两两归并已排序的分段
+    while (runs.size() > 1) {
+        std::vector<SortRun> merged((runs.size() + 1) / 2);
+        QVector<int> pairs;
+        for (int i = 0; i < static_cast<int>(merged.size()); ++i) {
+            pairs.append(i);
+        }
+
+        QtConcurrent::blockingMap(pairs, [&](int pair) {
+            const size_t left = static_cast<size_t>(pair) * 2;
+            SortRun &result = merged[static_cast<size_t>(pair)];
+            if (left + 1 < runs.size()) {
+                result.reserve(runs[left].size() + runs[left + 1].size());
+                std::merge(runs[left].begin(), runs[left].end(), runs[left + 1].begin(), runs[left + 1].end(),
+                           std::back_inserter(result), entryLessThan);
+            } else {
+                result.swap(runs[left]);
+            }
+        });
+        runs.swap(merged);
+    }
+
+    QStringList sortedNames;
+    sortedNames.reserve(count);
+    std::vector<QCollatorSortKey> keys;
+    keys.reserve(static_cast<size_t>(count));
+    for (const SortEntry &entry : runs.front()) {
+        sortedNames.append(names.at(entry.index));
+        keys.push_back(entry.key);
+    }
+
+    fileNames.swap(sortedNames);
+    return keys;
+}
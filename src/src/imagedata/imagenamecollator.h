@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGENAMECOLLATOR_H
+#define IMAGENAMECOLLATOR_H
+
+#include <QCollator>
+#include <QStringList>
+
+#include <vector>
+
+class ImageNameCollator
+{
+public:
+    ImageNameCollator();
+
+    QCollatorSortKey sortKey(const QString &fileName) const;
+
+    static bool lessThan(const QCollatorSortKey &key1, const QString &fileName1, const QCollatorSortKey &key2,
+                         const QString &fileName2);
+    static std::vector<QCollatorSortKey> sort(QStringList &fileNames);
+
+private:
+    QCollator collator;
+};
+
+#endif  // IMAGENAMECOLLATOR_H
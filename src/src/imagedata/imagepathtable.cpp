@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagepathtable.h"
+
+#include <QReadWriteLock>
+#include <QUrl>
+#include <QVector>
+
+namespace {
+
+const quint32 s_maxPathCount = 0xFFFFFF;  // 驻留的路径数量上限，超出后不再分配 ID
+
+/**
+   @brief 路径驻留表数据，路径 ID 在进程生命周期内保持不变
+ */
+struct PathTableData
+{
+    QReadWriteLock lock;
+    QHash<QString, quint32> pathIds;  ///< 文件路径 -> ID
+    QHash<QString, quint32> urlIds;   ///< 图像加载器传入的 url 字符串 -> ID ，避免重复解析 url
+    QVector<QString> paths;           ///< 下标为 ID - 1
+};
+
+PathTableData *tableData()
+{
+    static PathTableData data;
+    return &data;
+}
+
+quint32 internLocked(PathTableData *data, const QString &path)
+{
+    quint32 id = data->pathIds.value(path, 0);
+    if (0 == id) {
+        if (static_cast<quint32>(data->paths.size()) >= s_maxPathCount) {
+            // 路径数量超出上限，不分配 ID ，调用方不缓存此图像
+            return 0;
+        }
+        data->paths.append(path);
+        id = static_cast<quint32>(data->paths.size());
+        data->pathIds.insert(path, id);
+    }
+    return id;
+}
+
+}  // namespace
+
+/**
+   @class ImagePathTable
+   @brief 图像路径驻留表，为每个文件路径分配稳定的 32 位 ID ，
+        各图像缓存使用 ImageKey(路径 ID, 帧索引, 缩略图层级) 作为键值，查询时仅需比较整数。
+   @note 重命名后的文件将分配新的 ID 。ID 在进程生命周期内保持不变，切换文件夹时不回收，
+        避免预载及加载线程持有的 ID 失效；路径仅在被缓存访问时驻留，数量超出上限后不再分配 ID ，
+        intern() 返回 0 ，调用方需跳过缓存，不会与其它路径共用缓存键值。
+   @threadsafe
+ */
+
+/**
+   @return 返回文件路径 \a path 的 ID ，不存在时分配新的 ID ，空路径或驻留表已满时返回 0
+ */
+quint32 ImagePathTable::intern(const QString &path)
+{
+    if (path.isEmpty()) {
+        return 0;
+    }
+
+    PathTableData *data = tableData();
+    {
+        QReadLocker _locker(&data->lock);
+        quint32 id = data->pathIds.value(path, 0);
+        if (0 != id) {
+            return id;
+        }
+    }
+
+    QWriteLocker _locker(&data->lock);
+    return internLocked(data, path);
+}
+
+/**
+   @return 返回已分配的文件路径 \a path 的 ID ，未分配时返回 0 且不会分配
+ */
+quint32 ImagePathTable::find(const QString &path)
+{
+    PathTableData *data = tableData();
+    QReadLocker _locker(&data->lock);
+    return data->pathIds.value(path, 0);
+}
+
+/**
+   @return 返回 \a id 对应的文件路径，无效的 ID 返回空字符串
+ */
+QString ImagePathTable::path(quint32 id)
+{
+    PathTableData *data = tableData();
+    QReadLocker _locker(&data->lock);
+    if (0 == id || id > static_cast<quint32>(data->paths.size())) {
+        return QString();
+    }
+    return data->paths.at(static_cast<int>(id - 1));
+}
+
+/**
+   @return 返回 url 字符串 \a url (如 "file:///home/tmp.png")指向的本地文件路径 ID ，
+        缓存 url 字符串的解析结果，图像加载器重复请求同一图像时无需再次构造 QUrl 。
+        驻留表已满时返回 0
+ */
+quint32 ImagePathTable::internUrl(const QString &url)
+{
+    if (url.isEmpty()) {
+        return 0;
+    }
+
+    PathTableData *data = tableData();
+    {
+        QReadLocker _locker(&data->lock);
+        quint32 id = data->urlIds.value(url, 0);
+        if (0 != id) {
+            return id;
+        }
+    }
+
+    const QString path = QUrl(url).toLocalFile();
+    if (path.isEmpty()) {
+        return 0;
+    }
+
+    QWriteLocker _locker(&data->lock);
+    quint32 id = internLocked(data, path);
+    if (0 != id) {
+        data->urlIds.insert(url, id);
+    }
+    return id;
+}
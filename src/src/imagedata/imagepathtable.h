@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEPATHTABLE_H
+#define IMAGEPATHTABLE_H
+
+#include <QString>
+#include <QHash>
+
+/**
+   @brief 图像缓存使用的紧凑键值，由图像路径 ID 、帧索引和缩略图层级组成，
+        相较 QPair<QString, int> 无需逐字符计算哈希和比较
+ */
+struct ImageKey
+{
+    quint32 pathId = 0;      ///< ImagePathTable 分配的路径 ID ，0 为无效值
+    quint16 frameIndex = 0;  ///< 多页图帧索引
+    quint16 tier = 0;        ///< 缩略图层级
+
+    ImageKey() = default;
+    ImageKey(quint32 id, int frame, int t = 0)
+        : pathId(id)
+        , frameIndex(static_cast<quint16>(qBound(0, frame, 0xFFFF)))
+        , tier(static_cast<quint16>(t))
+    {
+    }
+
+    inline bool isValid() const { return 0 != pathId; }
+    inline quint64 toUInt64() const { return (quint64(pathId) << 32) | (quint64(frameIndex) << 16) | tier; }
+};
+
+inline bool operator==(const ImageKey &a, const ImageKey &b)
+{
+    return a.toUInt64() == b.toUInt64();
+}
+
+inline bool operator!=(const ImageKey &a, const ImageKey &b)
+{
+    return !(a == b);
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+inline size_t qHash(const ImageKey &key, size_t seed = 0)
+#else
+inline uint qHash(const ImageKey &key, uint seed = 0)
+#endif
+{
+    return ::qHash(key.toUInt64(), seed);
+}
+
+class ImagePathTable
+{
+public:
+    static quint32 intern(const QString &path);
+    static quint32 find(const QString &path);
+    static QString path(quint32 id);
+    static quint32 internUrl(const QString &url);
+
+private:
+    ImagePathTable() = delete;
+};
+
+#endif  // IMAGEPATHTABLE_H
@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imageprewarmer.h"
+#include "imageinfo.h"
+#include "imagesourcemodel.h"
+#include "globalcontrol.h"
+#include "types.h"
+
+#include <QTimerEvent>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static const int sc_StartDelay = 1000;         // 打开图片后延迟启动预加载 1000ms
+static const int sc_IdleDelay = 800;           // 用户切换图片后恢复预加载的间隔 800ms
+static const int sc_MaxInflight = 2;           // 同时加载中的预加载任务上限
+static const int sc_MaxBatchCount = 64;        // 单次处理的最大图片数，避免阻塞界面
+static const int sc_KeepThumbnailRange = 60;   // 距离中心此范围内的缩略图保存至内存缓存
+static const int sc_PrewarmPriority = 0x10000;  // 预加载优先级，低于所有视图中的加载请求
+
+/**
+   @class ImagePrewarmer
+   @brief 后台预加载图片信息及缩略图
+   @details 打开图片并展示首张图片后，在空闲时由当前图片向两侧遍历数据模型，以最低的优先级加载
+    图片信息。距离当前图片较近的缩略图保存至内存缓存，较远的仅写入图片信息及磁盘缩略图缓存，
+    后续跳转至列表尾部时无需再次解码原图。用户切换图片、视图滑动或动画期间暂停预加载。
+   @warning 非线程安全，仅在GUI线程调用
+ */
+
+ImagePrewarmer::ImagePrewarmer(ImageSourceModel *model, QObject *parent)
+    : QObject(parent)
+    , sourceModel(model)
+{
+    qCDebug(logImageViewer) << "ImagePrewarmer constructor called.";
+}
+
+ImagePrewarmer::~ImagePrewarmer()
+{
+    qCDebug(logImageViewer) << "ImagePrewarmer destructor called.";
+    stopInflight();
+}
+
+/**
+   @brief 图片列表重置，以 \a centerIndex 为中心重新开始预加载，
+    \a immediately 为 true 时不等待首张图片展示，立即开始预加载
+ */
+void ImagePrewarmer::reset(int centerIndex, bool immediately)
+{
+    qCDebug(logImageViewer) << "ImagePrewarmer::reset() called with center index:" << centerIndex;
+    stopInflight();
+    center = centerIndex;
+    step = 0;
+
+    // 低于2逻辑线程时图片信息同步加载，不进行预加载
+    if (!GlobalControl::enableMultiThread()) {
+        qCDebug(logImageViewer) << "Multi-threading disabled, skip prewarm.";
+        step = -1;
+        return;
+    }
+
+    schedule(immediately ? 0 : sc_StartDelay);
+}
+
+/**
+   @brief 用户切换到 \a centerIndex 索引的图片，暂停预加载，空闲后以新的索引为中心继续遍历
+ */
+void ImagePrewarmer::notifyNavigation(int centerIndex)
+{
+    if (isFinished()) {
+        return;
+    }
+
+    // 停止还未执行的任务，让出线程给当前图片加载
+    stopInflight();
+    if (center != centerIndex) {
+        // 已缓存的数据会被快速跳过
+        center = centerIndex;
+        step = 0;
+    }
+    schedule(sc_IdleDelay);
+}
+
+/**
+   @brief 设置是否暂停预加载 \a paused ，用于视图滑动、动画等期间
+ */
+void ImagePrewarmer::setPaused(bool paused)
+{
+    if (this->paused != paused) {
+        qCDebug(logImageViewer) << "ImagePrewarmer paused changed to:" << paused;
+        this->paused = paused;
+
+        if (paused) {
+            idleTimer.stop();
+        } else if (!isFinished()) {
+            schedule(sc_IdleDelay);
+        }
+    }
+}
+
+/**
+   @return 返回是否已完成所有图片的预加载
+ */
+bool ImagePrewarmer::isFinished() const
+{
+    return step < 0;
+}
+
+void ImagePrewarmer::timerEvent(QTimerEvent *event)
+{
+    if (idleTimer.timerId() == event->timerId()) {
+        idleTimer.stop();
+        prewarmNext();
+    }
+}
+
+/**
+   @brief 在 \a interval 毫秒后继续预加载
+ */
+void ImagePrewarmer::schedule(int interval)
+{
+    if (!paused) {
+        idleTimer.start(interval, this);
+    }
+}
+
+/**
+   @brief 停止加载中的任务，未执行的任务在 ImageInfo 析构时取消
+ */
+void ImagePrewarmer::stopInflight()
+{
+    idleTimer.stop();
+    qDeleteAll(inflight);
+    inflight.clear();
+}
+
+/**
+   @brief 按遍历顺序预加载图片信息，单次最多处理 sc_MaxBatchCount 张图片，加载中的任务不超过 sc_MaxInflight
+ */
+void ImagePrewarmer::prewarmNext()
+{
+    if (paused || isFinished()) {
+        return;
+    }
+
+    int processed = 0;
+    while (inflight.size() < sc_MaxInflight && processed < sc_MaxBatchCount) {
+        int index = nextIndex();
+        if (index < 0) {
+            qCDebug(logImageViewer) << "ImagePrewarmer finished.";
+            step = -1;
+            break;
+        }
+        processed++;
+
+        QUrl url = sourceModel->data(sourceModel->index(index), Types::ImageUrlRole).toUrl();
+        ImageInfo *info = new ImageInfo;
+        info->setLoadPriority(sc_PrewarmPriority);
+        info->setCacheThumbnail(qAbs(index - center) <= sc_KeepThumbnailRange);
+        info->setSource(url);
+
+        if (ImageInfo::Loading == info->status()) {
+            connect(info, &ImageInfo::statusChanged, this, [this, info]() { onInfoStatusChanged(info); });
+            inflight.append(info);
+        } else {
+            // 已缓存或无法加载，直接跳过
+            delete info;
+        }
+    }
+
+    // 本批次均为已缓存的数据，让出事件循环后继续
+    if (inflight.isEmpty() && !isFinished()) {
+        schedule(0);
+    }
+}
+
+/**
+   @return 返回下一个需要预加载的索引，由中心向两侧交替遍历，遍历完成返回 -1
+ */
+int ImagePrewarmer::nextIndex()
+{
+    const int count = sourceModel->rowCount();
+    const int maxDistance = qMax(center, count - 1 - center);
+
+    while (true) {
+        int distance = (step + 1) / 2;
+        if (distance > maxDistance) {
+            return -1;
+        }
+
+        int index = (step % 2) ? (center + distance) : (center - distance);
+        step++;
+        if (index >= 0 && index < count) {
+            return index;
+        }
+    }
+}
+
+/**
+   @brief 预加载的图片信息 \a info 状态变更，加载完成后继续预加载
+ */
+void ImagePrewarmer::onInfoStatusChanged(ImageInfo *info)
+{
+    if (ImageInfo::Loading == info->status()) {
+        return;
+    }
+
+    inflight.removeOne(info);
+    info->deleteLater();
+    schedule(0);
+}
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEPREWARMER_H
+#define IMAGEPREWARMER_H
+
+#include <QObject>
+#include <QBasicTimer>
+#include <QList>
+
+class ImageInfo;
+class ImageSourceModel;
+class ImagePrewarmer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImagePrewarmer(ImageSourceModel *model, QObject *parent = nullptr);
+    ~ImagePrewarmer() override;
+
+    void reset(int centerIndex, bool immediately = false);
+    void notifyNavigation(int centerIndex);
+    void setPaused(bool paused);
+    bool isFinished() const;
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    void schedule(int interval);
+    void stopInflight();
+    void prewarmNext();
+    int nextIndex();
+    void onInfoStatusChanged(ImageInfo *info);
+
+private:
+    ImageSourceModel *sourceModel { nullptr };
+    bool paused { false };
+    int center { 0 };        ///< 预加载的中心索引，由此向两侧遍历
+    int step { 0 };          ///< 当前遍历的步数
+    QList<ImageInfo *> inflight;  ///< 加载中的图片信息
+    QBasicTimer idleTimer;   ///< 空闲定时器，用户操作后延迟恢复预加载
+
+    Q_DISABLE_COPY(ImagePrewarmer)
+};
+
+#endif  // IMAGEPREWARMER_H
@@ -4,10 +4,18 @@
 
 #include "imageprovider.h"
 #include "unionimage/unionimage.h"
+#include "unionimage/imageutils.h"
+#include "unionimage/decoderpool.h"
 #include "imagedata/thumbnailcache.h"
+#include "imagedata/thumbnailpackstore.h"
+#include "imagedata/imagepathtable.h"
+#include "utils/startuptrace.h"
+#include "utils/tracerecorder.h"
 
 #include <QThread>
 #include <QThreadPool>
+#include <QUrl>
+#include <QSGTexture>
 #include <QRunnable>
 #include <QDebug>
 #include <QLoggingCategory>
@@ -15,34 +23,116 @@
 Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
 
 static const QString s_tagFrame = "#frame_";
+static const QString s_tagMipmap = "#mip_";
 
 /**
    @brief 解析图像处理器 \a id , 取得请求的文件路径 \a filePath 和 \a frameIndex
    @note QML 中使用 ImageProvider 取得图像信息，\a id 格式为 \b{图像路径#frame_帧号} ，例如 "/home/tmp.tif#frame_3" ，
         表示 tmp.tif 图像文件的第四帧图像，这个 id 在 QML 文件中组合。
+        url 解析结果通过 ImagePathTable 缓存，重复请求同一图像时无需再次构造 QUrl 。
  */
 static void parseProviderID(const QString &id, QString &filePath, int &frameIndex)
 {
-    // 从后向前查询索引标识
-    int index = id.lastIndexOf(QRegularExpression(QString("%1\\d+$").arg(s_tagFrame)));
+    // 从后向前查询索引标识，标识后须全部为数字
+    frameIndex = 0;
+    int index = id.lastIndexOf(s_tagFrame);
+    if (-1 != index) {
+        int frame = 0;
+        int pos = index + s_tagFrame.size();
+        bool valid = pos < id.size();
+        for (; valid && pos < id.size(); ++pos) {
+            const QChar ch = id.at(pos);
+            valid = ch.isDigit();
+            frame = frame * 10 + ch.digitValue();
+        }
+
+        if (valid) {
+            frameIndex = frame;
+        } else {
+            index = -1;
+        }
+    }
+
+    // 移除 "#frame_" 字段
+    const QString url = (-1 == index) ? id : id.left(index);
+    // 驻留表已满时直接解析 url ，图像不会被缓存
+    const quint32 pathId = ImagePathTable::internUrl(url);
+    filePath = pathId ? ImagePathTable::path(pathId) : QUrl(url).toLocalFile();
+}
+
+/**
+   @brief 解析并移除 \a id 尾部的 mipmap 层级标识，返回请求的层级，不包含层级标识时返回 0
+   @note 缩小显示大图时，QML 通过 \b{图像路径#frame_帧号#mip_层级} 请求低分辨率图像，
+        例如 "/home/tmp.png#frame_0#mip_2" ，表示 tmp.png 宽高均缩小为 1/4 的图像。
+ */
+static int parseMipmapLevel(QString &id)
+{
+    int index = id.lastIndexOf(s_tagMipmap);
     if (-1 == index) {
-        filePath = QUrl(id).toLocalFile();
-        frameIndex = 0;
-    } else {
-        // 移除 "#frame_" 字段
-        filePath = QUrl(id.left(index)).toLocalFile();
-        frameIndex = id.right(id.size() - index - s_tagFrame.size()).toInt();
+        return 0;
+    }
+
+    bool ok = false;
+    int level = id.mid(index + s_tagMipmap.size()).toInt(&ok);
+    if (!ok) {
+        return 0;
     }
+
+    // 移除 "#mip_" 字段
+    id.truncate(index);
+    return qBound(0, level, int(ProviderCache::MaxMipmapLevel));
+}
+
+/**
+   @return 使用 2x2 均值滤波将 \a image 缩小为原尺寸的 1/2 ，奇数边长时重复采样最后一行/列像素
+   @note 按预乘 ARGB32 格式处理，每次使用 0x00FF00FF 掩码同时计算两个通道，4 个 8 位数值之和不会溢出 16 位
+ */
+static QImage downsampleImage(const QImage &image)
+{
+    const QImage::Format format = image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    const QImage source = (image.format() == format) ? image : image.convertToFormat(format);
+    const int srcWidth = source.width();
+    const int srcHeight = source.height();
+
+    QImage result(qMax(1, srcWidth / 2), qMax(1, srcHeight / 2), format);
+    if (result.isNull()) {
+        qCWarning(logImageViewer) << "Failed to allocate mipmap image, source size:" << source.size();
+        return result;
+    }
+    result.setColorSpace(source.colorSpace());
+
+    for (int y = 0; y < result.height(); ++y) {
+        const QRgb *line0 = reinterpret_cast<const QRgb *>(source.constScanLine(qMin(y * 2, srcHeight - 1)));
+        const QRgb *line1 = reinterpret_cast<const QRgb *>(source.constScanLine(qMin(y * 2 + 1, srcHeight - 1)));
+        QRgb *dest = reinterpret_cast<QRgb *>(result.scanLine(y));
+
+        for (int x = 0; x < result.width(); ++x) {
+            const int x0 = x * 2;
+            const int x1 = qMin(x0 + 1, srcWidth - 1);
+            const quint32 p0 = line0[x0];
+            const quint32 p1 = line0[x1];
+            const quint32 p2 = line1[x0];
+            const quint32 p3 = line1[x1];
+
+            // 加 2 用于四舍五入
+            const quint32 rb = (p0 & 0x00FF00FF) + (p1 & 0x00FF00FF) + (p2 & 0x00FF00FF) + (p3 & 0x00FF00FF) + 0x00020002;
+            const quint32 ag = ((p0 >> 8) & 0x00FF00FF) + ((p1 >> 8) & 0x00FF00FF) + ((p2 >> 8) & 0x00FF00FF)
+                               + ((p3 >> 8) & 0x00FF00FF) + 0x00020002;
+            dest[x] = ((rb >> 2) & 0x00FF00FF) | (((ag >> 2) & 0x00FF00FF) << 8);
+        }
+    }
+
+    return result;
 }
 
 /**
-   @return 读取 \a imagePath 的图像数据并返回
+   @return 读取 \a imagePath 的图像数据并返回，启用解码辅助进程时在进程外解码
  */
 static QImage readNormalImage(const QString &imagePath)
 {
     QImage image;
     QString error;
-    if (!LibUnionImage_NameSpace::loadStaticImageFromFile(imagePath, image, error)) {
+    if (!DecoderPool::loadImage(imagePath, 0, QSize(), image, nullptr, error)) {
         qCWarning(logImageViewer) << "Failed to load image:" << imagePath << "Error:" << error;
     } else {
         qCDebug(logImageViewer) << "Successfully loaded image:" << imagePath << "Size:" << image.size();
@@ -55,16 +145,43 @@ static QImage readNormalImage(const QString &imagePath)
  */
 static QImage readMultiImage(const QString &imagePath, int frameIndex)
 {
-    // 重新设置图像读取类
-    QImageReader reader(imagePath);
-
-    if (reader.jumpToImage(frameIndex)) {
-        // 读取图像数据
-        return reader.read();
+    QImage image;
+    QString error;
+    if (!DecoderPool::loadImage(imagePath, frameIndex, QSize(), image, nullptr, error)) {
+        qCWarning(logImageViewer) << "Failed to load image:" << imagePath << "frame:" << frameIndex << "Error:" << error;
     }
-    return QImage();
+    return image;
 }
 
+/**
+   @class TracedTextureFactory
+   @brief 启用跟踪时包装图像纹理工厂，记录在渲染线程创建纹理的耗时
+   @note 纹理数据可能延迟到首次绑定时才提交到显卡，记录的耗时包含纹理创建及格式转换
+ */
+class TracedTextureFactory : public QQuickTextureFactory
+{
+public:
+    TracedTextureFactory(QQuickTextureFactory *factory, const QString &id)
+        : factory(factory)
+        , id(id)
+    {
+    }
+    ~TracedTextureFactory() override { delete factory; }
+
+    QSGTexture *createTexture(QQuickWindow *window) const override
+    {
+        TraceSpan span("image", "upload", id);
+        return factory->createTexture(window);
+    }
+    QSize textureSize() const override { return factory->textureSize(); }
+    int textureByteCount() const override { return factory->textureByteCount(); }
+    QImage image() const override { return factory->image(); }
+
+private:
+    QQuickTextureFactory *factory;
+    QString id;
+};
+
 /**
    @class AsyncImageResponse
    @brief 异步图像加载应答，在子线程完成图像加载后，通过 finished() 信号报告加载状态。
@@ -82,19 +199,27 @@ public:
     QString providerId;
     QSize requestedSize;
     QImage image;
+    qint64 enqueueTime { -1 };  // 启用跟踪时记录加入线程池的时间
 };
 
 AsyncImageResponse::AsyncImageResponse(AsyncImageProvider *p, const QString &i, const QSize &r)
     : provider(p), providerId(i), requestedSize(r)
 {
     setAutoDelete(false);
+    if (TraceRecorder::isEnabled()) {
+        enqueueTime = TraceRecorder::timestamp();
+    }
 }
 
 AsyncImageResponse::~AsyncImageResponse() { }
 
 QQuickTextureFactory *AsyncImageResponse::textureFactory() const
 {
-    return QQuickTextureFactory::textureFactoryForImage(image);
+    QQuickTextureFactory *factory = QQuickTextureFactory::textureFactoryForImage(image);
+    if (factory && TraceRecorder::isEnabled()) {
+        return new TracedTextureFactory(factory, providerId);
+    }
+    return factory;
 }
 
 /**
@@ -102,14 +227,31 @@ QQuickTextureFactory *AsyncImageResponse::textureFactory() const
  */
 void AsyncImageResponse::run()
 {
-    // 解析id，获取当前读取的文件和图片索引
+    if (enqueueTime >= 0) {
+        TraceRecorder::instance()->addComplete("image", "queue wait", enqueueTime, TraceRecorder::timestamp(), providerId);
+    }
+    TraceSpan requestSpan("image", "request", providerId);
+
+    // 解析id，获取当前读取的文件、图片索引和缩小层级
+    QString imageId = providerId;
+    int mipmapLevel = parseMipmapLevel(imageId);
     QString tempPath;
     int frameIndex;
-    parseProviderID(providerId, tempPath, frameIndex);
+    parseProviderID(imageId, tempPath, frameIndex);
 
-    qCDebug(logImageViewer) << "Loading image:" << tempPath << "frame:" << frameIndex
+    qCDebug(logImageViewer) << "Loading image:" << tempPath << "frame:" << frameIndex << "mipmap level:" << mipmapLevel
                             << "requested size:" << requestedSize;
 
+    if (mipmapLevel > 0) {
+        TraceSpan mipmapSpan("image", "mipmap", providerId);
+        image = provider->mipmapImageCached(tempPath, frameIndex, mipmapLevel);
+        mipmapSpan.finish();
+        requestSpan.finish();
+        StartupTrace::imageLoaded();
+        emit finished();
+        return;
+    }
+
     // 判断缓存中是否存在图片
     image = provider->imageCache.get(tempPath, frameIndex);
 
@@ -128,10 +270,13 @@ void AsyncImageResponse::run()
 
     // 调整图像大小
     if (!image.isNull() && image.size() != requestedSize && requestedSize.isValid()) {
+        TraceSpan scaleSpan("image", "scale", providerId);
         image = image.scaled(requestedSize);
         qCDebug(logImageViewer) << "Scaled image to:" << requestedSize;
     }
 
+    requestSpan.finish();
+    StartupTrace::imageLoaded();
     emit finished();
 }
 
@@ -186,11 +331,12 @@ void ProviderCache::rotateImageCached(int angle, const QString &imagePath, int f
             qCDebug(logImageViewer) << "Rotated image:" << imagePath << "angle:" << lastRotation;
         }
 
-        // 更新图片缓存
+        // 更新图片缓存，已生成的缩小层级失效
         imageCache.add(imagePath, frameIndex, image);
+        removeMipmapCache(imagePath);
 
         // 同样更新缩略图缓存
-        QImage tmpImage = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        QImage tmpImage = ThumbnailCache::scaledThumbnail(image);
         ThumbnailCache::instance()->add(imagePath, frameIndex, tmpImage);
     } else {
         qCWarning(logImageViewer) << "Failed to rotate image - image is null:" << imagePath;
@@ -205,12 +351,14 @@ void ProviderCache::removeImageCache(const QString &imagePath)
 {
     qCDebug(logImageViewer) << "Removing image cache:" << imagePath;
     // 直接缓存的图像信息较少，遍历查询是否包含对应的图片
+    const quint32 pathId = ImagePathTable::find(imagePath);
     QList<ThumbnailCache::Key> keys = imageCache.keys();
     for (const ThumbnailCache::Key &key : keys) {
-        if (key.first == imagePath) {
-            imageCache.remove(key.first, key.second);
+        if (key.pathId == pathId) {
+            imageCache.remove(key);
         }
     }
+    removeMipmapCache(imagePath);
     qCDebug(logImageViewer) << "ProviderCache::removeImageCache finished";
 }
 
@@ -218,13 +366,17 @@ void ProviderCache::renameImageCache(const QString &oldPath, const QString &newP
 {
     qCDebug(logImageViewer) << "Renaming image cache:" << oldPath << "->" << newPath;
     // 直接缓存的图像信息较少，遍历查询是否包含对应的图片
+    const quint32 oldPathId = ImagePathTable::find(oldPath);
+    const quint32 newPathId = ImagePathTable::intern(newPath);
     QList<ThumbnailCache::Key> keys = imageCache.keys();
     for (const ThumbnailCache::Key &key : keys) {
-        if (key.first == oldPath) {
-            QImage image = imageCache.take(key.first, key.second);
-            imageCache.add(newPath, key.second, image);
+        if (key.pathId == oldPathId) {
+            QImage image = imageCache.take(key);
+            imageCache.add(ThumbnailCache::Key(newPathId, key.frameIndex, key.tier), image);
         }
     }
+    // 缩小层级可按需重新生成，无需迁移
+    removeMipmapCache(oldPath);
     qCDebug(logImageViewer) << "ProviderCache::renameImageCache finished";
 }
 
@@ -236,11 +388,95 @@ void ProviderCache::clearCache()
     qCDebug(logImageViewer) << "ProviderCache::clearCache called";
     QMutexLocker _locker(&mutex);
     imageCache.clear();
+    mipmapCache.clear();
     lastRotatePath.clear();
     lastRotateImage = QImage();
     qCDebug(logImageViewer) << "ProviderCache::clearCache finished";
 }
 
+/**
+   @return 返回缓存的 \a imagePath 第 \a frameIndex 帧图像，不存在时读取并缓存，即使是异常图片
+ */
+QImage ProviderCache::loadImageCached(const QString &imagePath, int frameIndex)
+{
+    QImage image = imageCache.get(imagePath, frameIndex);
+    if (image.isNull()) {
+        qCDebug(logImageViewer) << "Image not found in cache, loading image for:" << imagePath << "frame:" << frameIndex;
+        image = frameIndex ? readMultiImage(imagePath, frameIndex) : readNormalImage(imagePath);
+        imageCache.add(imagePath, frameIndex, image);
+    }
+    return image;
+}
+
+/**
+   @brief 取得 \a imagePath 第 \a frameIndex 帧图像缩小 \a level 级(宽高各缩小为 1/2^level)后的图像，
+        用于缩小显示大图时降低每帧绘制的缩放开销。
+   @note 各层级在首次请求时由上一层级通过 2x2 均值滤波逐级生成并缓存，在图像加载线程中调用。
+        缩小层级跟随原图缓存淘汰，图像旋转、删除、重命名时清除。
+ */
+QImage ProviderCache::mipmapImageCached(const QString &imagePath, int frameIndex, int level)
+{
+    if (level <= 0) {
+        return loadImageCached(imagePath, frameIndex);
+    }
+
+    const ThumbnailCache::Key key = ThumbnailCache::toFindKey(imagePath, frameIndex);
+    QMutexLocker _locker(&mutex);
+    QList<QImage> levels = mipmapCache.value(key);
+    _locker.unlock();
+
+    if (levels.size() >= level) {
+        qCDebug(logImageViewer) << "Using cached mipmap:" << imagePath << "frame:" << frameIndex << "level:" << level;
+        return levels.at(level - 1);
+    }
+
+    // 从已缓存的最小层级开始逐级缩小，生成过程不持有锁
+    QImage image = levels.isEmpty() ? loadImageCached(imagePath, frameIndex) : levels.last();
+    while (levels.size() < level && !image.isNull()) {
+        // 已缩小至单个像素，无需继续
+        if (image.width() <= 1 && image.height() <= 1) {
+            break;
+        }
+
+        image = downsampleImage(image);
+        levels.append(image);
+    }
+    qCDebug(logImageViewer) << "Generated mipmap:" << imagePath << "frame:" << frameIndex << "level:" << levels.size()
+                            << "size:" << image.size();
+
+    _locker.relock();
+    if (imageCache.contains(key) && levels.size() > mipmapCache.value(key).size()) {
+        mipmapCache.insert(key, levels);
+    }
+
+    // 移除原图已被淘汰的层级数据
+    for (auto itr = mipmapCache.begin(); itr != mipmapCache.end();) {
+        if (imageCache.contains(itr.key())) {
+            ++itr;
+        } else {
+            itr = mipmapCache.erase(itr);
+        }
+    }
+
+    return image;
+}
+
+/**
+   @brief 移除文件路径为 \a imagePath 的所有缩小层级缓存
+ */
+void ProviderCache::removeMipmapCache(const QString &imagePath)
+{
+    const quint32 pathId = ImagePathTable::find(imagePath);
+    QMutexLocker _locker(&mutex);
+    for (auto itr = mipmapCache.begin(); itr != mipmapCache.end();) {
+        if (itr.key().pathId == pathId) {
+            itr = mipmapCache.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
 /**
    @brief 预载图片数据并缓存
  */
@@ -321,11 +557,24 @@ ImageProvider::~ImageProvider()
 QImage ImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
     qCDebug(logImageViewer) << "ImageProvider::requestImage called for id:" << id << "requested size:" << requestedSize;
-    // 解析id，获取当前读取的文件和图片索引
+    TraceSpan requestSpan("image", "request", id);
+    // 解析id，获取当前读取的文件、图片索引和缩小层级
+    QString imageId = id;
+    int mipmapLevel = parseMipmapLevel(imageId);
     QString tempPath;
     int frameIndex;
-    parseProviderID(id, tempPath, frameIndex);
-    qCDebug(logImageViewer) << "Parsing provider ID: tempPath =" << tempPath << ", frameIndex =" << frameIndex;
+    parseProviderID(imageId, tempPath, frameIndex);
+    qCDebug(logImageViewer) << "Parsing provider ID: tempPath =" << tempPath << ", frameIndex =" << frameIndex
+                            << ", mipmapLevel =" << mipmapLevel;
+
+    if (mipmapLevel > 0) {
+        QImage mipmap = mipmapImageCached(tempPath, frameIndex, mipmapLevel);
+        if (size) {
+            *size = mipmap.size();
+        }
+        StartupTrace::imageLoaded();
+        return mipmap;
+    }
 
     // 判断缓存中是否存在图片
     QImage image = imageCache.get(tempPath, frameIndex);
@@ -353,10 +602,13 @@ QImage ImageProvider::requestImage(const QString &id, QSize *size, const QSize &
 
     // 调整图像大小
     if (!image.isNull() && image.size() != requestedSize && requestedSize.isValid()) {
+        TraceSpan scaleSpan("image", "scale", id);
         image = image.scaled(requestedSize);
         qCDebug(logImageViewer) << "Scaled image to:" << requestedSize;
     }
 
+    requestSpan.finish();
+    StartupTrace::imageLoaded();
     qCDebug(logImageViewer) << "ImageProvider::requestImage finished for id:" << id;
     return image;
 }
@@ -386,9 +638,9 @@ ThumbnailProvider::~ThumbnailProvider()
         \a id 格式为 \b{图像路径#frame_帧号} ，例如 "/home/tmp.tif#frame_3" ，
         表示 tmp.tif 图像文件的第四帧图像缩略图，这个 id 在 QML 文件中组合。
    @param id            图像索引(0 ~ frameCount - 1)
-   @param size          图像的原始大小，有需要时可传出
-   @param requestedSize 请求的图像大小
-   @return 读取的图像数据
+   @param size          返回的缩略图大小，有需要时可传出
+   @param requestedSize 请求的图像大小(已计算设备像素比)，用于选取缩略图层级，无效时使用默认层级
+   @return 读取的缩略图数据，高分屏下返回较大层级的缩略图，低分屏使用较小层级以节省内存
 
    @note 当前需要读取多页图的图像格式仅为 *.tif ，通过默认 QImageReader 即可读取，
         后续其它格式考虑在 LibUnionImage_NameSpace 中添加新的接口。
@@ -396,6 +648,7 @@ ThumbnailProvider::~ThumbnailProvider()
 QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
     qCDebug(logImageViewer) << "ThumbnailProvider::requestImage called for id:" << id << "requested size:" << requestedSize;
+    TraceSpan span("thumbnail", "request", id);
     // 解析id，获取当前读取的文件和图片索引
     QString tempPath;
     int frameIndex;
@@ -404,32 +657,36 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
     qCDebug(logImageViewer) << "Requesting thumbnail:" << tempPath << "frame:" << frameIndex
                             << "requested size:" << requestedSize;
 
-    // 判断缓存中是否存在缩略图
-    if (ThumbnailCache::instance()->contains(tempPath, frameIndex)) {
-        qCDebug(logImageViewer) << "Using cached thumbnail:" << tempPath << "frame:" << frameIndex;
-        return ThumbnailCache::instance()->get(tempPath, frameIndex);
-    }
+    // 查询缓存中对应层级的缩略图，不存在时由更大层级的缩略图生成，均不存在时读取并缓存
+    const int tier = ThumbnailCache::tierForSize(requestedSize);
+    QImage thumbnail = ThumbnailCache::instance()->getOrInsert(tempPath, frameIndex, tier, [&]() {
+        if (frameIndex) {
+            return readMultiImage(tempPath, frameIndex);
+        }
 
-    QImage image;
-    if (frameIndex) {
-        image = readMultiImage(tempPath, frameIndex);
-    } else {
-        image = readNormalImage(tempPath);
-    }
-    // 不存在缩略图信息，缓存图片
-    QImage tmpImage = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-    ThumbnailCache::instance()->add(tempPath, frameIndex, tmpImage);
+        // 内存中不存在时依次读取目录打包缓存、磁盘中有效的缩略图(freedesktop 缩略图缓存)
+        // 打包缓存仅保存默认层级大小，无法满足较大层级
+        QImage image;
+        QSize sourceSize;
+        if (ThumbnailCache::LargeTier != tier && ThumbnailPackStore::find(tempPath, image, sourceSize)) {
+            qCDebug(logImageViewer) << "Using packed thumbnail:" << tempPath;
+        } else if (!(image = Libutils::image::loadCachedThumbnail(tempPath, &sourceSize)).isNull()) {
+            qCDebug(logImageViewer) << "Using disk cached thumbnail:" << tempPath;
+            ThumbnailPackStore::insert(tempPath, image, sourceSize);
+        } else {
+            image = readNormalImage(tempPath);
+            ThumbnailPackStore::insert(tempPath, image, image.size());
+            Libutils::image::saveCachedThumbnailAsync(tempPath, image);
+        }
+        return image;
+    });
 
     if (size) {
-        *size = image.size();
-    }
-    // 调整图像大小
-    if (!image.isNull() && image.size() != requestedSize && requestedSize.isValid()) {
-        image = image.scaled(requestedSize);
-        qCDebug(logImageViewer) << "Scaled thumbnail to:" << requestedSize;
+        *size = thumbnail.size();
     }
-    qCDebug(logImageViewer) << "ThumbnailProvider::requestImage finished for id:" << id;
-    return image;
+    qCDebug(logImageViewer) << "ThumbnailProvider::requestImage finished for id:" << id << "tier:" << tier
+                            << "size:" << thumbnail.size();
+    return thumbnail;
 }
 
 /**
@@ -11,6 +11,7 @@
 #include <QImageReader>
 #include <QImage>
 #include <QMutex>
+#include <QHash>
 
 class ProviderCache
 {
@@ -25,9 +26,16 @@ public:
 
     virtual void preloadImage(const QString &filePath);
 
+    static const int MaxMipmapLevel = 6;  ///< 最大 mipmap 层级，即原图的 1/64
+
 protected:
+    QImage loadImageCached(const QString &imagePath, int frameIndex);
+    QImage mipmapImageCached(const QString &imagePath, int frameIndex, int level);
+    void removeMipmapCache(const QString &imagePath);
+
     QMutex mutex;
     ThumbnailCache imageCache;  ///< 图像数据缓存(已存在锁保护)
+    QHash<ThumbnailCache::Key, QList<QImage>> mipmapCache;  ///< 图像缩小层级缓存，下标 0 为 1/2 尺寸(mutex 保护)
     QString lastRotatePath;     ///< 缓存的旋转文件路径
     QImage lastRotateImage;     ///< 缓存的旋转图像信息
     int lastRotation { 0 };     ///< 缓存的旋转角度
@@ -0,0 +1,298 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagesortkeyloader.h"
+#include "types.h"
+#include "imageinfoindex.h"
+#include "unionimage/imageheaderreader.h"
+#include "utils/tracerecorder.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static const int sc_StatBatchSize = 512;    // 仅读取文件属性时每个任务处理的文件数量
+static const int sc_HeaderBatchSize = 64;   // 读取文件头时每个任务处理的文件数量
+
+/**
+   @brief 读取一批图片排序键的任务
+ */
+class SortKeyRunnable : public QRunnable
+{
+public:
+    SortKeyRunnable(ImageSortKeyLoader *loader, int generation, const QList<QUrl> &files, bool readHeader, int notifyOrder = -1)
+        : loader(loader)
+        , generation(generation)
+        , files(files)
+        , readHeader(readHeader)
+        , notifyOrder(notifyOrder)
+    {
+    }
+
+    void run() override;
+
+private:
+    ImageSortKeyLoader *loader;
+    int generation;
+    QList<QUrl> files;
+    bool readHeader;
+    int notifyOrder;   ///< 不为 -1 时为 loadFiles() 发起的读取，完成后通知读取的文件，不随 cancel() 取消
+};
+
+void SortKeyRunnable::run()
+{
+    TraceSpan span("sort", "keys", QString::number(files.size()));
+    QList<QUrl> loadedFiles;
+    QVector<ImageSortKeyLoader::SortKey> keys;
+    loadedFiles.reserve(files.size());
+    keys.reserve(files.size());
+
+    const bool notifyFiles = -1 != notifyOrder;
+    for (const QUrl &url : files) {
+        if (!notifyFiles && loader->isCanceled(generation)) {
+            break;
+        }
+
+        const QString localPath = url.toLocalFile();
+        const QFileInfo info(localPath);
+        ImageSortKeyLoader::SortKey key;
+        key.modifiedTime = info.lastModified().toMSecsSinceEpoch();
+        key.fileSize = info.size();
+        key.captureTime = key.modifiedTime;
+
+        if (readHeader) {
+            // 优先使用持久化索引中的拍摄时间及大小，文件未变更时无需读取文件头
+            ImageInfoIndex::Record record;
+            ImageHeaderReader::HeaderInfo header;
+            if (ImageInfoIndex::instance()->find(localPath, 0, record)) {
+                if (0 != record.captureTime) {
+                    key.captureTime = record.captureTime;
+                }
+                key.pixelCount = qint64(record.size.width()) * record.size.height();
+            } else if (ImageHeaderReader::read(localPath, header)) {
+                if (0 != header.captureTime) {
+                    key.captureTime = header.captureTime;
+                }
+                key.pixelCount = qint64(header.size.width()) * header.size.height();
+            }
+            key.headerRead = true;
+        }
+
+        loadedFiles.append(url);
+        keys.append(key);
+    }
+
+    if (notifyFiles) {
+        loader->postFiles(generation, notifyOrder, loadedFiles, keys);
+    } else {
+        loader->postKeys(generation, loadedFiles, keys);
+    }
+}
+
+/**
+   @class ImageSortKeyLoader
+   @brief 在后台线程分批读取图片的排序键(修改时间、文件大小、拍摄时间及像素数)，
+        所有图片读取完成后通过 keysReady() 通知，由数据模型一次性重新排序。
+   @note 拍摄时间及像素数优先从持久化索引 ImageInfoIndex 读取，未命中时仅读取文件头，不解码图像数据。
+        读取的排序键缓存至 clear() 调用，切换排序方式时仅读取缺失的排序键，文件变更时通过 invalidate() 清除对应的排序键。
+        文件夹新增的图片通过 loadFiles() 单独读取，完成后通过 filesReady() 通知，以插入至当前顺序中。
+ */
+
+ImageSortKeyLoader::ImageSortKeyLoader(QObject *parent)
+    : QObject(parent)
+    , localPoolPtr(new QThreadPool)
+{
+    localPoolPtr->setMaxThreadCount(2);
+}
+
+ImageSortKeyLoader::~ImageSortKeyLoader()
+{
+    cancel();
+    localPoolPtr->waitForDone();
+}
+
+/**
+   @brief 读取图片列表 \a files (url路径) 按 \a order 排序所需的排序键，将取消之前未完成的读取
+ */
+void ImageSortKeyLoader::start(const QList<QUrl> &files, int order)
+{
+    cancel();
+    if (Types::SortByName == order) {
+        return;
+    }
+
+    const bool readHeader = needHeader(order);
+    QList<QUrl> missingFiles;
+    for (const QUrl &url : files) {
+        auto itr = keyCache.constFind(url);
+        if (itr == keyCache.constEnd() || (readHeader && !itr->headerRead)) {
+            missingFiles.append(url);
+        }
+    }
+
+    loadingOrder = order;
+    const int generation = currentGeneration.loadAcquire();
+    qCDebug(logImageViewer) << "Loading sort keys, order:" << order << "missing:" << missingFiles.size() << "of" << files.size();
+
+    if (missingFiles.isEmpty()) {
+        // 排序键均已缓存，异步通知以保持与后台读取一致的调用顺序
+        runningTasks = 1;
+        postKeys(generation, {}, {});
+        return;
+    }
+
+    const int batchSize = readHeader ? sc_HeaderBatchSize : sc_StatBatchSize;
+    runningTasks = (missingFiles.size() + batchSize - 1) / batchSize;
+    for (int i = 0; i < missingFiles.size(); i += batchSize) {
+        localPoolPtr->start(new SortKeyRunnable(this, generation, missingFiles.mid(i, batchSize), readHeader));
+    }
+}
+
+/**
+   @brief 读取新增图片 \a files (url路径) 按 \a order 排序所需的排序键，完成后通过 filesReady() 通知，
+    不影响 start() 发起的读取，仅在 clear() 后丢弃
+ */
+void ImageSortKeyLoader::loadFiles(const QList<QUrl> &files, int order)
+{
+    if (Types::SortByName == order || files.isEmpty()) {
+        return;
+    }
+
+    const bool readHeader = needHeader(order);
+    const int batchSize = readHeader ? sc_HeaderBatchSize : sc_StatBatchSize;
+    const int generation = currentGeneration.loadAcquire();
+    qCDebug(logImageViewer) << "Loading sort keys of added files, order:" << order << "count:" << files.size();
+    for (int i = 0; i < files.size(); i += batchSize) {
+        localPoolPtr->start(new SortKeyRunnable(this, generation, files.mid(i, batchSize), readHeader, order));
+    }
+}
+
+/**
+   @brief 取消当前的读取，后台任务将尽快退出，已读取的排序键仍保留在缓存中
+ */
+void ImageSortKeyLoader::cancel()
+{
+    currentGeneration.ref();
+    runningTasks = 0;
+}
+
+/**
+   @brief 取消当前的读取并清空缓存的排序键，用于切换图片列表
+ */
+void ImageSortKeyLoader::clear()
+{
+    cancel();
+    cacheGeneration = currentGeneration.loadAcquire();
+    keyCache.clear();
+}
+
+/**
+   @brief 清除图片 \a file 缓存的排序键，用于文件内容或修改时间变更，下次排序时重新读取
+ */
+void ImageSortKeyLoader::invalidate(const QUrl &file)
+{
+    keyCache.remove(file);
+}
+
+/**
+   @return 是否存在未完成的读取
+ */
+bool ImageSortKeyLoader::isLoading() const
+{
+    return runningTasks > 0;
+}
+
+/**
+   @brief 取得图片 \a file 按 \a order 排序的排序键 \a value
+   @return 是否已读取排序键
+ */
+bool ImageSortKeyLoader::sortValue(const QUrl &file, int order, qint64 &value) const
+{
+    auto itr = keyCache.constFind(file);
+    if (itr == keyCache.constEnd() || (needHeader(order) && !itr->headerRead)) {
+        return false;
+    }
+
+    switch (order) {
+        case Types::SortByCaptureTime:
+            value = itr->captureTime;
+            return true;
+        case Types::SortByModifiedTime:
+            value = itr->modifiedTime;
+            return true;
+        case Types::SortByFileSize:
+            value = itr->fileSize;
+            return true;
+        case Types::SortByPixelCount:
+            value = itr->pixelCount;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+   @return 排序方式 \a order 是否需要读取文件头
+ */
+bool ImageSortKeyLoader::needHeader(int order)
+{
+    return Types::SortByCaptureTime == order || Types::SortByPixelCount == order;
+}
+
+bool ImageSortKeyLoader::isCanceled(int generation) const
+{
+    return generation != currentGeneration.loadAcquire();
+}
+
+/**
+   @brief 后台任务发送读取的排序键，在主线程合并至缓存，所有任务完成后发送 keysReady()
+ */
+void ImageSortKeyLoader::postKeys(int generation, const QList<QUrl> &files, const QVector<SortKey> &keys)
+{
+    QMetaObject::invokeMethod(
+            this,
+            [this, generation, files, keys]() {
+                // 已取消的读取结果仍可缓存，文件信息不随排序方式变更
+                if (generation >= cacheGeneration) {
+                    for (int i = 0; i < files.size(); ++i) {
+                        keyCache.insert(files.at(i), keys.at(i));
+                    }
+                }
+
+                if (isCanceled(generation)) {
+                    return;
+                }
+
+                if (0 == --runningTasks) {
+                    qCDebug(logImageViewer) << "Sort keys ready, order:" << loadingOrder;
+                    Q_EMIT keysReady(loadingOrder);
+                }
+            },
+            Qt::QueuedConnection);
+}
+
+/**
+   @brief loadFiles() 的后台任务发送读取的排序键，在主线程合并至缓存并发送 filesReady() ，
+    清空缓存后丢弃
+ */
+void ImageSortKeyLoader::postFiles(int generation, int order, const QList<QUrl> &files, const QVector<SortKey> &keys)
+{
+    QMetaObject::invokeMethod(
+            this,
+            [this, generation, order, files, keys]() {
+                if (generation < cacheGeneration) {
+                    return;
+                }
+
+                for (int i = 0; i < files.size(); ++i) {
+                    keyCache.insert(files.at(i), keys.at(i));
+                }
+                Q_EMIT filesReady(files, order);
+            },
+            Qt::QueuedConnection);
+}
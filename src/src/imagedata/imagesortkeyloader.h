@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGESORTKEYLOADER_H
+#define IMAGESORTKEYLOADER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QHash>
+#include <QUrl>
+#include <QVector>
+#include <QScopedPointer>
+
+class QThreadPool;
+
+class ImageSortKeyLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageSortKeyLoader(QObject *parent = nullptr);
+    ~ImageSortKeyLoader() override;
+
+    void start(const QList<QUrl> &files, int order);
+    void loadFiles(const QList<QUrl> &files, int order);
+    void cancel();
+    void clear();
+    void invalidate(const QUrl &file);
+    bool isLoading() const;
+    bool sortValue(const QUrl &file, int order, qint64 &value) const;
+
+    // 图片列表的排序键均已读取完成
+    Q_SIGNAL void keysReady(int order);
+    // 通过 loadFiles() 读取的图片 files 的排序键已读取完成
+    Q_SIGNAL void filesReady(const QList<QUrl> &files, int order);
+
+private:
+    friend class SortKeyRunnable;
+
+    /**
+       @brief 图片的排序键
+     */
+    struct SortKey
+    {
+        qint64 modifiedTime = 0;  ///< 文件修改时间(ms)
+        qint64 fileSize = 0;      ///< 文件大小
+        qint64 captureTime = 0;   ///< 拍摄时间(ms)，无拍摄时间时为文件修改时间
+        qint64 pixelCount = 0;    ///< 图片像素数
+        bool headerRead = false;  ///< 是否已读取文件头，拍摄时间及像素数仅在读取文件头后有效
+    };
+
+    static bool needHeader(int order);
+    bool isCanceled(int generation) const;
+    void postKeys(int generation, const QList<QUrl> &files, const QVector<SortKey> &keys);
+    void postFiles(int generation, int order, const QList<QUrl> &files, const QVector<SortKey> &keys);
+
+private:
+    QAtomicInt currentGeneration { 0 };   ///< 读取代数，重新读取或取消时递增，丢弃过期的结果
+    int cacheGeneration { 0 };            ///< 清空缓存时的读取代数，之前读取的结果不再缓存
+    int loadingOrder { 0 };               ///< 当前读取的排序方式
+    int runningTasks { 0 };               ///< 当前读取未完成的任务数
+    QHash<QUrl, SortKey> keyCache;        ///< 已读取的排序键，仅在主线程访问
+    QScopedPointer<QThreadPool> localPoolPtr;
+
+    Q_DISABLE_COPY(ImageSortKeyLoader)
+};
+
+#endif  // IMAGESORTKEYLOADER_H
@@ -3,16 +3,23 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "imagesourcemodel.h"
+
+#include <QDir>
 #include <QLoggingCategory>
 
+#include <algorithm>
+#include <numeric>
+
 Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
 
 /**
    @class ImageSourceModel
    @brief 图片数据模型，提供缩略图/图片展示的图片数据信息。
 
-   @note 此数据模型仅存储需进行展示的图像文件 url 路径列表，
+   @note 此数据模型仅存储需进行展示的图像文件路径列表，
     详细的图像文件信息使用 ImageInfo 进行获取。
+    路径以文件夹路径表及文件名紧凑存储，url 在访问数据时生成。
+    递归浏览文件夹时，图片按文件夹分组，文件夹按相对根目录的路径排序，文件夹内按文件名排序。
  */
 
 ImageSourceModel::ImageSourceModel(QObject *parent)
@@ -48,8 +55,8 @@ QVariant ImageSourceModel::data(const QModelIndex &index, int role) const
 
     switch (role) {
         case Types::ImageUrlRole:
-            qCDebug(logImageViewer) << "Returning ImageUrlRole for row:" << index.row() << "value:" << imageUrlList.at(index.row());
-            return imageUrlList.at(index.row());
+            qCDebug(logImageViewer) << "Returning ImageUrlRole for row:" << index.row();
+            return files.url(index.row());
         default:
             qCDebug(logImageViewer) << "Unknown role:" << role;
             break;
@@ -61,6 +68,7 @@ QVariant ImageSourceModel::data(const QModelIndex &index, int role) const
 /**
    @brief 设置数据索引 \a index 和数据类型 \a role 所指向的数据为 \a value
    @return 是否设置数据成功
+   @note 为文件名顺序时，重命名的图片将移动至新文件名所在的位置，保持后续插入时二分查找的顺序
  */
 bool ImageSourceModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
@@ -72,9 +80,17 @@ bool ImageSourceModel::setData(const QModelIndex &index, const QVariant &value,
 
     switch (role) {
         case Types::ImageUrlRole:
-            imageUrlList.replace(index.row(), value.toUrl());
+            files.replace(index.row(), value.toUrl().toLocalFile());
+            sortKeys[files.slot(index.row())].reset();
+            if (isTreeMode()) {
+                ensureDirectoryKey(files.directoryId(index.row()));
+            }
             qCDebug(logImageViewer) << "ImageUrlRole changed for row:" << index.row() << "new value:" << value.toUrl();
             Q_EMIT dataChanged(index, index);
+            // 保持列表顺序时重命名的图片位置不变
+            if (nameOrder && !listOrder) {
+                moveRowByName(index.row());
+            }
             return true;
         default:
             qCDebug(logImageViewer) << "Unknown role:" << role;
@@ -90,8 +106,8 @@ bool ImageSourceModel::setData(const QModelIndex &index, const QVariant &value,
 int ImageSourceModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    qCDebug(logImageViewer) << "ImageSourceModel::rowCount() called. Count:" << imageUrlList.count();
-    return imageUrlList.count();
+    qCDebug(logImageViewer) << "ImageSourceModel::rowCount() called. Count:" << files.size();
+    return files.size();
 }
 
 /**
@@ -105,34 +121,551 @@ int ImageSourceModel::indexForImagePath(const QUrl &file)
         return -1;
     }
 
-    int index = imageUrlList.indexOf(file);
+    int index = files.indexOf(file.toLocalFile());
     qCDebug(logImageViewer) << "Index for file:" << file << "is:" << index;
     return index;
 }
 
 /**
-   @brief 设置图像文件列表，重置模型数据
+   @brief 设置图像文件列表 \a filePaths (url路径)，重置模型数据，并退出递归浏览
+   @note \a keepListOrder 为 true 时 \a filePaths 为用户指定的图片列表，未按文件名排序，
+    按文件名排序时保持列表顺序，且不再合并插入图片
  */
-void ImageSourceModel::setImageFiles(const QList<QUrl> &files)
+void ImageSourceModel::setImageFiles(const QStringList &filePaths, bool keepListOrder)
 {
-    qCDebug(logImageViewer) << "ImageSourceModel::setImageFiles() called with" << files.count() << "files.";
+    qCDebug(logImageViewer) << "ImageSourceModel::setImageFiles() called with" << filePaths.count() << "files.";
     beginResetModel();
-    imageUrlList = files;
+    files.clear();
+    files.reserve(filePaths.size());
+    QString dirPath;
+    QString fileName;
+    for (const QString &path : filePaths) {
+        ImageFileTable::splitPath(QUrl(path).toLocalFile(), dirPath, fileName);
+        files.append(files.addDirectory(dirPath), fileName);
+    }
+    // 排序键在首次比较时生成
+    sortKeys.clear();
+    sortKeys.resize(static_cast<size_t>(files.slotCount()));
+    sortValues.clear();
+    nameOrder = true;
+    listOrder = keepListOrder;
+    treeRoot.clear();
+    dirKeys.clear();
     endResetModel();
     qCDebug(logImageViewer) << "Model reset complete.";
 }
 
+/**
+   @brief 按文件名自然顺序将已排序的文件列表 \a sortedFiles (url路径) 合并至当前(已排序的)模型数据，
+    已存在的文件将被忽略，连续插入的文件仅触发一次行插入通知
+   @note 用于异步扫描文件夹时分批次追加图片，递归浏览时按文件夹分别合并
+ */
+void ImageSourceModel::insertImageFiles(const QStringList &sortedFiles)
+{
+    qCDebug(logImageViewer) << "ImageSourceModel::insertImageFiles() called with" << sortedFiles.count() << "files.";
+    if (sortedFiles.isEmpty()) {
+        return;
+    }
+    if (listOrder) {
+        qCWarning(logImageViewer) << "Insert files while keeping list order, ignored.";
+        return;
+    }
+
+    // 按其它方式排序时先恢复文件名顺序，由调用方在插入后重新排序
+    sortByName();
+
+    // 扫描结果通常位于同一文件夹，按连续的文件夹分组合并
+    int begin = 0;
+    while (begin < sortedFiles.size()) {
+        QString dirPath;
+        QString fileName;
+        ImageFileTable::splitPath(QUrl(sortedFiles.at(begin)).toLocalFile(), dirPath, fileName);
+
+        QStringList names { fileName };
+        int end = begin + 1;
+        for (; end < sortedFiles.size(); ++end) {
+            QString nextDir;
+            ImageFileTable::splitPath(QUrl(sortedFiles.at(end)).toLocalFile(), nextDir, fileName);
+            if (nextDir != dirPath) {
+                break;
+            }
+            names.append(fileName);
+        }
+
+        if (isTreeMode()) {
+            insertDirectory(dirPath, names);
+        } else {
+            // 每个文件仅生成一次排序键，比较时仅在排序键相同时比较完整文件名
+            std::vector<QCollatorSortKey> newKeys;
+            newKeys.reserve(static_cast<size_t>(names.size()));
+            for (const QString &name : names) {
+                newKeys.push_back(nameCollator.sortKey(name));
+            }
+            mergeNames(0, files.size(), files.addDirectory(dirPath), names, newKeys);
+        }
+        begin = end;
+    }
+    qCDebug(logImageViewer) << "Insert complete, count:" << files.size();
+}
+
+/**
+   @brief 按其它方式排序时，将文件列表 \a filePaths (url路径) 按各自的排序键 \a values 插入至当前顺序中对应的位置，
+    排序键相同时按文件名顺序，已存在的文件将被忽略
+   @note 用于文件夹新增图片，避免恢复文件名顺序后重新排序整个列表
+ */
+void ImageSourceModel::insertImageFilesByValues(const QStringList &filePaths, const std::vector<qint64> &values)
+{
+    qCDebug(logImageViewer) << "ImageSourceModel::insertImageFilesByValues() called with" << filePaths.count() << "files.";
+    if (nameOrder || listOrder) {
+        qCWarning(logImageViewer) << "Insert by values while in name or list order, ignored.";
+        return;
+    }
+    if (values.size() != static_cast<size_t>(filePaths.size())) {
+        qCWarning(logImageViewer) << "Insert values mismatch, values:" << values.size() << "files:" << filePaths.size();
+        return;
+    }
+
+    // 先添加文件夹，文件夹序号仅计算一次
+    QStringList dirPaths;
+    QStringList names;
+    for (const QString &path : filePaths) {
+        QString dirPath;
+        QString fileName;
+        ImageFileTable::splitPath(QUrl(path).toLocalFile(), dirPath, fileName);
+        const quint32 dirId = files.addDirectory(dirPath);
+        if (isTreeMode()) {
+            ensureDirectoryKey(dirId);
+        }
+        dirPaths.append(dirPath);
+        names.append(fileName);
+    }
+    const std::vector<int> dirRanks = directoryRanks();
+
+    for (int i = 0; i < names.size(); ++i) {
+        if (-1 != files.indexOf(QUrl(filePaths.at(i)).toLocalFile())) {
+            continue;
+        }
+
+        const quint32 dirId = files.findDirectory(dirPaths.at(i));
+        const QString &fileName = names.at(i);
+        const qint64 value = values[static_cast<size_t>(i)];
+        const QCollatorSortKey key = nameCollator.sortKey(fileName);
+        auto rowLessThan = [&](int row) {
+            const qint64 rowValue = sortValues[files.slot(row)];
+            if (rowValue != value) {
+                return rowValue < value;
+            }
+            if (!dirRanks.empty() && files.directoryId(row) != dirId) {
+                return dirRanks[files.directoryId(row)] < dirRanks[dirId];
+            }
+            const int ret = sortKey(row).compare(key);
+            return 0 != ret ? ret < 0 : files.fileName(row) < fileName;
+        };
+
+        int row = 0;
+        int upper = files.size();
+        while (row < upper) {
+            const int mid = (row + upper) / 2;
+            if (rowLessThan(mid)) {
+                row = mid + 1;
+            } else {
+                upper = mid;
+            }
+        }
+
+        beginInsertRows(QModelIndex(), row, row);
+        files.insert(row, dirId, names, i, i + 1);
+        const quint32 slot = files.slot(row);
+        sortKeys.resize(static_cast<size_t>(files.slotCount()));
+        sortValues.resize(static_cast<size_t>(files.slotCount()));
+        sortKeys[slot] = key;
+        sortValues[slot] = value;
+        endInsertRows();
+    }
+    qCDebug(logImageViewer) << "Insert by values complete, count:" << files.size();
+}
+
+/**
+   @brief 将文件夹 \a dirId 中已排序的文件名 \a names 合并至 [ \a begin , \a end ) 区间的(已排序的)数据，
+    \a newKeys 为新文件的排序键，合并后保存至新文件的 slot
+ */
+void ImageSourceModel::mergeNames(int begin, int end, quint32 dirId, const QStringList &names,
+                                  const std::vector<QCollatorSortKey> &newKeys)
+{
+    auto rowLessThan = [&](int row, int i) {
+        const int ret = sortKey(row).compare(newKeys[static_cast<size_t>(i)]);
+        return 0 != ret ? ret < 0 : files.fileName(row) < names.at(i);
+    };
+    auto newLessThan = [&](int i, int row) {
+        const int ret = newKeys[static_cast<size_t>(i)].compare(sortKey(row));
+        return 0 != ret ? ret < 0 : names.at(i) < files.fileName(row);
+    };
+
+    // 批次的首个文件二分查找插入位置，后续文件由此向后合并
+    int row = begin;
+    int upper = end;
+    while (row < upper) {
+        const int mid = (row + upper) / 2;
+        if (rowLessThan(mid, 0)) {
+            row = mid + 1;
+        } else {
+            upper = mid;
+        }
+    }
+
+    int i = 0;
+    while (i < names.size()) {
+        while (row < end && rowLessThan(row, i)) {
+            ++row;
+        }
+
+        if (row < end && files.directoryId(row) == dirId && files.fileNameView(row) == names.at(i)) {
+            ++i;
+            continue;
+        }
+
+        // 收集在 row 位置之前连续插入的文件
+        int last = i + 1;
+        while (last < names.size() && (row >= end || newLessThan(last, row))) {
+            ++last;
+        }
+
+        // 整段插入，避免逐个插入时重复移动后续数据
+        beginInsertRows(QModelIndex(), row, row + last - i - 1);
+        files.insert(row, dirId, names, i, last);
+        sortKeys.resize(static_cast<size_t>(files.slotCount()));
+        for (int j = i; j < last; ++j) {
+            sortKeys[files.slot(row + j - i)] = newKeys[static_cast<size_t>(j)];
+        }
+        endInsertRows();
+
+        row += last - i;
+        end += last - i;
+        i = last;
+    }
+}
+
+/**
+   @return 返回第 \a row 行文件名的排序键，未生成时生成并按 slot 保存，行移动时无需同步移动
+ */
+const QCollatorSortKey &ImageSourceModel::sortKey(int row)
+{
+    std::optional<QCollatorSortKey> &key = sortKeys[files.slot(row)];
+    if (!key) {
+        key = nameCollator.sortKey(files.fileName(row));
+    }
+    return *key;
+}
+
+/**
+   @brief 递归浏览根目录 \a rootDir ，当前数据需位于根目录中，之后通过 insertDirectory() 按文件夹追加图片
+ */
+void ImageSourceModel::setTreeRoot(const QString &rootDir)
+{
+    qCDebug(logImageViewer) << "ImageSourceModel::setTreeRoot() called:" << rootDir;
+    treeRoot = rootDir;
+    listOrder = false;
+    dirKeys.clear();
+    for (int dirId = 0; dirId < files.directoryCount(); ++dirId) {
+        ensureDirectoryKey(static_cast<quint32>(dirId));
+    }
+}
+
+/**
+   @return 是否为递归浏览文件夹
+ */
+bool ImageSourceModel::isTreeMode() const
+{
+    return !treeRoot.isEmpty();
+}
+
+/**
+   @brief 递归浏览时，将文件夹 \a dirPath 中已排序的文件名 \a sortedNames 插入至文件夹所在的位置，
+    文件夹中无图片时整段插入，仅触发一次行插入通知
+ */
+void ImageSourceModel::insertDirectory(const QString &dirPath, const QStringList &sortedNames)
+{
+    qCDebug(logImageViewer) << "ImageSourceModel::insertDirectory() called:" << dirPath << "count:" << sortedNames.size();
+    if (sortedNames.isEmpty()) {
+        return;
+    }
+
+    sortByName();
+
+    const quint32 dirId = files.addDirectory(dirPath);
+    ensureDirectoryKey(dirId);
+
+    // 数据按文件夹分组，二分查找文件夹所在的区间
+    int begin = 0;
+    int upper = files.size();
+    while (begin < upper) {
+        const int mid = (begin + upper) / 2;
+        if (directoryLessThan(files.directoryId(mid), dirId)) {
+            begin = mid + 1;
+        } else {
+            upper = mid;
+        }
+    }
+    int end = begin;
+    while (end < files.size() && files.directoryId(end) == dirId) {
+        ++end;
+    }
+
+    if (begin == end) {
+        beginInsertRows(QModelIndex(), begin, begin + sortedNames.size() - 1);
+        files.insert(begin, dirId, sortedNames, 0, sortedNames.size());
+        sortKeys.resize(static_cast<size_t>(files.slotCount()));
+        endInsertRows();
+        return;
+    }
+
+    // 文件夹中已有图片(打开的图片或文件夹新增的图片)，按文件名合并
+    std::vector<QCollatorSortKey> newKeys;
+    newKeys.reserve(static_cast<size_t>(sortedNames.size()));
+    for (const QString &name : sortedNames) {
+        newKeys.push_back(nameCollator.sortKey(name));
+    }
+    mergeNames(begin, end, dirId, sortedNames, newKeys);
+}
+
+/**
+   @brief 生成文件夹 \a dirId 相对根目录的排序键，已生成时不重复处理
+ */
+void ImageSourceModel::ensureDirectoryKey(quint32 dirId)
+{
+    if (dirId < dirKeys.size() && !dirKeys[dirId].names.isEmpty()) {
+        return;
+    }
+    if (dirId >= dirKeys.size()) {
+        dirKeys.resize(dirId + 1);
+    }
+
+    // 根目录的相对路径为空，以 "." 表示，排在所有子文件夹之前
+    DirectoryKey &dirKey = dirKeys[dirId];
+    const QString relativePath = QDir(treeRoot).relativeFilePath(files.directory(dirId));
+    for (const QString &name : relativePath.split('/')) {
+        if (!name.isEmpty() && name != ".") {
+            dirKey.names.append(name);
+            dirKey.keys.push_back(nameCollator.sortKey(name));
+        }
+    }
+    dirKey.names.prepend(".");
+}
+
+/**
+   @return 返回文件夹 \a left 是否位于 \a right 之前，逐级比较文件夹名称，上级文件夹中的图片位于子文件夹之前
+ */
+bool ImageSourceModel::directoryLessThan(quint32 left, quint32 right) const
+{
+    if (left == right) {
+        return false;
+    }
+
+    const DirectoryKey &leftKey = dirKeys[left];
+    const DirectoryKey &rightKey = dirKeys[right];
+    const size_t count = std::min(leftKey.keys.size(), rightKey.keys.size());
+    for (size_t i = 0; i < count; ++i) {
+        // names 首项为根目录的占位
+        const QString &leftName = leftKey.names.at(static_cast<int>(i) + 1);
+        const QString &rightName = rightKey.names.at(static_cast<int>(i) + 1);
+        if (ImageNameCollator::lessThan(leftKey.keys[i], leftName, rightKey.keys[i], rightName)) {
+            return true;
+        }
+        if (ImageNameCollator::lessThan(rightKey.keys[i], rightName, leftKey.keys[i], leftName)) {
+            return false;
+        }
+    }
+    return leftKey.keys.size() < rightKey.keys.size();
+}
+
+/**
+   @return 返回各文件夹按 directoryLessThan() 排列的序号，以文件夹索引访问，非递归浏览时为空
+ */
+std::vector<int> ImageSourceModel::directoryRanks() const
+{
+    if (!isTreeMode()) {
+        return {};
+    }
+
+    std::vector<quint32> dirIds(static_cast<size_t>(files.directoryCount()));
+    std::iota(dirIds.begin(), dirIds.end(), 0);
+    std::sort(dirIds.begin(), dirIds.end(), [this](quint32 left, quint32 right) { return directoryLessThan(left, right); });
+
+    std::vector<int> ranks(dirIds.size());
+    for (size_t i = 0; i < dirIds.size(); ++i) {
+        ranks[dirIds[i]] = static_cast<int>(i);
+    }
+    return ranks;
+}
+
+/**
+   @return 返回 \a left 行是否位于 \a right 行之前，递归浏览时先比较所在文件夹的序号 \a dirRanks ，
+    同一文件夹中比较文件名排序键，排序键相同时比较完整文件名
+   @note 保持列表顺序时比较在设置的列表中的位置，列表按顺序追加且不再插入，slot 即为列表中的位置
+ */
+bool ImageSourceModel::nameLessThan(int left, int right, const std::vector<int> &dirRanks)
+{
+    if (listOrder) {
+        return files.slot(left) < files.slot(right);
+    }
+
+    if (!dirRanks.empty()) {
+        const int leftRank = dirRanks[files.directoryId(left)];
+        const int rightRank = dirRanks[files.directoryId(right)];
+        if (leftRank != rightRank) {
+            return leftRank < rightRank;
+        }
+    }
+
+    const int ret = sortKey(left).compare(sortKey(right));
+    return 0 != ret ? ret < 0 : files.fileName(left) < files.fileName(right);
+}
+
+/**
+   @brief 按 \a order 重新排列数据， \a order[i] 为新的第 i 行在原数据中的行号，
+    仅发送一次布局变更通知，并更新持久化索引
+ */
+void ImageSourceModel::applyRowOrder(const std::vector<int> &order)
+{
+    Q_EMIT layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // 排序键按 slot 保存，无需随行移动
+    std::vector<int> newRows(order.size());
+    for (size_t row = 0; row < order.size(); ++row) {
+        newRows[static_cast<size_t>(order[row])] = static_cast<int>(row);
+    }
+    files.reorder(order);
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (const QModelIndex &oldIndex : oldIndexes) {
+        newIndexes.append(index(newRows[static_cast<size_t>(oldIndex.row())], oldIndex.column()));
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    Q_EMIT layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+/**
+   @brief 将文件名变更的第 \a row 行移动至其余(已排序的)数据中按文件名排列的位置
+ */
+void ImageSourceModel::moveRowByName(int row)
+{
+    // 在除 row 以外的数据中二分查找移动后的行号
+    const std::vector<int> dirRanks = directoryRanks();
+    int target = 0;
+    int upper = files.size() - 1;
+    while (target < upper) {
+        const int mid = (target + upper) / 2;
+        if (nameLessThan(mid < row ? mid : mid + 1, row, dirRanks)) {
+            target = mid + 1;
+        } else {
+            upper = mid;
+        }
+    }
+    if (target == row) {
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Move renamed image from row:" << row << "to:" << target;
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), target > row ? target + 1 : target);
+    const quint32 dirId = files.directoryId(row);
+    const QStringList names { files.fileName(row) };
+    std::optional<QCollatorSortKey> key = sortKeys[files.slot(row)];
+    sortKeys[files.slot(row)].reset();
+    files.removeAt(row);
+    files.insert(target, dirId, names, 0, 1);
+    sortKeys.resize(static_cast<size_t>(files.slotCount()));
+    sortKeys[files.slot(target)] = key;
+    endMoveRows();
+}
+
+/**
+   @return 返回当前的图像文件列表
+ */
+QList<QUrl> ImageSourceModel::imageFiles() const
+{
+    QList<QUrl> urls;
+    urls.reserve(files.size());
+    for (int row = 0; row < files.size(); ++row) {
+        urls.append(files.url(row));
+    }
+    return urls;
+}
+
+/**
+   @return 当前数据是否为文件名顺序，设置的图片列表未经重新排序时同样视为文件名顺序
+ */
+bool ImageSourceModel::isNameOrder() const
+{
+    return nameOrder;
+}
+
+/**
+   @brief 按其它方式排序后，恢复文件名自然顺序(保持列表顺序时恢复设置的列表顺序)，已为文件名顺序时不处理
+ */
+void ImageSourceModel::sortByName()
+{
+    if (nameOrder) {
+        return;
+    }
+
+    // 文件夹仅排序一次，行比较时按序号比较，文件名排序键按 slot 缓存，已生成的不重复生成
+    const std::vector<int> dirRanks = directoryRanks();
+    std::vector<int> order(static_cast<size_t>(files.size()));
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int left, int right) { return nameLessThan(left, right, dirRanks); });
+
+    applyRowOrder(order);
+    nameOrder = true;
+    qCDebug(logImageViewer) << "Restored name order, count:" << files.size();
+}
+
+/**
+   @brief 按与各行一一对应的排序键 \a values 升序重新排列数据，排序键相同时按文件名顺序
+ */
+void ImageSourceModel::sortByValues(const std::vector<qint64> &values)
+{
+    if (values.size() != static_cast<size_t>(files.size())) {
+        qCWarning(logImageViewer) << "Sort values mismatch, values:" << values.size() << "rows:" << files.size();
+        return;
+    }
+
+    // 仅排序键相同的行按文件名比较，文件名排序键在比较时按需生成，不为全部文件生成
+    const std::vector<int> dirRanks = directoryRanks();
+    std::vector<int> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int left, int right) {
+        const qint64 leftValue = values[static_cast<size_t>(left)];
+        const qint64 rightValue = values[static_cast<size_t>(right)];
+        return leftValue != rightValue ? leftValue < rightValue : nameLessThan(left, right, dirRanks);
+    });
+
+    applyRowOrder(order);
+    nameOrder = false;
+
+    // 保存各行的排序键，新增的图片据此二分查找插入位置
+    sortValues.assign(static_cast<size_t>(files.slotCount()), 0);
+    for (int row = 0; row < files.size(); ++row) {
+        sortValues[files.slot(row)] = values[static_cast<size_t>(order[static_cast<size_t>(row)])];
+    }
+    qCDebug(logImageViewer) << "Sorted by values, count:" << files.size();
+}
+
 /**
    @brief 从数据模型中移除文件路径 \a fileName 指向的数据
  */
 void ImageSourceModel::removeImage(const QUrl &fileName)
 {
     qCDebug(logImageViewer) << "ImageSourceModel::removeImage() called for file:" << fileName;
-    int index = imageUrlList.indexOf(fileName);
+    int index = files.indexOf(fileName.toLocalFile());
     if (-1 != index) {
         qCDebug(logImageViewer) << "Removing image at index:" << index;
         beginRemoveRows(QModelIndex(), index, index);
-        imageUrlList.removeAt(index);
+        // slot 由之后插入的文件复用，清除其排序键
+        sortKeys[files.slot(index)].reset();
+        files.removeAt(index);
         endRemoveRows();
         qCDebug(logImageViewer) << "Image removed successfully.";
     } else {
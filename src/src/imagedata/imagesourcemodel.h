@@ -6,10 +6,14 @@
 #define IMAGESOURCEMODEL_H
 
 #include "types.h"
+#include "imagenamecollator.h"
+#include "imagefiletable.h"
 
 #include <QAbstractListModel>
 #include <QUrl>
 
+#include <optional>
+
 class ImageSourceModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -24,11 +28,51 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
     Q_INVOKABLE int indexForImagePath(const QUrl &file);
-    Q_SLOT void setImageFiles(const QList<QUrl> &files);
+    // 图片文件列表均为 url 路径字符串，直接拆分存储，无需构造 QUrl 列表
+    Q_SLOT void setImageFiles(const QStringList &filePaths, bool keepListOrder = false);
+    Q_SLOT void insertImageFiles(const QStringList &sortedFiles);
+    void insertImageFilesByValues(const QStringList &filePaths, const std::vector<qint64> &values);
     Q_SLOT void removeImage(const QUrl &fileName);
 
+    // 递归浏览文件夹 rootDir ，按文件夹分组追加图片
+    void setTreeRoot(const QString &rootDir);
+    bool isTreeMode() const;
+    void insertDirectory(const QString &dirPath, const QStringList &sortedNames);
+
+    QList<QUrl> imageFiles() const;
+    bool isNameOrder() const;
+    void sortByName();
+    void sortByValues(const std::vector<qint64> &values);
+
 private:
-    QList<QUrl> imageUrlList;       ///< 图像信息列表，部分信息保存至全局缓存中
+    /**
+       @brief 递归浏览时文件夹的排序键，由相对根目录的各级文件夹名称组成
+     */
+    struct DirectoryKey
+    {
+        QStringList names;
+        std::vector<QCollatorSortKey> keys;
+    };
+
+    const QCollatorSortKey &sortKey(int row);
+    void ensureDirectoryKey(quint32 dirId);
+    bool nameLessThan(int left, int right, const std::vector<int> &dirRanks);
+    bool directoryLessThan(quint32 left, quint32 right) const;
+    std::vector<int> directoryRanks() const;
+    void mergeNames(int begin, int end, quint32 dirId, const QStringList &names, const std::vector<QCollatorSortKey> &newKeys);
+    void applyRowOrder(const std::vector<int> &order);
+    void moveRowByName(int row);
+
+private:
+    ImageFileTable files;           ///< 图像文件列表，部分信息保存至全局缓存中
+    ImageNameCollator nameCollator;
+    std::vector<std::optional<QCollatorSortKey>> sortKeys;   ///< 按 slot 存储的文件名排序键，首次比较时生成
+    std::vector<qint64> sortValues;           ///< 按 slot 存储的最近一次 sortByValues() 的排序键
+    bool nameOrder = true;                    ///< 当前数据是否为文件名顺序(或设置的列表顺序)
+    bool listOrder = false;                   ///< 是否保持设置的图片列表顺序，此时不按文件名移动或合并图片
+
+    QString treeRoot;                         ///< 递归浏览的根目录，为空时为单个文件夹或指定的图片列表
+    std::vector<DirectoryKey> dirKeys;        ///< 与文件夹索引一一对应的文件夹排序键，仅递归浏览时使用
 };
 
 #endif  // IMAGESOURCEMODEL_H
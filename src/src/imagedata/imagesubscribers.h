@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGESUBSCRIBERS_H
+#define IMAGESUBSCRIBERS_H
+
+#include "imagepathtable.h"
+
+#include <QList>
+#include <QMultiHash>
+#include <QPointer>
+
+/**
+   @class ImageSubscribers
+   @brief 按图片 key (路径 ID, 帧号) 记录的订阅者，图片数据变更时仅通知对应 key 的订阅者，
+        无需广播至全部订阅者后逐个比较路径
+   @note 通知过程中订阅者可能被销毁(例如 QML 组件切换)，存在多个订阅者时使用 QPointer 保护，
+        \a T 需派生自 QObject
+ */
+template <typename T>
+class ImageSubscribers
+{
+public:
+    void subscribe(const ImageKey &key, T *subscriber) { subscribers.insert(key, subscriber); }
+    void unsubscribe(const ImageKey &key, T *subscriber) { subscribers.remove(key, subscriber); }
+    bool contains(const ImageKey &key) const { return subscribers.contains(key); }
+    int size() const { return subscribers.size(); }
+
+    /**
+       @brief 对订阅 \a key 的每个订阅者调用 \a func
+     */
+    template <typename Func>
+    void notify(const ImageKey &key, Func func) const
+    {
+        auto itr = subscribers.constFind(key);
+        if (itr == subscribers.constEnd()) {
+            return;
+        }
+
+        // 通常仅有单个订阅者，调用后不再访问，无需保护
+        auto next = itr;
+        ++next;
+        if (next == subscribers.constEnd() || next.key() != key) {
+            func(itr.value());
+            return;
+        }
+
+        QList<QPointer<T>> guards;
+        for (; itr != subscribers.constEnd() && itr.key() == key; ++itr) {
+            guards.append(itr.value());
+        }
+        for (const QPointer<T> &subscriber : guards) {
+            if (subscriber) {
+                func(subscriber.data());
+            }
+        }
+    }
+
+private:
+    QMultiHash<ImageKey, T *> subscribers;
+};
+
+#endif  // IMAGESUBSCRIBERS_H
@@ -0,0 +1,197 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagetreescanner.h"
+#include "imagedirscanner.h"
+#include "imagenamecollator.h"
+#include "unionimage/imageformatregistry.h"
+#include "utils/tracerecorder.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+/**
+   @brief 遍历单个文件夹的任务，按后缀识别图片并列出子文件夹
+ */
+class ScanTreeRunnable : public QRunnable
+{
+public:
+    ScanTreeRunnable(ImageTreeScanner *scanner, int generation, const QString &dirPath)
+        : scanner(scanner)
+        , generation(generation)
+        , dirPath(dirPath)
+    {
+    }
+
+    void run() override;
+
+private:
+    ImageTreeScanner *scanner;
+    int generation;
+    QString dirPath;
+};
+
+void ScanTreeRunnable::run()
+{
+    TraceSpan span("tree", "list", dirPath);
+    QStringList imageNames;
+    QStringList subDirs;
+
+    // 仅读取目录项，不打开文件，不进入隐藏及链接的文件夹以避免循环
+    QDirIterator itr(dirPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    while (itr.hasNext()) {
+        itr.next();
+        if (scanner->isCanceled(generation)) {
+            qCDebug(logImageViewer) << "Tree scan canceled:" << dirPath;
+            break;
+        }
+
+        const QFileInfo info = itr.fileInfo();
+        if (info.isDir()) {
+            if (!info.isSymLink()) {
+                subDirs.append(info.fileName());
+            }
+            continue;
+        }
+
+        const ImageFormatRegistry::Format *format = ImageFormatRegistry::findForPath(info.fileName());
+        if (format && format->readableBySuffix()) {
+            imageNames.append(info.fileName());
+        } else if (format && format->has(ImageFormatRegistry::ContentCheck) && ImageDirScanner::checkImageContent(info.filePath())) {
+            imageNames.append(info.fileName());
+        }
+    }
+
+    ImageNameCollator::sort(imageNames);
+    ImageNameCollator::sort(subDirs);
+
+    const QDir dir(dirPath);
+    for (QString &subDir : subDirs) {
+        subDir = dir.filePath(subDir);
+    }
+
+    scanner->postDirectory(generation, dirPath, imageNames, subDirs);
+}
+
+/**
+   @class ImageTreeScanner
+   @brief 异步递归扫描文件夹，每个文件夹由单独的任务遍历，
+        文件夹中已排序的图片通过 directoryFound() 发送，所有文件夹扫描完成后发送 scanFinished() 。
+   @note 仅按后缀识别图片，除少量需校验内容的后缀(如 EPS 、WMF)外不读取文件。文件夹之间不保证发送顺序，
+        接收方需按文件夹路径合并，优先扫描的文件夹(打开图片所在的文件夹)最先发送。
+ */
+
+ImageTreeScanner::ImageTreeScanner(QObject *parent)
+    : QObject(parent)
+    , localPoolPtr(new QThreadPool)
+{
+    localPoolPtr->setMaxThreadCount(qBound(2, QThread::idealThreadCount() / 2, 4));
+}
+
+ImageTreeScanner::~ImageTreeScanner()
+{
+    cancel();
+    localPoolPtr->waitForDone();
+}
+
+/**
+   @brief 递归扫描文件夹 \a rootDir (本地路径)，优先扫描文件夹 \a priorityDir ，
+    将取消之前未完成的扫描
+ */
+void ImageTreeScanner::start(const QString &rootDir, const QString &priorityDir)
+{
+    cancel();
+
+    const QString rootPath = QDir(rootDir).absolutePath();
+    if (!QFileInfo(rootPath).isDir()) {
+        qCWarning(logImageViewer) << "Invalid directory for tree scan:" << rootDir;
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Scanning image tree:" << rootPath << "priority:" << priorityDir;
+    const QString priorityPath = priorityDir.isEmpty() ? QString() : QDir(priorityDir).absolutePath();
+    // 按路径分隔符比较，避免将同级的 "/a/bc" 视为根目录 "/a/b" 的子文件夹，根目录为 "/" 时已以分隔符结尾
+    const QString rootPrefix = rootPath.endsWith('/') ? rootPath : rootPath + '/';
+    if (!priorityPath.isEmpty() && priorityPath.startsWith(rootPrefix)) {
+        scheduleDirectory(priorityPath);
+    }
+    scheduleDirectory(rootPath);
+}
+
+/**
+   @brief 取消当前的扫描，后台任务将尽快退出，已发送的结果将被丢弃
+ */
+void ImageTreeScanner::cancel()
+{
+    currentGeneration.ref();
+    runningTasks = 0;
+    scheduledDirs.clear();
+}
+
+/**
+   @return 是否存在未完成的扫描
+ */
+bool ImageTreeScanner::isScanning() const
+{
+    return runningTasks > 0;
+}
+
+bool ImageTreeScanner::isCanceled(int generation) const
+{
+    return generation != currentGeneration.loadAcquire();
+}
+
+/**
+   @brief 提交文件夹 \a dirPath 的扫描任务，已提交的文件夹不重复扫描
+ */
+void ImageTreeScanner::scheduleDirectory(const QString &dirPath)
+{
+    if (scheduledDirs.contains(dirPath)) {
+        return;
+    }
+
+    scheduledDirs.insert(dirPath);
+    ++runningTasks;
+    localPoolPtr->start(new ScanTreeRunnable(this, currentGeneration.loadAcquire(), dirPath));
+}
+
+/**
+   @brief 后台任务发送文件夹 \a dirPath 的扫描结果，在主线程发送找到的图片并提交子文件夹 \a subDirs 的扫描，
+    所有任务完成后发送 scanFinished()
+ */
+void ImageTreeScanner::postDirectory(int generation, const QString &dirPath, const QStringList &sortedNames, const QStringList &subDirs)
+{
+    QMetaObject::invokeMethod(
+            this,
+            [this, generation, dirPath, sortedNames, subDirs]() {
+                if (isCanceled(generation)) {
+                    return;
+                }
+
+                if (!sortedNames.isEmpty()) {
+                    Q_EMIT directoryFound(dirPath, sortedNames);
+                    // 接收方可能在处理信号时取消扫描
+                    if (isCanceled(generation)) {
+                        return;
+                    }
+                }
+
+                for (const QString &subDir : subDirs) {
+                    scheduleDirectory(subDir);
+                }
+
+                if (0 == --runningTasks) {
+                    qCDebug(logImageViewer) << "Image tree scan finished, directories:" << scheduledDirs.size();
+                    Q_EMIT scanFinished();
+                }
+            },
+            Qt::QueuedConnection);
+}
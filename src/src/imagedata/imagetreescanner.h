@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGETREESCANNER_H
+#define IMAGETREESCANNER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QSet>
+#include <QScopedPointer>
+
+class QThreadPool;
+
+class ImageTreeScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageTreeScanner(QObject *parent = nullptr);
+    ~ImageTreeScanner() override;
+
+    void start(const QString &rootDir, const QString &priorityDir = QString());
+    void cancel();
+    bool isScanning() const;
+
+    // 找到的文件夹 dirPath 中已排序的图片文件名，每个文件夹发送一次
+    Q_SIGNAL void directoryFound(const QString &dirPath, const QStringList &sortedNames);
+    Q_SIGNAL void scanFinished();
+
+private:
+    friend class ScanTreeRunnable;
+
+    bool isCanceled(int generation) const;
+    void scheduleDirectory(const QString &dirPath);
+    void postDirectory(int generation, const QString &dirPath, const QStringList &sortedNames, const QStringList &subDirs);
+
+private:
+    QAtomicInt currentGeneration { 0 };   ///< 扫描代数，重新扫描或取消时递增，丢弃过期的结果
+    int runningTasks { 0 };               ///< 当前扫描未完成的任务数
+    QSet<QString> scheduledDirs;          ///< 已提交扫描的文件夹，避免重复扫描
+    QScopedPointer<QThreadPool> localPoolPtr;
+
+    Q_DISABLE_COPY(ImageTreeScanner)
+};
+
+#endif  // IMAGETREESCANNER_H
@@ -278,6 +278,50 @@ void PathViewProxyModel::resetModel(int sourceIndex, int frameIndex)
     qCDebug(logImageViewer) << "PathViewProxyModel::resetModel() finished.";
 }
 
+/**
+   @brief 源数据模型插入数据后，当前图片的源索引变更为 \a sourceIndex ，更新两侧的图片数据，
+    仅图片或帧索引变更的位置通知 view 更新
+ */
+void PathViewProxyModel::updateSourceIndex(int sourceIndex)
+{
+    qCDebug(logImageViewer) << "PathViewProxyModel::updateSourceIndex() called with sourceIndex:" << sourceIndex;
+    if (indexQueue.isEmpty() || !indexQueue[currentProxyIdx]) {
+        qCWarning(logImageViewer) << "indexQueue is empty, returning.";
+        return;
+    }
+
+    indexQueue[currentProxyIdx]->index = sourceIndex;
+    // 跳转动画中，动画结束时将刷新两侧数据
+    if (Current != jumpFlag) {
+        return;
+    }
+
+    auto updateIfChanged = [this](int proxyIndex, const IndexInfoPtr &info) {
+        const IndexInfoPtr &old = indexQueue.at(proxyIndex);
+        if (!old && !info) {
+            return;
+        }
+        if (old && info && old->url == info->url && old->frameIndex == info->frameIndex) {
+            old->index = info->index;
+            old->frameCount = info->frameCount;
+        } else {
+            updateIndexInfo(proxyIndex, info);
+        }
+    };
+
+    int previousIndex = currentProxyIdx;
+    int nextIndex = currentProxyIdx;
+    for (int i = 0; i < radius; ++i) {
+        IndexInfoPtr previousInfo = createPreviousIndexInfo(indexQueue[previousIndex]);
+        previousIndex = previousPorxyIdx(previousIndex);
+        updateIfChanged(previousIndex, previousInfo);
+
+        IndexInfoPtr nextInfo = createNextIndexInfo(indexQueue[nextIndex]);
+        nextIndex = nextProxyIdx(nextIndex);
+        updateIfChanged(nextIndex, nextInfo);
+    }
+}
+
 /**
    @brief 移除当前图片，并更新图片索引信息
  */
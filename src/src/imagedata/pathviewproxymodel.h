@@ -39,6 +39,7 @@ public:
     void movePrevoius();
     void moveNext();
     void resetModel(int sourceIndex, int frameIndex);
+    void updateSourceIndex(int sourceIndex);
     void deleteCurrent();
 
     void setQueueCount(int count);
@@ -4,17 +4,517 @@
 
 #include "thumbnailcache.h"
 
-ThumbnailCache::ThumbnailCache()
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QHash>
+#include <QMutex>
+
+#include <cstring>
+#include <limits>
+
+static const int s_atlasSlotsPerRow = 8;                                      // 每页每行单位槽位数
+static const int s_atlasPageSlots = s_atlasSlotsPerRow * s_atlasSlotsPerRow;  // 每页单位槽位数，同时为每页槽位数上限
+static const int s_atlasPageSize = s_atlasSlotsPerRow * ThumbnailCache::ThumbnailSize;  // 图集分页边长
+static const int s_thumbnailShards = 4;                                       // 缩略图缓存分片数
+static const int s_maxThumbnailRatio = 4;                                     // 缩略图长边相对层级大小的最大倍数
+
+/**
+   @return 返回容纳 \a imageSize 大小图像的图集槽位规格，短边超过 ThumbnailSize 时返回无效大小，不存放至图集
+   @note 槽位规格为单位槽位(ThumbnailSize)的整数倍，长边方向最多跨越 s_maxThumbnailRatio 个单位，
+    短边 128px 的横向或纵向缩略图均可存放至图集。较小层级的缩略图使用相同规格
+ */
+static QSize atlasSlotSize(const QSize &imageSize)
+{
+    const int unit = ThumbnailCache::ThumbnailSize;
+    if (imageSize.isEmpty() || (imageSize.width() > unit && imageSize.height() > unit)) {
+        return QSize();
+    }
+
+    const int spanWidth = (imageSize.width() + unit - 1) / unit;
+    const int spanHeight = (imageSize.height() + unit - 1) / unit;
+    if (spanWidth > s_maxThumbnailRatio || spanHeight > s_maxThumbnailRatio) {
+        return QSize();
+    }
+    return QSize(spanWidth * unit, spanHeight * unit);
+}
+
+/**
+   @class ThumbnailAtlasPage
+   @brief 缩略图图集分页，单张 1024x1024 图像按 \a slotSize 划分为相同规格的槽位，
+        槽位被读取的图像引用时(pins 非 0)不会被复用。
+ */
+class ThumbnailAtlasPage
+{
+public:
+    struct Slot
+    {
+        ThumbnailCache::Key key;
+        QSize size;
+        QAtomicInteger<quint64> lastUse { 0 };
+        bool used = false;
+        QAtomicInt pins;
+        QAtomicInteger<quint32> seq { 0 };  ///< 槽位内容序号，复用槽位前递增，旧快照中的引用随之失效
+    };
+
+    explicit ThumbnailAtlasPage(const QSize &size)
+        : image(s_atlasPageSize, s_atlasPageSize, QImage::Format_ARGB32_Premultiplied)
+        , slotSize(size)
+        , columns(s_atlasPageSize / size.width())
+        , slotCount(columns * (s_atlasPageSize / size.height()))
+    {
+    }
+
+    QPoint slotPos(int slot) const
+    {
+        return QPoint((slot % columns) * slotSize.width(), (slot / columns) * slotSize.height());
+    }
+
+    QImage image;
+    QSize slotSize;    ///< 槽位规格
+    int columns;       ///< 每行槽位数
+    int slotCount;     ///< 槽位数，不超过 s_atlasPageSlots
+    Slot slots[s_atlasPageSlots];
+};
+
+/**
+   @brief 图集槽位引用，随读取的图像释放而解除
+ */
+struct ThumbnailSlotPin
+{
+    QSharedPointer<ThumbnailAtlasPage> page;
+    int slot;
+};
+
+static void releaseThumbnailSlot(void *info)
+{
+    ThumbnailSlotPin *pin = static_cast<ThumbnailSlotPin *>(info);
+    pin->page->slots[pin->slot].pins.deref();
+    delete pin;
+}
+
+/**
+   @class ThumbnailCacheShard
+   @brief 缩略图缓存分片，读取(contains/find)无锁：写入方修改后发布不可变的索引快照，
+        读取方原子地取得当前快照后查找，并以原子操作更新访问计数，被替换的快照在没有读取方时释放。
+        图集槽位的引用记录发布时的槽位序号，槽位被复用后旧快照中的引用失效。
+        写入(add/remove)持有 lock 串行执行。
+        \a atlasEnabled 启用时，短边不超过 ThumbnailSize 的图像按长边选取槽位规格，拷贝至图集分页的槽位中，
+        按槽位进行 LRU 淘汰，分页整体较久未访问时可改为其它规格；其它图像按条目进行 LRU 淘汰。
+ */
+class ThumbnailCacheShard
+{
+public:
+    typedef ThumbnailCache::Key Key;
+
+    struct SlotRef
+    {
+        int page = -1;
+        int slot = -1;
+    };
+
+    struct Entry
+    {
+        QImage image;
+        QAtomicInteger<quint64> lastUse { 0 };
+    };
+
+    /**
+       @brief 索引快照中的缩略图位置，page 为空时为未存放至图集的条目
+     */
+    struct IndexValue
+    {
+        QSharedPointer<ThumbnailAtlasPage> page;
+        int slot = -1;
+        quint32 seq = 0;  ///< 发布快照时的槽位序号
+        QSharedPointer<Entry> entry;
+    };
+    typedef QHash<Key, IndexValue> Index;
+
+    explicit ThumbnailCacheShard(bool atlas, int maxCost)
+        : atlasEnabled(atlas)
+        , capacity(maxCost)
+    {
+        published.storeRelease(new Index);
+    }
+
+    ~ThumbnailCacheShard()
+    {
+        delete published.loadAcquire();
+        qDeleteAll(retired);
+    }
+
+    // 以下函数无需加锁
+    bool contains(const Key &key) const;
+    bool find(const Key &key, QImage &image) const;
+    QList<Key> keys() const;
+
+    // 以下函数需持有 lock ，修改后调用 publishLocked() 发布快照
+    bool findLocked(const Key &key, QImage &image) const;
+    void insertLocked(const Key &key, const QImage &image);
+    void removeLocked(const Key &key);
+    void setCapacityLocked(int maxCost);
+    void clearLocked();
+    void publishLocked();
+
+    QMutex lock;
+
+private:
+    quint64 nextUse() const { return useCounter.fetchAndAddRelaxed(1) + 1; }
+    bool pinSlot(const QSharedPointer<ThumbnailAtlasPage> &page, int slot, quint32 seq, QImage &image) const;
+    bool addToAtlas(const Key &key, const QImage &image, const QSize &slotSize);
+    void releaseSlot(const Key &key);
+    SlotRef allocateSlot(const QSize &slotSize);
+    SlotRef selectSlot(const QSize &slotSize, bool &newPage);
+    void trimAtlasPages();
+    void trimEntries();
+
+    bool atlasEnabled { false };
+    int capacity { 0 };                                     ///< 缓存条目(槽位)上限
+    mutable QAtomicInteger<quint64> useCounter { 0 };       ///< 访问计数，用于 LRU 淘汰
+    QHash<Key, QSharedPointer<Entry>> entries;              ///< 未存放至图集的图像
+    QList<QSharedPointer<ThumbnailAtlasPage>> atlasPages;   ///< 图集分页
+    QHash<Key, SlotRef> atlasIndex;                         ///< 缩略图所在的图集槽位
+
+    QAtomicPointer<const Index> published;                  ///< 当前发布的索引快照
+    mutable QAtomicInt readers;                             ///< 正在读取快照的线程数
+    QList<const Index *> retired;                           ///< 已被替换，等待没有读取方时释放的快照
+};
+
+bool ThumbnailCacheShard::contains(const Key &key) const
+{
+    readers.ref();
+    const bool ret = published.loadAcquire()->contains(key);
+    readers.deref();
+    return ret;
+}
+
+bool ThumbnailCacheShard::find(const Key &key, QImage &image) const
+{
+    // 先登记读取方再取得快照，写入方在登记数为 0 时才释放被替换的快照
+    readers.ref();
+    const Index *index = published.loadAcquire();
+    bool ret = false;
+    auto itr = index->constFind(key);
+    if (itr != index->constEnd()) {
+        if (itr->page) {
+            ret = pinSlot(itr->page, itr->slot, itr->seq, image);
+        } else {
+            itr->entry->lastUse.storeRelaxed(nextUse());
+            image = itr->entry->image;
+            ret = true;
+        }
+    }
+    readers.deref();
+    return ret;
+}
+
+QList<ThumbnailCacheShard::Key> ThumbnailCacheShard::keys() const
 {
-    // 设置默认缓存为240
-    cache.setMaxCost(240);
+    readers.ref();
+    const QList<Key> ret = published.loadAcquire()->keys();
+    readers.deref();
+    return ret;
+}
+
+bool ThumbnailCacheShard::findLocked(const Key &key, QImage &image) const
+{
+    auto slotItr = atlasIndex.constFind(key);
+    if (slotItr != atlasIndex.constEnd()) {
+        const QSharedPointer<ThumbnailAtlasPage> &page = atlasPages.at(slotItr->page);
+        return pinSlot(page, slotItr->slot, page->slots[slotItr->slot].seq.loadRelaxed(), image);
+    }
+
+    auto entryItr = entries.constFind(key);
+    if (entryItr != entries.constEnd()) {
+        (*entryItr)->lastUse.storeRelaxed(nextUse());
+        image = (*entryItr)->image;
+        return true;
+    }
+
+    return false;
+}
+
+void ThumbnailCacheShard::insertLocked(const Key &key, const QImage &image)
+{
+    removeLocked(key);
+
+    const QSize slotSize = atlasEnabled ? atlasSlotSize(image.size()) : QSize();
+    if (slotSize.isValid() && addToAtlas(key, image, slotSize)) {
+        return;
+    }
+
+    QSharedPointer<Entry> entry(new Entry);
+    entry->image = image;
+    entry->lastUse.storeRelaxed(nextUse());
+    entries.insert(key, entry);
+    trimEntries();
+}
+
+void ThumbnailCacheShard::removeLocked(const Key &key)
+{
+    releaseSlot(key);
+    entries.remove(key);
+}
+
+void ThumbnailCacheShard::setCapacityLocked(int maxCost)
+{
+    capacity = maxCost;
+    trimAtlasPages();
+    trimEntries();
+}
+
+void ThumbnailCacheShard::clearLocked()
+{
+    entries.clear();
+    atlasIndex.clear();
+    // 仍被引用的分页在图像释放后销毁
+    atlasPages.clear();
+}
+
+/**
+   @brief 以当前的图集索引和条目构造新的索引快照并发布，被替换的快照在没有读取方时释放
+ */
+void ThumbnailCacheShard::publishLocked()
+{
+    Index *index = new Index;
+    index->reserve(atlasIndex.size() + entries.size());
+    for (auto itr = atlasIndex.constBegin(); itr != atlasIndex.constEnd(); ++itr) {
+        const QSharedPointer<ThumbnailAtlasPage> &page = atlasPages.at(itr->page);
+        index->insert(itr.key(), IndexValue { page, itr->slot, page->slots[itr->slot].seq.loadRelaxed(), {} });
+    }
+    for (auto itr = entries.constBegin(); itr != entries.constEnd(); ++itr) {
+        index->insert(itr.key(), IndexValue { {}, -1, 0, itr.value() });
+    }
+
+    retired.append(published.fetchAndStoreOrdered(index));
+    // 以读-改-写操作读取登记数，与读取方的 "登记 -> 取得快照" 构成全序：
+    // 读取方若在此之后登记，必然取得新快照，此前替换的快照均可释放
+    if (0 == readers.fetchAndAddOrdered(0)) {
+        qDeleteAll(retired);
+        retired.clear();
+    }
+}
+
+/**
+   @brief 引用 \a page 中的 \a slot 槽位，槽位序号与 \a seq 一致时通过 \a image 传出引用槽位内存的图像，
+    图像存在期间槽位不会被复用
+   @return 槽位已被复用时返回 false
+ */
+bool ThumbnailCacheShard::pinSlot(const QSharedPointer<ThumbnailAtlasPage> &page, int slot, quint32 seq, QImage &image) const
+{
+    ThumbnailAtlasPage::Slot &atlasSlot = page->slots[slot];
+    atlasSlot.pins.ref();
+    // 以读-改-写操作读取序号，与写入方复用槽位时的 "递增序号 -> 检查引用" 构成全序，
+    // 双方至少有一方能观察到对方的修改，不会在写入方覆盖数据时返回该槽位
+    if (seq != atlasSlot.seq.fetchAndAddOrdered(0)) {
+        atlasSlot.pins.deref();
+        return false;
+    }
+    atlasSlot.lastUse.storeRelaxed(nextUse());
+
+    const QPoint pos = page->slotPos(slot);
+    const uchar *bits = page->image.constScanLine(pos.y()) + pos.x() * 4;
+    image = QImage(bits,
+                   atlasSlot.size.width(),
+                   atlasSlot.size.height(),
+                   page->image.bytesPerLine(),
+                   page->image.format(),
+                   releaseThumbnailSlot,
+                   new ThumbnailSlotPin { page, slot });
+    return true;
+}
+
+/**
+   @brief 拷贝 \a image 至规格为 \a slotSize 的空闲图集槽位，无可用槽位时返回 false
+ */
+bool ThumbnailCacheShard::addToAtlas(const Key &key, const QImage &image, const QSize &slotSize)
+{
+    SlotRef ref = allocateSlot(slotSize);
+    if (-1 == ref.page) {
+        return false;
+    }
+
+    const QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    ThumbnailAtlasPage *page = atlasPages.at(ref.page).data();
+    const QPoint pos = page->slotPos(ref.slot);
+    const int rowBytes = source.width() * 4;
+    for (int y = 0; y < source.height(); ++y) {
+        uchar *dest = page->image.scanLine(pos.y() + y) + pos.x() * 4;
+        std::memcpy(dest, source.constScanLine(y), static_cast<size_t>(rowBytes));
+    }
+
+    ThumbnailAtlasPage::Slot &slot = page->slots[ref.slot];
+    slot.key = key;
+    slot.size = source.size();
+    slot.lastUse.storeRelaxed(nextUse());
+    slot.used = true;
+    atlasIndex.insert(key, ref);
+    return true;
+}
+
+/**
+   @brief 释放 \a key 占用的图集槽位，仍被引用的槽位在图像释放后才会复用
+ */
+void ThumbnailCacheShard::releaseSlot(const Key &key)
+{
+    SlotRef ref = atlasIndex.take(key);
+    if (-1 != ref.page) {
+        ThumbnailAtlasPage::Slot &slot = atlasPages.at(ref.page)->slots[ref.slot];
+        slot.used = false;
+        slot.key = Key();
+    }
+}
+
+/**
+   @brief 分配规格为 \a slotSize 的图集槽位用于写入，复用已有槽位前递增槽位序号，
+    递增后槽位仍被读取方引用时放弃该槽位并重新选取
+ */
+ThumbnailCacheShard::SlotRef ThumbnailCacheShard::allocateSlot(const QSize &slotSize)
+{
+    for (int attempt = 0; attempt < s_atlasPageSlots; ++attempt) {
+        bool newPage = false;
+        const SlotRef ref = selectSlot(slotSize, newPage);
+        if (-1 == ref.page || newPage) {
+            return ref;
+        }
+
+        // 以读-改-写操作读取引用计数，参见 pinSlot()
+        ThumbnailAtlasPage::Slot &slot = atlasPages.at(ref.page)->slots[ref.slot];
+        slot.seq.fetchAndAddOrdered(1);
+        if (0 == slot.pins.fetchAndAddOrdered(0)) {
+            return ref;
+        }
+    }
+    return SlotRef();
+}
+
+/**
+   @brief 选取规格为 \a slotSize 的图集槽位，优先使用同规格分页的空闲槽位，其次在容量允许时新建分页，
+    否则在其它规格的分页整体比同规格最久未访问的槽位更久未访问时，将该分页改为当前规格，
+    再否则淘汰同规格最久未访问的槽位。槽位位于新建的分页时 \a newPage 为 true
+ */
+ThumbnailCacheShard::SlotRef ThumbnailCacheShard::selectSlot(const QSize &slotSize, bool &newPage)
+{
+    SlotRef lruRef;
+    quint64 lruUse = std::numeric_limits<quint64>::max();
+    int stalePage = -1;
+    quint64 stalePageUse = std::numeric_limits<quint64>::max();
+
+    for (int p = 0; p < atlasPages.size(); ++p) {
+        ThumbnailAtlasPage *page = atlasPages.at(p).data();
+        const bool sameSize = page->slotSize == slotSize;
+        quint64 pageUse = 0;
+        bool pinned = false;
+        for (int s = 0; s < page->slotCount; ++s) {
+            ThumbnailAtlasPage::Slot &slot = page->slots[s];
+            if (0 != slot.pins.loadAcquire()) {
+                pinned = true;
+                continue;
+            }
+            if (!slot.used) {
+                if (sameSize) {
+                    return SlotRef { p, s };
+                }
+                continue;
+            }
+            const quint64 lastUse = slot.lastUse.loadRelaxed();
+            pageUse = qMax(pageUse, lastUse);
+            if (sameSize && lastUse < lruUse) {
+                lruUse = lastUse;
+                lruRef = SlotRef { p, s };
+            }
+        }
+        if (!sameSize && !pinned && pageUse < stalePageUse) {
+            stalePageUse = pageUse;
+            stalePage = p;
+        }
+    }
+
+    const int maxPages = (capacity + s_atlasPageSlots - 1) / s_atlasPageSlots;
+    if (atlasPages.size() < maxPages) {
+        atlasPages.append(QSharedPointer<ThumbnailAtlasPage>(new ThumbnailAtlasPage(slotSize)));
+        newPage = true;
+        return SlotRef { atlasPages.size() - 1, 0 };
+    }
+
+    if (-1 != stalePage && stalePageUse < lruUse) {
+        // 移除分页内的缩略图，替换为当前规格的新分页
+        for (int s = 0; s < atlasPages.at(stalePage)->slotCount; ++s) {
+            const ThumbnailAtlasPage::Slot &slot = atlasPages.at(stalePage)->slots[s];
+            if (slot.used) {
+                atlasIndex.remove(slot.key);
+            }
+        }
+        // 原分页仍被快照或图像引用时，在释放后销毁
+        atlasPages[stalePage].reset(new ThumbnailAtlasPage(slotSize));
+        newPage = true;
+        return SlotRef { stalePage, 0 };
+    }
+
+    if (-1 != lruRef.page) {
+        ThumbnailAtlasPage::Slot &slot = atlasPages.at(lruRef.page)->slots[lruRef.slot];
+        atlasIndex.remove(slot.key);
+        slot.used = false;
+        slot.key = Key();
+    }
+    return lruRef;
+}
+
+/**
+   @brief 容量调整后，移除超出容量的图集分页
+ */
+void ThumbnailCacheShard::trimAtlasPages()
+{
+    const int maxPages = (capacity + s_atlasPageSlots - 1) / s_atlasPageSlots;
+    while (atlasPages.size() > maxPages) {
+        const QSharedPointer<ThumbnailAtlasPage> page = atlasPages.takeLast();
+        for (int s = 0; s < page->slotCount; ++s) {
+            const ThumbnailAtlasPage::Slot &slot = page->slots[s];
+            if (slot.used) {
+                atlasIndex.remove(slot.key);
+            }
+        }
+    }
+}
+
+/**
+   @brief 条目超出容量时，移除最久未访问的条目
+ */
+void ThumbnailCacheShard::trimEntries()
+{
+    while (entries.size() > qMax(0, capacity)) {
+        auto lruItr = entries.begin();
+        for (auto itr = entries.begin(); itr != entries.end(); ++itr) {
+            if ((*itr)->lastUse.loadRelaxed() < (*lruItr)->lastUse.loadRelaxed()) {
+                lruItr = itr;
+            }
+        }
+        entries.erase(lruItr);
+    }
+}
+
+/**
+   @class ThumbnailCache
+   @brief 图像缓存，按 key 的哈希值分片，读取无锁，访问分片发布的索引快照，多线程读取不会相互阻塞，
+        写入时持有分片的锁。
+        \a useAtlas 启用时(缩略图缓存)，短边不超过 ThumbnailSize 的图像将拷贝至图集分页的槽位中，
+        无需为每张缩略图单独分配内存。
+   @threadsafe
+ */
+ThumbnailCache::ThumbnailCache(bool useAtlas)
+{
+    // 设置默认缓存为240，缩略图缓存访问频繁，分片降低锁竞争
+    const int shardCount = useAtlas ? s_thumbnailShards : 1;
+    for (int i = 0; i < shardCount; ++i) {
+        shards.append(QSharedPointer<ThumbnailCacheShard>(new ThumbnailCacheShard(useAtlas, 240 / shardCount)));
+    }
 }
 
 ThumbnailCache::~ThumbnailCache() {}
 
 ThumbnailCache *ThumbnailCache::instance()
 {
-    static ThumbnailCache ins;
+    static ThumbnailCache ins(true);
     return &ins;
 }
 
@@ -23,62 +523,171 @@ ThumbnailCache *ThumbnailCache::instance()
  */
 bool ThumbnailCache::contains(const QString &path, int frameIndex)
 {
-    QMutexLocker _locker(&mutex);
-    return cache.contains(toFindKey(path, frameIndex));
+    // 未分配 ID 的路径必定不在缓存中，无需分配
+    const quint32 pathId = ImagePathTable::find(path);
+    return pathId && contains(Key(pathId, frameIndex));
+}
+
+bool ThumbnailCache::contains(const Key &key)
+{
+    return key.isValid() && shardForKey(key)->contains(key);
 }
 
 /**
    @return 返回缓存中文件路径为 \a path 和图片帧索引为 \a frameIndex 的缩略图
-    QImage内部使用引用计数降低拷贝次数
+    QImage内部使用引用计数降低拷贝次数，图集中的缩略图直接引用图集内存
  */
 QImage ThumbnailCache::get(const QString &path, int frameIndex)
 {
-    QMutexLocker _locker(&mutex);
-    QImage *image = cache.object(toFindKey(path, frameIndex));
-    if (image) {
-        return *image;
-    } else {
-        return QImage();
+    QImage image;
+    find(path, frameIndex, image);
+    return image;
+}
+
+/**
+   @brief 查询文件路径为 \a path 和图片帧索引为 \a frameIndex 的缩略图，存在时通过 \a image 传出
+   @return 是否存在缓存，在同一次加锁中完成判断和读取，避免 contains() 和 get() 之间被淘汰
+ */
+bool ThumbnailCache::find(const QString &path, int frameIndex, QImage &image)
+{
+    return find(toFindKey(path, frameIndex), image);
+}
+
+bool ThumbnailCache::find(const Key &key, QImage &image)
+{
+    return key.isValid() && shardForKey(key)->find(key, image);
+}
+
+/**
+   @brief 取得文件路径为 \a path 和图片帧索引为 \a frameIndex 层级为 \a tier 的缩略图，不存在时优先由
+        已缓存的更大层级缩略图缩小生成，均不存在时调用 \a creator 读取图像，缩放至层级大小后缓存。
+   @note \a creator 在锁外执行，多个线程同时创建同一缩略图时，以首个写入缓存的结果为准，
+        所有调用方取得相同的图像。
+ */
+QImage ThumbnailCache::getOrInsert(const QString &path, int frameIndex, int tier, const std::function<QImage()> &creator)
+{
+    const Key key(ImagePathTable::intern(path), frameIndex, tier);
+    if (!key.isValid()) {
+        // 路径驻留表已满，不缓存
+        return scaledThumbnail(creator ? creator() : QImage(), tier);
+    }
+    ThumbnailCacheShard *shard = shardForKey(key);
+    QImage image;
+    if (shard->find(key, image)) {
+        return image;
     }
+
+    // 同一图像的各层级位于同一分片
+    QImage source;
+    for (int larger = largerTier(tier); larger >= 0 && source.isNull(); larger = largerTier(larger)) {
+        shard->find(Key(key.pathId, frameIndex, larger), source);
+    }
+    if (source.isNull() && creator) {
+        source = creator();
+    }
+    QImage created = scaledThumbnail(source, tier);
+
+    QMutexLocker _locker(&shard->lock);
+    if (shard->findLocked(key, image)) {
+        return image;
+    }
+    shard->insertLocked(key, created);
+    shard->publishLocked();
+    shard->findLocked(key, image);
+    return image;
 }
 
 QImage ThumbnailCache::take(const QString &path, int frameIndex)
 {
-    QMutexLocker _locker(&mutex);
-    QImage *image = cache.take(toFindKey(path, frameIndex));
-    if (image) {
-        return *image;
-    } else {
+    return take(toFindKey(path, frameIndex));
+}
+
+QImage ThumbnailCache::take(const Key &key)
+{
+    if (!key.isValid()) {
         return QImage();
     }
+
+    ThumbnailCacheShard *shard = shardForKey(key);
+    QMutexLocker _locker(&shard->lock);
+    QImage image;
+    if (shard->findLocked(key, image)) {
+        // 拷贝数据，图集槽位即将复用
+        image = image.copy();
+        shard->removeLocked(key);
+        shard->publishLocked();
+    }
+    return image;
 }
 
 /**
-   @brief 添加文件路径为 \a path 和图片帧索引为 \a frameIndex 的缩略图
+   @brief 添加文件路径为 \a path 和图片帧索引为 \a frameIndex 的默认层级缩略图，
+    图像内容可能已变更(例如旋转)，同时移除其它层级的缩略图
  */
 void ThumbnailCache::add(const QString &path, int frameIndex, const QImage &image)
 {
-    // TODO: not need reallocate
-    QMutexLocker _locker(&mutex);
-    cache.insert(toFindKey(path, frameIndex), new QImage(image));
+    const Key key = toFindKey(path, frameIndex);
+    if (!key.isValid()) {
+        return;
+    }
+
+    ThumbnailCacheShard *shard = shardForKey(key);
+    QMutexLocker _locker(&shard->lock);
+    shard->removeLocked(Key(key.pathId, frameIndex, SmallTier));
+    shard->removeLocked(Key(key.pathId, frameIndex, LargeTier));
+    shard->insertLocked(key, image);
+    shard->publishLocked();
+}
+
+void ThumbnailCache::add(const Key &key, const QImage &image)
+{
+    if (!key.isValid()) {
+        return;
+    }
+
+    ThumbnailCacheShard *shard = shardForKey(key);
+    QMutexLocker _locker(&shard->lock);
+    shard->insertLocked(key, image);
+    shard->publishLocked();
 }
 
 /**
-   @brief 移除文件路径为 \a path 和图片帧索引为 \a frameIndex 的缩略图
+   @brief 移除文件路径为 \a path 和图片帧索引为 \a frameIndex 的所有层级缩略图
  */
 void ThumbnailCache::remove(const QString &path, int frameIndex)
 {
-    QMutexLocker _locker(&mutex);
-    cache.remove(toFindKey(path, frameIndex));
+    const quint32 pathId = ImagePathTable::find(path);
+    if (!pathId) {
+        return;
+    }
+
+    ThumbnailCacheShard *shard = shardForKey(Key(pathId, frameIndex));
+    QMutexLocker _locker(&shard->lock);
+    for (int tier = DefaultTier; tier <= LargeTier; ++tier) {
+        shard->removeLocked(Key(pathId, frameIndex, tier));
+    }
+    shard->publishLocked();
+}
+
+void ThumbnailCache::remove(const Key &key)
+{
+    ThumbnailCacheShard *shard = shardForKey(key);
+    QMutexLocker _locker(&shard->lock);
+    shard->removeLocked(key);
+    shard->publishLocked();
 }
 
 /**
-   @brief 设置当前缓存的最大容量为 \a maxCost
+   @brief 设置当前缓存的最大容量为 \a maxCost ，按分片平均分配
  */
 void ThumbnailCache::setMaxCost(int maxCost)
 {
-    QMutexLocker _locker(&mutex);
-    cache.setMaxCost(maxCost);
+    const int shardCost = (maxCost + shards.size() - 1) / shards.size();
+    for (const QSharedPointer<ThumbnailCacheShard> &shard : shards) {
+        QMutexLocker _locker(&shard->lock);
+        shard->setCapacityLocked(shardCost);
+        shard->publishLocked();
+    }
 }
 
 /**
@@ -86,8 +695,11 @@ void ThumbnailCache::setMaxCost(int maxCost)
  */
 void ThumbnailCache::clear()
 {
-    QMutexLocker _locker(&mutex);
-    cache.clear();
+    for (const QSharedPointer<ThumbnailCacheShard> &shard : shards) {
+        QMutexLocker _locker(&shard->lock);
+        shard->clearLocked();
+        shard->publishLocked();
+    }
 }
 
 /**
@@ -95,14 +707,100 @@ void ThumbnailCache::clear()
  */
 QList<ThumbnailCache::Key> ThumbnailCache::keys()
 {
-    QMutexLocker _locker(&mutex);
-    return cache.keys();
+    QList<Key> ret;
+    for (const QSharedPointer<ThumbnailCacheShard> &shard : shards) {
+        ret.append(shard->keys());
+    }
+    return ret;
 }
 
 /**
-   @return 组合图像文件路径 \a path 和图像帧索引 \a frameIndex 为缩略图缓存处理的 key
+   @return 组合图像文件路径 \a path 和图像帧索引 \a frameIndex 为缩略图缓存处理的 key ，
+    路径驻留表已满时返回无效的 key ，缓存的读写均跳过
  */
 ThumbnailCache::Key ThumbnailCache::toFindKey(const QString &path, int frameIndex)
 {
-    return qMakePair(path, frameIndex);
+    return Key(ImagePathTable::intern(path), frameIndex);
+}
+
+/**
+   @return 返回 \a image 按比例缩放至短边为层级 \a tier 大小的缩略图，较小的图像不进行放大
+   @note 缩略图栏按 PreserveAspectCrop 填充显示，按短边缩放以避免全景图等长宽比较大的图像被放大显示。
+    长边不超过层级大小的 s_maxThumbnailRatio 倍，超出时按长边缩放，保留完整图像用于占位显示
+ */
+QImage ThumbnailCache::scaledThumbnail(const QImage &image, int tier)
+{
+    if (image.isNull()) {
+        return image;
+    }
+
+    const int size = tierSize(tier);
+    const int maxSize = size * s_maxThumbnailRatio;
+    QSize target = image.size().scaled(size, size, Qt::KeepAspectRatioByExpanding);
+    if (target.width() > maxSize || target.height() > maxSize) {
+        target = image.size().scaled(maxSize, maxSize, Qt::KeepAspectRatio);
+    }
+
+    if (target.width() >= image.width() || target.height() >= image.height()) {
+        return image;
+    }
+    return image.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+/**
+   @return 返回层级 \a tier 的缩略图短边长度
+ */
+int ThumbnailCache::tierSize(int tier)
+{
+    switch (tier) {
+    case SmallTier:
+        return ThumbnailSize / 2;
+    case LargeTier:
+        return ThumbnailSize * 2;
+    default:
+        return ThumbnailSize;
+    }
+}
+
+/**
+   @return 返回满足请求大小 \a requestedSize (已计算设备像素比) 的最小层级，无效大小时返回默认层级
+   @note 缩略图按短边缩放并裁剪填充显示，以请求大小的短边选取层级，仅指定单边时使用该边
+ */
+int ThumbnailCache::tierForSize(const QSize &requestedSize)
+{
+    if (!requestedSize.isValid()) {
+        return DefaultTier;
+    }
+
+    int size = qMin(requestedSize.width(), requestedSize.height());
+    if (size <= 0) {
+        size = qMax(requestedSize.width(), requestedSize.height());
+    }
+    if (size <= tierSize(SmallTier)) {
+        return SmallTier;
+    }
+    if (size <= tierSize(DefaultTier)) {
+        return DefaultTier;
+    }
+    return LargeTier;
+}
+
+/**
+   @return 返回比 \a tier 大一级的层级，已是最大层级时返回 -1
+ */
+int ThumbnailCache::largerTier(int tier)
+{
+    switch (tier) {
+    case SmallTier:
+        return DefaultTier;
+    case DefaultTier:
+        return LargeTier;
+    default:
+        return -1;
+    }
+}
+
+ThumbnailCacheShard *ThumbnailCache::shardForKey(const Key &key) const
+{
+    return shards.at(static_cast<int>(key.pathId % static_cast<quint32>(shards.size()))).data();
 }
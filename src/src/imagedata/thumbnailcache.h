@@ -5,34 +5,64 @@
 #ifndef THUMBNAILCACHE_H
 #define THUMBNAILCACHE_H
 
+#include "imagepathtable.h"
+
 #include <QObject>
-#include <QMutex>
-#include <QCache>
 #include <QImage>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <functional>
+
+class ThumbnailCacheShard;
 
 class ThumbnailCache
 {
 public:
-    typedef QPair<QString, int> Key;
+    typedef ImageKey Key;
+
+    static const int ThumbnailSize = 128;  ///< 默认层级缩略图短边长度，同时为图集单位槽位大小
 
-    ThumbnailCache();
+    // 缩略图层级，默认层级外，按显示大小及设备像素比选取较小或较大的层级
+    enum Tier {
+        DefaultTier = 0,  ///< 128px
+        SmallTier,        ///< 64px
+        LargeTier,        ///< 256px
+    };
+
+    explicit ThumbnailCache(bool useAtlas = false);
     ~ThumbnailCache();
     static ThumbnailCache *instance();
 
     bool contains(const QString &path, int frameIndex = 0);
+    bool contains(const Key &key);
     QImage get(const QString &path, int frameIndex = 0);
+    bool find(const QString &path, int frameIndex, QImage &image);
+    bool find(const Key &key, QImage &image);
+    QImage getOrInsert(const QString &path, int frameIndex, int tier, const std::function<QImage()> &creator);
     QImage take(const QString &path, int frameIndex = 0);
+    QImage take(const Key &key);
     void add(const QString &path, int frameIndex, const QImage &image);
+    void add(const Key &key, const QImage &image);
     void remove(const QString &path, int frameIndex);
+    void remove(const Key &key);
     void setMaxCost(int maxCost);
     void clear();
 
     QList<Key> keys();
     static Key toFindKey(const QString &path, int frameIndex = 0);
+    static QImage scaledThumbnail(const QImage &image, int tier = DefaultTier);
+    static int tierSize(int tier);
+    static int tierForSize(const QSize &requestedSize);
+    static int largerTier(int tier);
+
+private:
+    ThumbnailCacheShard *shardForKey(const Key &key) const;
 
 private:
-    QMutex mutex;
-    QCache<Key, QImage> cache;
+    QVector<QSharedPointer<ThumbnailCacheShard>> shards;  ///< 按 key 分片，各分片独立加锁
+
+    Q_DISABLE_COPY(ThumbnailCache)
 };
 
 #endif // THUMBNAILCACHE_H
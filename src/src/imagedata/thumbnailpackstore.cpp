@@ -0,0 +1,942 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "thumbnailpackstore.h"
+#include "thumbnailcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QStandardPaths>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+namespace {
+
+const char s_packMagic[8] = { 'D', 'I', 'V', 'T', 'P', 'A', 'C', 'K' };
+const quint32 s_packVersion = 2;
+const quint32 s_initCapacity = 1024;                    // 初始索引容量，必须为 2 的幂
+const quint64 s_maxDataSize = 256ULL * 1024 * 1024;     // 单个打包文件数据区上限
+const quint64 s_evictDataSize = s_maxDataSize / 4 * 3;  // 数据区超出上限时，淘汰最久未访问的缩略图至此大小
+const quint64 s_maxTotalSize = 1024ULL * 1024 * 1024;   // 所有打包文件的总大小上限
+const quint64 s_evictTotalSize = s_maxTotalSize / 4 * 3; // 总大小超出上限时，删除最久未访问的打包文件至此大小
+const qint64 s_trimInterval = 600;                      // 清理打包文件的最小间隔(秒)
+const qint64 s_tempFileExpire = 3600;                   // 重建中断残留的临时文件超过此时间(秒)后删除
+const quint32 s_maxDirLength = 4096;                    // 记录的源目录路径长度上限
+const int s_compressLevel = 1;                          // zlib 压缩等级，仅轻度压缩以降低读取时的解压开销
+const quint32 s_accessGranularity = 3600;               // 访问时间的更新间隔(秒)，避免每次读取均写入映射页
+const int s_maxOpenStores = 4;                          // 同时打开的目录打包文件数
+
+/**
+   @brief 打包文件头，位于文件起始位置
+ */
+struct PackHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 capacity;               ///< 索引项数量
+    std::atomic<quint32> retired;   ///< 文件已被重建的新文件替换，持有方需重新打开
+    quint32 used;                   ///< 已使用的索引项数量
+    quint64 dataEnd;                ///< 数据区结尾偏移
+    quint32 dirLength;              ///< 数据区起始处记录的源目录路径长度，用于清理源目录已删除的打包文件
+    quint32 reserved[7];
+};
+
+/**
+   @brief 索引项，开放寻址哈希表，通过 seq 实现无锁读取：
+        seq 为 0 表示空项，奇数表示正在写入，写入完成后为非零偶数
+ */
+struct PackEntry
+{
+    std::atomic<quint32> seq;
+    quint16 width;
+    quint16 height;
+    quint32 format;
+    quint32 bytesPerLine;
+    quint32 srcWidth;
+    quint32 srcHeight;
+    std::atomic<quint32> lastUse;   ///< 最近访问时间(秒)，不受 seq 保护，仅用于淘汰
+    quint32 dataSize;               ///< 压缩后的数据大小
+    quint64 inode;
+    qint64 mtime;
+    qint64 size;
+    quint64 offset;
+};
+
+static_assert(std::atomic<quint32>::is_always_lock_free, "pack store requires lock free atomics");
+static_assert(sizeof(PackHeader) == 64, "unexpected pack header layout");
+static_assert(sizeof(PackEntry) == 64, "unexpected pack entry layout");
+
+/**
+   @brief 文件唯一标识，文件内容变更后 mtime 或 size 随之变化
+ */
+struct FileKey
+{
+    quint64 inode = 0;
+    qint64 mtime = 0;
+    qint64 size = 0;
+};
+
+bool readFileKey(const QString &filePath, FileKey &key)
+{
+    struct stat st;
+    if (0 != ::stat(QFile::encodeName(filePath).constData(), &st)) {
+        return false;
+    }
+
+    key.inode = static_cast<quint64>(st.st_ino);
+    key.mtime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    key.size = static_cast<qint64>(st.st_size);
+    return true;
+}
+
+inline quint32 currentUseTime()
+{
+    return static_cast<quint32>(QDateTime::currentSecsSinceEpoch());
+}
+
+inline quint32 entryIndex(quint64 inode, quint32 capacity)
+{
+    // 简单的 64 位混合，同目录下 inode 通常连续
+    inode ^= inode >> 33;
+    inode *= 0xff51afd7ed558ccdULL;
+    inode ^= inode >> 33;
+    return static_cast<quint32>(inode) & (capacity - 1);
+}
+
+inline quint64 indexEnd(quint32 capacity)
+{
+    return sizeof(PackHeader) + static_cast<quint64>(capacity) * sizeof(PackEntry);
+}
+
+inline quint64 alignOffset(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+bool writeAll(int fd, const char *data, quint64 len, quint64 offset)
+{
+    while (len > 0) {
+        ssize_t ret = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+        if (ret < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        len -= static_cast<quint64>(ret);
+        offset += static_cast<quint64>(ret);
+    }
+    return true;
+}
+
+/**
+   @brief 初始化空的打包文件 \a fd ，索引容量为 \a capacity ，数据区起始处记录源目录路径 \a dirPath
+ */
+bool initPackFile(int fd, quint32 capacity, const QByteArray &dirPath)
+{
+    if (0 != ::ftruncate(fd, 0) || 0 != ::ftruncate(fd, static_cast<off_t>(indexEnd(capacity)))) {
+        return false;
+    }
+
+    // 头部不含 std::atomic 的布局，直接按字节写入
+    QByteArray header(sizeof(PackHeader), '\0');
+    std::memcpy(header.data(), s_packMagic, sizeof(s_packMagic));
+    std::memcpy(header.data() + offsetof(PackHeader, version), &s_packVersion, sizeof(quint32));
+    std::memcpy(header.data() + offsetof(PackHeader, capacity), &capacity, sizeof(quint32));
+    const quint64 dataEnd = indexEnd(capacity) + static_cast<quint64>(dirPath.size());
+    std::memcpy(header.data() + offsetof(PackHeader, dataEnd), &dataEnd, sizeof(quint64));
+    const quint32 dirLength = static_cast<quint32>(dirPath.size());
+    std::memcpy(header.data() + offsetof(PackHeader, dirLength), &dirLength, sizeof(quint32));
+    return writeAll(fd, header.constData(), static_cast<quint64>(header.size()), 0)
+           && writeAll(fd, dirPath.constData(), dirLength, indexEnd(capacity));
+}
+
+/**
+   @return 返回打包文件 \a packFile 记录的源目录路径，文件格式不匹配时返回空
+ */
+QString readPackDir(const QString &packFile)
+{
+    QFile file(packFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    const QByteArray header = file.read(sizeof(PackHeader));
+    if (sizeof(PackHeader) != static_cast<size_t>(header.size()) || 0 != std::memcmp(header.constData(), s_packMagic, sizeof(s_packMagic))) {
+        return QString();
+    }
+
+    quint32 version = 0;
+    quint32 capacity = 0;
+    quint32 dirLength = 0;
+    std::memcpy(&version, header.constData() + offsetof(PackHeader, version), sizeof(quint32));
+    std::memcpy(&capacity, header.constData() + offsetof(PackHeader, capacity), sizeof(quint32));
+    std::memcpy(&dirLength, header.constData() + offsetof(PackHeader, dirLength), sizeof(quint32));
+    if (s_packVersion != version || !capacity || !dirLength || dirLength > s_maxDirLength
+        || !file.seek(static_cast<qint64>(indexEnd(capacity)))) {
+        return QString();
+    }
+
+    const QByteArray dirPath = file.read(dirLength);
+    return dirLength == static_cast<quint32>(dirPath.size()) ? QString::fromUtf8(dirPath) : QString();
+}
+
+/**
+   @brief 删除打包文件 \a packFile ，删除前标记为 retired ，其它进程检测到后重新打开
+ */
+void removePackFile(const QString &packFile)
+{
+    const QByteArray path = QFile::encodeName(packFile);
+    int fd = ::open(path.constData(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    if (0 == ::flock(fd, LOCK_EX)) {
+        char magic[sizeof(s_packMagic)];
+        if (static_cast<ssize_t>(sizeof(magic)) == ::pread(fd, magic, sizeof(magic), 0)
+            && 0 == std::memcmp(magic, s_packMagic, sizeof(s_packMagic))) {
+            const quint32 retired = 1;
+            writeAll(fd, reinterpret_cast<const char *>(&retired), sizeof(quint32), offsetof(PackHeader, retired));
+        }
+        ::unlink(path.constData());
+        ::flock(fd, LOCK_UN);
+    }
+    ::close(fd);
+}
+
+/**
+   @brief 压缩缩略图 \a image 的像素数据，逐行与左侧像素作差分(同 PNG 的 Sub 过滤)后以 zlib 轻度压缩
+ */
+QByteArray encodePixels(const QImage &image)
+{
+    const int bytesPerPixel = image.depth() / 8;
+    const int rowSize = image.width() * bytesPerPixel;
+    QByteArray raw(rowSize * image.height(), Qt::Uninitialized);
+    for (int y = 0; y < image.height(); ++y) {
+        const uchar *src = image.constScanLine(y);
+        uchar *dst = reinterpret_cast<uchar *>(raw.data()) + y * rowSize;
+        for (int x = 0; x < rowSize; ++x) {
+            dst[x] = x < bytesPerPixel ? src[x] : static_cast<uchar>(src[x] - src[x - bytesPerPixel]);
+        }
+    }
+    return qCompress(raw, s_compressLevel);
+}
+
+/**
+   @brief 解压 \a data 中 \a dataSize 字节的像素数据，还原为 \a width x \a height 的 \a format 格式图像
+ */
+QImage decodePixels(const uchar *data, quint64 dataSize, int width, int height, QImage::Format format)
+{
+    const QByteArray raw = qUncompress(data, static_cast<int>(dataSize));
+    QImage image(width, height, format);
+    const int bytesPerPixel = image.depth() / 8;
+    const int rowSize = width * bytesPerPixel;
+    if (image.isNull() || raw.size() != rowSize * height) {
+        return QImage();
+    }
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *src = reinterpret_cast<const uchar *>(raw.constData()) + y * rowSize;
+        uchar *dst = image.scanLine(y);
+        for (int x = 0; x < rowSize; ++x) {
+            dst[x] = x < bytesPerPixel ? src[x] : static_cast<uchar>(src[x] + dst[x - bytesPerPixel]);
+        }
+    }
+    return image;
+}
+
+/**
+   @brief 在索引 \a entries 中查找 \a inode 对应的索引项，返回匹配或可写入的空项，容量已满时返回 nullptr
+ */
+PackEntry *probeEntry(PackEntry *entries, quint32 capacity, quint64 inode)
+{
+    quint32 index = entryIndex(inode, capacity);
+    for (quint32 i = 0; i < capacity; ++i) {
+        PackEntry *entry = entries + index;
+        if (0 == entry->seq.load(std::memory_order_acquire) || entry->inode == inode) {
+            return entry;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+    return nullptr;
+}
+
+/**
+   @brief 写入索引项 \a entry ，写入期间 seq 为奇数，读取方据此丢弃不完整的数据
+ */
+void publishEntry(PackEntry *entry, const PackEntry &value)
+{
+    quint32 seq = entry->seq.load(std::memory_order_relaxed);
+    entry->seq.store(seq | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry->width = value.width;
+    entry->height = value.height;
+    entry->format = value.format;
+    entry->bytesPerLine = value.bytesPerLine;
+    entry->srcWidth = value.srcWidth;
+    entry->srcHeight = value.srcHeight;
+    entry->lastUse.store(value.lastUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    entry->dataSize = value.dataSize;
+    entry->inode = value.inode;
+    entry->mtime = value.mtime;
+    entry->size = value.size;
+    entry->offset = value.offset;
+
+    entry->seq.store((seq | 1) + 1, std::memory_order_release);
+}
+
+}  // namespace
+
+/**
+   @class ThumbnailPackMapping
+   @brief 打包文件的内存映射，读取及重建期间通过共享指针持有引用，
+        文件扩展重新映射或被重建替换后，旧映射在最后一个引用释放时解除
+ */
+class ThumbnailPackMapping
+{
+public:
+    ThumbnailPackMapping(uchar *d, quint64 s)
+        : data(d)
+        , size(s)
+    {
+    }
+
+    ~ThumbnailPackMapping()
+    {
+        if (data) {
+            ::munmap(data, size);
+        }
+    }
+
+    PackHeader *header() const { return reinterpret_cast<PackHeader *>(data); }
+    PackEntry *entries() const { return reinterpret_cast<PackEntry *>(data + sizeof(PackHeader)); }
+
+    uchar *data = nullptr;
+    quint64 size = 0;
+
+    Q_DISABLE_COPY(ThumbnailPackMapping)
+};
+
+/**
+   @class ThumbnailPackStore
+   @brief 按目录打包存储的缩略图缓存，每个目录对应一个内存映射文件，
+        包含以 (inode, mtime, size) 为键的哈希索引和轻度压缩的短边 128px RGB(A) 缩略图数据。
+        读取时直接从映射内存解压，无需打开文件及解码 PNG ，多个看图进程通过页缓存共享数据。
+   @note 文件布局为 文件头 | 索引项[capacity] | 源目录路径 | 数据区，索引容量不足或数据区已满时重建并压缩数据区，
+        数据区超出上限时按访问时间淘汰最久未访问的缩略图；所有打包文件总大小超出上限时，
+        按最近访问时间删除最久未访问的打包文件，源目录已删除的打包文件直接删除。
+        读取无锁，通过索引项的 seq 校验数据完整性；进程内的写入通过 writeMutex 串行，
+        重建拷贝数据期间不持有读取使用的 mutex ；进程间的写入通过 flock 互斥。
+   @threadsafe
+ */
+ThumbnailPackStore::ThumbnailPackStore(const QString &dirPath)
+    : sourceDir(dirPath.toUtf8().left(static_cast<int>(s_maxDirLength)))
+{
+    const QByteArray dirHash = QCryptographicHash::hash(sourceDir, QCryptographicHash::Md5).toHex();
+    packPath = cacheDir() + "/" + QString::fromLatin1(dirHash) + ".pack";
+    qCDebug(logImageViewer) << "ThumbnailPackStore created for:" << dirPath << "pack:" << packPath;
+}
+
+ThumbnailPackStore::~ThumbnailPackStore()
+{
+    closePack();
+}
+
+/**
+   @brief 读取 \a filePath 在打包文件中缓存的缩略图 \a thumbnail 及原始图像大小 \a sourceSize
+   @return 是否存在有效的缩略图，文件变更后缓存自动失效
+ */
+bool ThumbnailPackStore::find(const QString &filePath, QImage &thumbnail, QSize &sourceSize)
+{
+    QSharedPointer<ThumbnailPackStore> store = storeForFile(filePath);
+    return store && store->findImpl(filePath, thumbnail, sourceSize);
+}
+
+/**
+   @brief 将 \a filePath 的图像 \a image 缩放后写入打包文件，\a sourceSize 为原始图像大小
+ */
+bool ThumbnailPackStore::insert(const QString &filePath, const QImage &image, const QSize &sourceSize)
+{
+    if (image.isNull()) {
+        return false;
+    }
+
+    QSharedPointer<ThumbnailPackStore> store = storeForFile(filePath);
+    return store && store->insertImpl(filePath, image, sourceSize);
+}
+
+/**
+   @return 返回打包文件的存放目录
+ */
+QString ThumbnailPackStore::cacheDir()
+{
+    static const QString s_cacheDir = []() {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnail-packs";
+        QDir().mkpath(dir);
+        return dir;
+    }();
+    return s_cacheDir;
+}
+
+/**
+   @return 返回 \a filePath 所在目录的打包存储，仅保留最近访问的少量目录
+ */
+QSharedPointer<ThumbnailPackStore> ThumbnailPackStore::storeForFile(const QString &filePath)
+{
+    static QMutex s_storeMutex;
+    static QList<QSharedPointer<ThumbnailPackStore>> s_stores;
+    static QStringList s_storeDirs;
+    static qint64 s_lastTrimTime = 0;
+
+    const QString dirPath = QFileInfo(filePath).absolutePath();
+    QSharedPointer<ThumbnailPackStore> store;
+    QStringList openPacks;
+    {
+        QMutexLocker _locker(&s_storeMutex);
+        int index = s_storeDirs.indexOf(dirPath);
+        if (-1 != index) {
+            // 移动至末尾，标记为最近访问
+            s_storeDirs.move(index, s_storeDirs.size() - 1);
+            s_stores.move(index, s_stores.size() - 1);
+            return s_stores.last();
+        }
+
+        if (s_stores.size() >= s_maxOpenStores) {
+            s_stores.removeFirst();
+            s_storeDirs.removeFirst();
+        }
+
+        store.reset(new ThumbnailPackStore(dirPath));
+        s_stores.append(store);
+        s_storeDirs.append(dirPath);
+
+        // 切换目录时按间隔清理，清理在锁外进行，不阻塞其它目录的访问
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        if (now - s_lastTrimTime < s_trimInterval) {
+            return store;
+        }
+        s_lastTrimTime = now;
+        for (const QSharedPointer<ThumbnailPackStore> &openStore : s_stores) {
+            openPacks.append(openStore->packPath);
+        }
+    }
+
+    trimPacks(openPacks);
+    return store;
+}
+
+/**
+   @brief 清理打包文件目录：删除源目录已不存在的打包文件及重建中断残留的临时文件，
+    总大小超出上限时按最近访问时间删除最久未访问的打包文件。\a openPacks 为当前打开的打包文件，不做删除
+ */
+void ThumbnailPackStore::trimPacks(const QStringList &openPacks)
+{
+    const QDir dir(cacheDir());
+    const QDateTime now = QDateTime::currentDateTime();
+    for (const QFileInfo &info : dir.entryInfoList({ "*.tmp" }, QDir::Files)) {
+        if (info.lastModified().secsTo(now) > s_tempFileExpire) {
+            QFile::remove(info.absoluteFilePath());
+        }
+    }
+
+    // 打开及写入时更新修改时间，按修改时间由新到旧排列
+    quint64 totalSize = 0;
+    QFileInfoList candidates;
+    for (const QFileInfo &info : dir.entryInfoList({ "*.pack" }, QDir::Files, QDir::Time)) {
+        if (openPacks.contains(info.absoluteFilePath())) {
+            totalSize += static_cast<quint64>(info.size());
+            continue;
+        }
+
+        const QString sourceDir = readPackDir(info.absoluteFilePath());
+        if (sourceDir.isEmpty() || !QFileInfo::exists(sourceDir)) {
+            qCDebug(logImageViewer) << "Removing stale thumbnail pack:" << info.absoluteFilePath() << "source:" << sourceDir;
+            removePackFile(info.absoluteFilePath());
+            continue;
+        }
+
+        totalSize += static_cast<quint64>(info.size());
+        candidates.append(info);
+    }
+
+    if (totalSize <= s_maxTotalSize) {
+        return;
+    }
+    while (totalSize > s_evictTotalSize && !candidates.isEmpty()) {
+        const QFileInfo info = candidates.takeLast();
+        qCDebug(logImageViewer) << "Evicting thumbnail pack:" << info.absoluteFilePath() << "size:" << info.size();
+        removePackFile(info.absoluteFilePath());
+        totalSize -= static_cast<quint64>(info.size());
+    }
+}
+
+/**
+   @return 返回映射范围不小于 \a requiredSize 的当前文件映射，文件被重建替换时重新打开
+ */
+QSharedPointer<ThumbnailPackMapping> ThumbnailPackStore::acquireMapping(quint64 requiredSize)
+{
+    QMutexLocker _locker(&mutex);
+    if (isRetired()) {
+        closePack();
+    }
+    if ((!mapping && !openPack()) || !remapIfNeeded(requiredSize)) {
+        return QSharedPointer<ThumbnailPackMapping>();
+    }
+    return mapping;
+}
+
+bool ThumbnailPackStore::findImpl(const QString &filePath, QImage &thumbnail, QSize &sourceSize)
+{
+    FileKey key;
+    if (!readFileKey(filePath, key)) {
+        return false;
+    }
+
+    // 仅在获取映射时短暂持有锁，映射的引用保证读取期间数据有效。
+    // 数据位于映射范围外时重新获取映射并重新查找，文件可能已被重建，偏移随之变化
+    quint64 requiredSize = 0;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        QSharedPointer<ThumbnailPackMapping> current = acquireMapping(requiredSize);
+        if (!current) {
+            return false;
+        }
+
+        const quint32 capacity = current->header()->capacity;
+        PackEntry *entries = current->entries();
+        quint32 index = entryIndex(key.inode, capacity);
+
+        for (quint32 i = 0; i < capacity; ++i) {
+            PackEntry *entry = entries + index;
+            const quint32 seq = entry->seq.load(std::memory_order_acquire);
+            if (0 == seq || (seq & 1)) {
+                // 空项或正在写入
+                return false;
+            }
+
+            PackEntry value;
+            value.width = entry->width;
+            value.height = entry->height;
+            value.format = entry->format;
+            value.bytesPerLine = entry->bytesPerLine;
+            value.srcWidth = entry->srcWidth;
+            value.srcHeight = entry->srcHeight;
+            value.dataSize = entry->dataSize;
+            value.inode = entry->inode;
+            value.mtime = entry->mtime;
+            value.size = entry->size;
+            value.offset = entry->offset;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq != entry->seq.load(std::memory_order_relaxed)) {
+                return false;
+            }
+
+            if (value.inode != key.inode) {
+                index = (index + 1) & (capacity - 1);
+                continue;
+            }
+            if (value.mtime != key.mtime || value.size != key.size) {
+                qCDebug(logImageViewer) << "Packed thumbnail is outdated:" << filePath;
+                return false;
+            }
+
+            const quint64 dataEnd = value.offset + value.dataSize;
+            if (dataEnd > current->size) {
+                requiredSize = dataEnd;
+                break;
+            }
+
+            // 数据区仅追加写入，已发布的数据在文件替换前不会被修改
+            thumbnail = decodePixels(current->data + value.offset,
+                                     value.dataSize,
+                                     value.width,
+                                     value.height,
+                                     static_cast<QImage::Format>(value.format));
+            sourceSize = QSize(static_cast<int>(value.srcWidth), static_cast<int>(value.srcHeight));
+
+            // 记录访问时间，数据区已满时优先淘汰最久未访问的缩略图
+            const quint32 now = currentUseTime();
+            if (now - entry->lastUse.load(std::memory_order_relaxed) > s_accessGranularity) {
+                entry->lastUse.store(now, std::memory_order_relaxed);
+            }
+            qCDebug(logImageViewer) << "Using packed thumbnail:" << filePath << "size:" << thumbnail.size();
+            return !thumbnail.isNull();
+        }
+
+        if (!requiredSize) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool ThumbnailPackStore::insertImpl(const QString &filePath, const QImage &image, const QSize &sourceSize)
+{
+    FileKey key;
+    if (!readFileKey(filePath, key)) {
+        return false;
+    }
+
+    // 与内存缓存的默认层级一致，按短边缩放，压缩在锁外进行
+    QImage thumbnail = ThumbnailCache::scaledThumbnail(image, ThumbnailCache::DefaultTier);
+    thumbnail = thumbnail.convertToFormat(thumbnail.hasAlphaChannel() ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    const QByteArray payload = encodePixels(thumbnail);
+    const quint64 dataSize = static_cast<quint64>(payload.size());
+
+    PackEntry value;
+    value.width = static_cast<quint16>(thumbnail.width());
+    value.height = static_cast<quint16>(thumbnail.height());
+    value.format = static_cast<quint32>(thumbnail.format());
+    value.bytesPerLine = static_cast<quint32>(thumbnail.width() * thumbnail.depth() / 8);
+    value.srcWidth = static_cast<quint32>(qMax(0, sourceSize.width()));
+    value.srcHeight = static_cast<quint32>(qMax(0, sourceSize.height()));
+    value.lastUse.store(currentUseTime(), std::memory_order_relaxed);
+    value.dataSize = static_cast<quint32>(dataSize);
+    value.inode = key.inode;
+    value.mtime = key.mtime;
+    value.size = key.size;
+
+    // 进程内的写入串行执行，重建期间不持有 mutex ，读取方继续使用原文件
+    QMutexLocker _writeLocker(&writeMutex);
+    bool ret = false;
+    bool full = false;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        quint32 capacity = 0;
+        {
+            QMutexLocker _locker(&mutex);
+            if (isRetired()) {
+                closePack();
+            }
+            if ((!mapping && !openPack()) || !lockPack()) {
+                return false;
+            }
+
+            PackHeader *header = mapping->header();
+            const bool indexFull = header->used + 1 > header->capacity / 4 * 3;
+            full = indexFull || alignOffset(header->dataEnd) + dataSize > s_maxDataSize;
+            if (full) {
+                capacity = indexFull ? header->capacity * 2 : header->capacity;
+            } else {
+                do {
+                    const quint64 offset = alignOffset(header->dataEnd);
+                    if (!writeAll(packFd, payload.constData(), dataSize, offset)) {
+                        qCWarning(logImageViewer) << "Failed to write thumbnail pack:" << packPath;
+                        break;
+                    }
+                    header->dataEnd = offset + dataSize;
+
+                    PackEntry *entry = probeEntry(mapping->entries(), header->capacity, key.inode);
+                    if (!entry) {
+                        break;
+                    }
+                    if (0 == entry->seq.load(std::memory_order_relaxed)) {
+                        header->used++;
+                    }
+
+                    value.offset = offset;
+                    publishEntry(entry, value);
+                    ret = true;
+                } while (false);
+            }
+            unlockPack();
+        }
+
+        if (!full || attempt > 0) {
+            break;
+        }
+        // 索引或数据区不足时重建，完成后重新检查
+        rebuildPack(capacity);
+    }
+
+    if (full) {
+        qCWarning(logImageViewer) << "Thumbnail pack has no space after rebuild:" << packPath;
+    }
+    qCDebug(logImageViewer) << "Insert packed thumbnail:" << filePath << "result:" << ret;
+    return ret;
+}
+
+/**
+   @brief 打开或创建打包文件并映射至内存，文件格式不匹配时重新初始化，调用时持有 mutex
+ */
+bool ThumbnailPackStore::openPack()
+{
+    packFd = ::open(QFile::encodeName(packPath).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (packFd < 0) {
+        qCWarning(logImageViewer) << "Failed to open thumbnail pack:" << packPath;
+        return false;
+    }
+
+    ::flock(packFd, LOCK_EX);
+    struct stat st;
+    bool valid = (0 == ::fstat(packFd, &st)) && static_cast<quint64>(st.st_size) >= sizeof(PackHeader);
+    if (valid) {
+        char header[sizeof(PackHeader)];
+        valid = (static_cast<ssize_t>(sizeof(header)) == ::pread(packFd, header, sizeof(header), 0))
+                && (0 == std::memcmp(header, s_packMagic, sizeof(s_packMagic)));
+        if (valid) {
+            quint32 version = 0;
+            quint32 capacity = 0;
+            std::memcpy(&version, header + offsetof(PackHeader, version), sizeof(quint32));
+            std::memcpy(&capacity, header + offsetof(PackHeader, capacity), sizeof(quint32));
+            valid = (s_packVersion == version) && capacity && !(capacity & (capacity - 1))
+                    && static_cast<quint64>(st.st_size) >= indexEnd(capacity);
+        }
+    }
+
+    if (!valid) {
+        qCDebug(logImageViewer) << "Initializing thumbnail pack:" << packPath;
+        if (!initPackFile(packFd, s_initCapacity, sourceDir)) {
+            ::flock(packFd, LOCK_UN);
+            closePack();
+            return false;
+        }
+    } else {
+        // 更新修改时间，清理时按修改时间保留最近访问的打包文件
+        ::futimens(packFd, nullptr);
+    }
+    ::flock(packFd, LOCK_UN);
+
+    return remapIfNeeded(0);
+}
+
+void ThumbnailPackStore::closePack()
+{
+    mapping.reset();
+    if (packFd >= 0) {
+        ::close(packFd);
+        packFd = -1;
+    }
+}
+
+/**
+   @return 当前打开的文件是否已被其它进程(或本进程)重建替换
+ */
+bool ThumbnailPackStore::isRetired() const
+{
+    return mapping && mapping->header()->retired.load(std::memory_order_acquire);
+}
+
+/**
+   @brief 文件扩展后映射范围不包含 \a requiredSize 时，重新映射整个文件
+ */
+bool ThumbnailPackStore::remapIfNeeded(quint64 requiredSize)
+{
+    if (mapping && mapping->size >= requiredSize) {
+        return true;
+    }
+
+    struct stat st;
+    if (0 != ::fstat(packFd, &st) || static_cast<quint64>(st.st_size) < qMax<quint64>(requiredSize, sizeof(PackHeader))) {
+        return false;
+    }
+
+    const quint64 fileSize = static_cast<quint64>(st.st_size);
+    void *data = ::mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, packFd, 0);
+    if (MAP_FAILED == data) {
+        qCWarning(logImageViewer) << "Failed to map thumbnail pack:" << packPath;
+        return false;
+    }
+
+    mapping.reset(new ThumbnailPackMapping(static_cast<uchar *>(data), fileSize));
+    return true;
+}
+
+/**
+   @brief 获取打包文件的进程间写入锁，获取期间文件被其它进程重建时重新打开
+ */
+bool ThumbnailPackStore::lockPack()
+{
+    if (0 != ::flock(packFd, LOCK_EX)) {
+        return false;
+    }
+    if (isRetired()) {
+        ::flock(packFd, LOCK_UN);
+        closePack();
+        if (!openPack() || 0 != ::flock(packFd, LOCK_EX)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ThumbnailPackStore::unlockPack()
+{
+    ::flock(packFd, LOCK_UN);
+}
+
+/**
+   @brief 以 \a capacity 容量重建打包文件，仅拷贝有效的缩略图数据，数据超出上限时淘汰最久未访问的缩略图，
+    完成后原子替换原文件
+   @note 调用时持有 writeMutex ，不持有 mutex 及原文件的 flock 锁。仅在读取索引快照及合并期间持有 mutex 和原文件锁，
+    拷贝数据期间本进程的读取及其它进程的写入均可继续，其它进程写入的变更在替换前合并至新文件。
+    新文件在替换前即持有锁，其它进程打开后需等待重建完成；原文件标记为 retired ，持有方检测到后重新打开
+ */
+bool ThumbnailPackStore::rebuildPack(quint32 capacity)
+{
+    // 数据区仅追加写入，快照范围内的数据在原文件替换前不会被修改
+    QSharedPointer<ThumbnailPackMapping> source;
+    quint32 oldCapacity = 0;
+    QByteArray snapshot;
+    {
+        QMutexLocker _locker(&mutex);
+        if ((!mapping && !openPack()) || !lockPack()) {
+            return false;
+        }
+        if (!remapIfNeeded(mapping->header()->dataEnd)) {
+            unlockPack();
+            return false;
+        }
+        oldCapacity = mapping->header()->capacity;
+        snapshot = QByteArray(reinterpret_cast<const char *>(mapping->entries()), static_cast<int>(oldCapacity * sizeof(PackEntry)));
+        source = mapping;
+        unlockPack();
+    }
+
+    const QString tempPath = packPath + QString(".%1.tmp").arg(::getpid());
+    int tempFd = ::open(QFile::encodeName(tempPath).constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tempFd < 0 || 0 != ::flock(tempFd, LOCK_EX) || !initPackFile(tempFd, capacity, sourceDir)) {
+        if (tempFd >= 0) {
+            ::close(tempFd);
+        }
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    // 新文件在替换前不可见，直接在内存中构造索引后写入
+    QByteArray indexData(static_cast<int>(capacity * sizeof(PackEntry)), '\0');
+    PackEntry *newEntries = reinterpret_cast<PackEntry *>(indexData.data());
+    quint64 dataEnd = indexEnd(capacity) + static_cast<quint64>(sourceDir.size());
+    quint32 used = 0;
+
+    auto copyEntry = [&](const PackEntry &entry, const uchar *data, quint64 dataLimit) {
+        if (entry.offset + entry.dataSize > dataLimit) {
+            return true;
+        }
+        PackEntry *target = probeEntry(newEntries, capacity, entry.inode);
+        if (!target) {
+            return true;
+        }
+
+        const quint64 offset = alignOffset(dataEnd);
+        if (!writeAll(tempFd, reinterpret_cast<const char *>(data + entry.offset), entry.dataSize, offset)) {
+            return false;
+        }
+        dataEnd = offset + entry.dataSize;
+
+        if (0 == target->seq.load(std::memory_order_relaxed)) {
+            ++used;
+        }
+        PackEntry value;
+        std::memcpy(reinterpret_cast<char *>(&value) + sizeof(value.seq),
+                    reinterpret_cast<const char *>(&entry) + sizeof(entry.seq),
+                    sizeof(PackEntry) - sizeof(entry.seq));
+        value.offset = offset;
+        publishEntry(target, value);
+        return true;
+    };
+
+    // 按访问时间保留缩略图，超出上限时淘汰最久未访问的部分
+    const PackEntry *snapEntries = reinterpret_cast<const PackEntry *>(snapshot.constData());
+    std::vector<quint32> keepIndexes;
+    quint64 totalSize = 0;
+    for (quint32 i = 0; i < oldCapacity; ++i) {
+        const quint32 seq = snapEntries[i].seq.load(std::memory_order_relaxed);
+        if (0 != seq && !(seq & 1)) {
+            keepIndexes.push_back(i);
+            totalSize += alignOffset(snapEntries[i].dataSize);
+        }
+    }
+    if (totalSize > s_evictDataSize) {
+        std::sort(keepIndexes.begin(), keepIndexes.end(), [snapEntries](quint32 left, quint32 right) {
+            return snapEntries[left].lastUse.load(std::memory_order_relaxed) > snapEntries[right].lastUse.load(std::memory_order_relaxed);
+        });
+        quint64 keepSize = 0;
+        auto itr = keepIndexes.begin();
+        for (; itr != keepIndexes.end(); ++itr) {
+            keepSize += alignOffset(snapEntries[*itr].dataSize);
+            if (keepSize > s_evictDataSize) {
+                break;
+            }
+        }
+        qCDebug(logImageViewer) << "Evicting packed thumbnails:" << packPath << "count:" << (keepIndexes.end() - itr);
+        keepIndexes.erase(itr, keepIndexes.end());
+    }
+
+    bool ret = true;
+    for (quint32 i : keepIndexes) {
+        ret = ret && copyEntry(snapEntries[i], source->data, source->size);
+    }
+
+    // 合并拷贝期间其它进程写入原文件的缩略图，合并的数据量较小，期间持有 mutex
+    QMutexLocker _locker(&mutex);
+    ret = ret && packFd >= 0 && 0 == ::flock(packFd, LOCK_EX);
+    if (ret && source->header()->retired.load(std::memory_order_acquire)) {
+        // 其它进程已完成重建(或文件已被清理)，放弃本次重建
+        ::flock(packFd, LOCK_UN);
+        ret = false;
+    }
+    source.reset();
+    if (ret) {
+        // 仅比较 seq ，访问时间的更新不视为变更
+        ret = remapIfNeeded(mapping->header()->dataEnd);
+        const PackEntry *entries = ret ? mapping->entries() : nullptr;
+        for (quint32 i = 0; i < oldCapacity && ret; ++i) {
+            const quint32 seq = entries[i].seq.load(std::memory_order_acquire);
+            if (0 == seq || (seq & 1) || seq == snapEntries[i].seq.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            ret = copyEntry(entries[i], mapping->data, mapping->size);
+        }
+
+        ret = ret && writeAll(tempFd, indexData.constData(), static_cast<quint64>(indexData.size()), sizeof(PackHeader));
+        ret = ret && writeAll(tempFd, reinterpret_cast<const char *>(&used), sizeof(quint32), offsetof(PackHeader, used));
+        ret = ret && writeAll(tempFd, reinterpret_cast<const char *>(&dataEnd), sizeof(quint64), offsetof(PackHeader, dataEnd));
+        // 新文件已持有锁，替换后其它进程需等待重建完成
+        ret = ret && (0 == ::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(packPath).constData()));
+        if (!ret) {
+            ::flock(packFd, LOCK_UN);
+        }
+    }
+
+    if (!ret) {
+        qCWarning(logImageViewer) << "Failed to rebuild thumbnail pack:" << packPath;
+        ::close(tempFd);
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    // 通知其它持有原文件的进程重新打开，本进程仍在读取原映射的线程在释放引用后解除映射
+    mapping->header()->retired.store(1, std::memory_order_release);
+    ::flock(packFd, LOCK_UN);
+    mapping.reset();
+    ::close(packFd);
+    packFd = tempFd;
+
+    qCDebug(logImageViewer) << "Rebuilt thumbnail pack:" << packPath << "capacity:" << oldCapacity << "->" << capacity
+                            << "entries:" << used;
+    ret = remapIfNeeded(0);
+    unlockPack();
+    return ret;
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef THUMBNAILPACKSTORE_H
+#define THUMBNAILPACKSTORE_H
+
+#include <QString>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+
+class ThumbnailPackMapping;
+
+class ThumbnailPackStore
+{
+public:
+    explicit ThumbnailPackStore(const QString &dirPath);
+    ~ThumbnailPackStore();
+
+    static bool find(const QString &filePath, QImage &thumbnail, QSize &sourceSize);
+    static bool insert(const QString &filePath, const QImage &image, const QSize &sourceSize);
+
+private:
+    static QString cacheDir();
+    static QSharedPointer<ThumbnailPackStore> storeForFile(const QString &filePath);
+    static void trimPacks(const QStringList &openPacks);
+
+    bool findImpl(const QString &filePath, QImage &thumbnail, QSize &sourceSize);
+    bool insertImpl(const QString &filePath, const QImage &image, const QSize &sourceSize);
+
+    QSharedPointer<ThumbnailPackMapping> acquireMapping(quint64 requiredSize);
+    bool openPack();
+    void closePack();
+    bool isRetired() const;
+    bool lockPack();
+    void unlockPack();
+    bool remapIfNeeded(quint64 requiredSize);
+    bool rebuildPack(quint32 capacity);
+
+private:
+    QString packPath;                                ///< 打包文件路径
+    QByteArray sourceDir;                            ///< 源目录路径(UTF-8)，记录于打包文件中
+    QMutex mutex;                                    ///< 保护文件描述符及映射，仅短暂持有
+    QMutex writeMutex;                               ///< 进程内写入及重建互斥，进程间通过 flock 互斥写入
+    int packFd { -1 };                               ///< 打包文件描述符
+    QSharedPointer<ThumbnailPackMapping> mapping;    ///< 当前文件映射，读取及重建期间持有引用
+
+    Q_DISABLE_COPY(ThumbnailPackStore)
+};
+
+#endif  // THUMBNAILPACKSTORE_H
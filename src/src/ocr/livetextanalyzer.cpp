@@ -17,10 +17,30 @@
 Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
 
 LiveTextAnalyzer::LiveTextAnalyzer(QObject *parent)
-    : QQuickImageProvider(Image),
-      ocrDriver(new DeepinOCRPlugin::DeepinOCRDriver)
+    : QQuickImageProvider(Image)
 {
     qCDebug(logImageViewer) << "Initializing LiveTextAnalyzer";
+
+    // 退出时终止文本识别
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &LiveTextAnalyzer::breakAnalyze);
+
+    if (QScreen *screen = qApp->primaryScreen()) {
+        pixelRatio = screen->devicePixelRatio();
+        qCDebug(logImageViewer) << "Screen pixel ratio:" << pixelRatio;
+    }
+}
+
+/**
+   @brief 首次识别时创建 OCR 驱动，加载插件及初始化硬件加速耗时较长，不在启动时执行
+ */
+void LiveTextAnalyzer::ensureDriver()
+{
+    if (ocrDriver) {
+        return;
+    }
+
+    qCDebug(logImageViewer) << "Creating OCR driver";
+    ocrDriver = new DeepinOCRPlugin::DeepinOCRDriver;
     ocrDriver->loadDefaultPlugin();
 
     // FIXME: Loong64 with llvm are temporarily unstable, disable GPU for now.
@@ -31,20 +51,13 @@ LiveTextAnalyzer::LiveTextAnalyzer(QObject *parent)
     qCDebug(logImageViewer) << "GPU acceleration disabled for LoongArch";
     ocrDriver->setUseHardware({});
 #endif
-
-    // 退出时终止文本识别
-    connect(qApp, &QCoreApplication::aboutToQuit, this, &LiveTextAnalyzer::breakAnalyze);
-
-    if (QScreen *screen = qApp->primaryScreen()) {
-        pixelRatio = screen->devicePixelRatio();
-        qCDebug(logImageViewer) << "Screen pixel ratio:" << pixelRatio;
-    }
 }
 
 void LiveTextAnalyzer::setImage(const QImage &image)
 {
     qCDebug(logImageViewer) << "Setting new image for OCR analysis, size:" << image.size();
     imageCache = image;
+    ensureDriver();
 
     QImage image_copy = image.convertToFormat(QImage::Format_RGB888);
     // If the device pixel ratio is > 1, we need to reset the width and height to get the actual position.
@@ -67,6 +80,7 @@ void LiveTextAnalyzer::analyze(const QString &token)
     // 此处使用token来标记本次识别的目标，后续的识别结果也随token发出
     // 外部调用的时候也凭借收到的token判断是否采用此次的识别结果
     // 以此来解决QML的信号延迟问题，但仅降低此问题的复现概率，没有完全解决
+    ensureDriver();
     QtConcurrent::run([this, token]() {
         while (ocrDriver->isRunning()) { };   // 等待之前的分析结束
         bool result = ocrDriver->analyze();
@@ -77,7 +91,7 @@ void LiveTextAnalyzer::analyze(const QString &token)
 
 void LiveTextAnalyzer::breakAnalyze()
 {
-    if (ocrDriver->isRunning()) {
+    if (ocrDriver && ocrDriver->isRunning()) {
         qCDebug(logImageViewer) << "Breaking current OCR analysis";
         ocrDriver->breakAnalyze();
     }
@@ -85,6 +99,10 @@ void LiveTextAnalyzer::breakAnalyze()
 
 QVariant LiveTextAnalyzer::liveBlock() const
 {
+    if (!ocrDriver) {
+        return QList<QVariant>();
+    }
+
     auto boxes = ocrDriver->getTextBoxes();
     qCDebug(logImageViewer) << "Getting text blocks, count:" << boxes.size();
 
@@ -104,7 +122,7 @@ QVariant LiveTextAnalyzer::liveBlock() const
 
 QVariant LiveTextAnalyzer::charBox(int blockIndex) const
 {
-    if (static_cast<size_t>(blockIndex) >= ocrDriver->getTextBoxes().size()) {
+    if (!ocrDriver || static_cast<size_t>(blockIndex) >= ocrDriver->getTextBoxes().size()) {
         qCWarning(logImageViewer) << "Invalid block index:" << blockIndex;
         return QVariant();
     }
@@ -125,7 +143,7 @@ QVariant LiveTextAnalyzer::charBox(int blockIndex) const
 
 QString LiveTextAnalyzer::textResult(int blockIndex, int startIndex, int len) const
 {
-    if (static_cast<size_t>(blockIndex) >= ocrDriver->getTextBoxes().size() || startIndex < 0 || len <= 0) {
+    if (!ocrDriver || static_cast<size_t>(blockIndex) >= ocrDriver->getTextBoxes().size() || startIndex < 0 || len <= 0) {
         qCWarning(logImageViewer) << "Invalid parameters for text result - block:" << blockIndex
                                   << "start:" << startIndex << "len:" << len;
         return "";
@@ -145,7 +163,7 @@ QImage LiveTextAnalyzer::requestImage(const QString &id, QSize *size, const QSiz
     auto startIndex = id.indexOf("_") + 1;
     size_t index = id.mid(startIndex).toUInt();
 
-    if (index >= ocrDriver->getTextBoxes().size()) {
+    if (!ocrDriver || index >= ocrDriver->getTextBoxes().size()) {
         qCWarning(logImageViewer) << "Invalid text box index:" << index;
         return QImage();
     }
@@ -34,7 +34,10 @@ protected:
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 
 private:
-    DeepinOCRPlugin::DeepinOCRDriver *ocrDriver;
+    void ensureDriver();
+
+private:
+    DeepinOCRPlugin::DeepinOCRDriver *ocrDriver { nullptr };  // 首次识别时创建
     QImage imageCache;
     qreal pixelRatio{1.0};  // for diff devicePixelRatio
 };
@@ -0,0 +1,200 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "standbycontroller.h"
+#include "commandparser.h"
+#include "filecontrol.h"
+#include "globalcontrol.h"
+#include "imagedata/imageprovider.h"
+#include "imagedata/imageinfo.h"
+#include "imagedata/imageinfoindex.h"
+#include "unionimage/decoderpool.h"
+
+#include <QGuiApplication>
+#include <QQuickWindow>
+#include <QTimerEvent>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QLoggingCategory>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static const int sc_DefaultIdleMinutes = 30;  // 默认待机空闲 30 分钟后退出
+static const int sc_TrimDelay = 1000;         // 进入待机后延迟释放内存，等待界面卸载完成
+static const int sc_ForwardTimeout = 1000;    // 转发图片至待机实例的 DBus 超时
+
+/**
+   @class StandbyController
+   @brief 待机模式控制，通过命令行参数 --standby 启用。启用时进程隐藏窗口常驻，
+        关闭窗口时不退出而是返回待机状态并释放缓存。通过 DBus 打开图片时立即展示窗口并开始解码，
+        无需重新初始化 Qt 、 QML 及 DTK 。
+   @note 待机空闲时间超过 --standby-idle 指定的分钟数(默认 30 分钟，为 0 时不限制)后退出进程，
+        完全归还内存，之后打开图片将由 DBus 服务重新启动。
+ */
+
+StandbyController::StandbyController(GlobalControl *control, FileControl *fileControl, ProviderCache *providerCache,
+                                     QObject *parent)
+    : QObject(parent)
+    , enabled(isRequested())
+    , control(control)
+    , fileControl(fileControl)
+    , providerCache(providerCache)
+{
+    if (!enabled) {
+        return;
+    }
+
+    bool ok = false;
+    int idleMinutes = CommandParser::instance()->value("standby-idle").toInt(&ok);
+    if (!ok || idleMinutes < 0) {
+        idleMinutes = sc_DefaultIdleMinutes;
+    }
+    idleInterval = idleMinutes * 60 * 1000;
+
+    // 窗口隐藏时不退出，由空闲超时或会话结束退出
+    QGuiApplication::setQuitOnLastWindowClosed(false);
+    qCInfo(logImageViewer) << "Standby mode enabled, idle minutes:" << idleMinutes;
+}
+
+StandbyController::~StandbyController() { }
+
+/**
+   @return 是否通过命令行参数 --standby 启用待机模式
+ */
+bool StandbyController::isRequested()
+{
+    return CommandParser::instance()->isSet("standby");
+}
+
+/**
+   @brief 当前会话中存在处于待机状态的实例时，将图片列表 \a localPaths 转发至该实例，并展示 \a currentPath
+   @return 是否转发成功，未启用待机模式的实例不会接收转发，保持原有的多实例行为
+ */
+bool StandbyController::forwardToStandby(const QStringList &localPaths, const QString &currentPath)
+{
+    QDBusConnectionInterface *busInterface = QDBusConnection::sessionBus().interface();
+    // 服务未注册时不调用，避免 DBus 激活新的实例
+    if (!busInterface || !busInterface->isServiceRegistered("com.deepin.imageViewer")) {
+        return false;
+    }
+
+    QDBusInterface standby("com.deepin.imageViewer", "/", "com.deepin.imageViewer", QDBusConnection::sessionBus());
+    standby.setTimeout(sc_ForwardTimeout);
+    // 单张图片由待机实例扫描所在文件夹，多张图片仅浏览指定的列表
+    QDBusReply<bool> reply = (localPaths.size() > 1) ? standby.call("openImageFilesInStandby", localPaths, currentPath)
+                                                      : standby.call("openImageFileInStandby", currentPath);
+    if (!reply.isValid()) {
+        qCDebug(logImageViewer) << "Forward to standby instance failed:" << reply.error().message();
+        return false;
+    }
+
+    qCInfo(logImageViewer) << "Forward image to standby instance:" << currentPath << "count:" << localPaths.size()
+                           << "accepted:" << reply.value();
+    return reply.value();
+}
+
+bool StandbyController::isEnabled() const
+{
+    return enabled;
+}
+
+/**
+   @return 是否处于待机状态(窗口隐藏)
+ */
+bool StandbyController::isActive() const
+{
+    return active;
+}
+
+void StandbyController::setWindow(QQuickWindow *w)
+{
+    window = w;
+}
+
+/**
+   @brief 进入待机状态，隐藏窗口，清空图片列表并延迟释放缓存，开始空闲计时
+ */
+void StandbyController::enterStandby()
+{
+    if (!enabled || active) {
+        return;
+    }
+
+    qCInfo(logImageViewer) << "Entering standby.";
+    active = true;
+    Q_EMIT activeChanged();
+
+    fileControl->terminateShortcutPanelProcess();
+    fileControl->resetImageFiles();
+    control->setImageFiles({}, QString());
+
+    trimTimer.start(sc_TrimDelay, this);
+    if (idleInterval > 0) {
+        idleTimer.start(idleInterval, this);
+    }
+}
+
+/**
+   @brief 通过 DBus 打开图片 \a urlPath 时退出待机状态，先开始解码，再展示窗口
+ */
+void StandbyController::wake(const QString &urlPath)
+{
+    if (!active) {
+        return;
+    }
+
+    qCInfo(logImageViewer) << "Waking from standby:" << urlPath;
+    trimTimer.stop();
+    idleTimer.stop();
+    providerCache->preloadImage(urlPath);
+
+    active = false;
+    Q_EMIT activeChanged();
+
+    if (window) {
+        window->raise();
+        window->requestActivate();
+    }
+}
+
+void StandbyController::timerEvent(QTimerEvent *event)
+{
+    if (trimTimer.timerId() == event->timerId()) {
+        trimTimer.stop();
+        trimMemory();
+    } else if (idleTimer.timerId() == event->timerId()) {
+        idleTimer.stop();
+        qCInfo(logImageViewer) << "Standby idle timeout, exiting.";
+        QCoreApplication::quit();
+    }
+
+    QObject::timerEvent(event);
+}
+
+/**
+   @brief 释放图像缓存、图片信息及缩略图缓存、索引文件映射、解码辅助进程及场景图资源，
+    并将空闲的堆内存归还系统
+ */
+void StandbyController::trimMemory()
+{
+    providerCache->clearCache();
+    // 同时清理缩略图缓存，路径驻留表不回收，唤醒时预载的图像 ID 保持有效
+    ImageInfo::clearCache();
+    ImageInfoIndex::instance()->release();
+    DecoderPool::instance()->releaseHelpers();
+    if (window) {
+        window->releaseResources();
+    }
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    qCInfo(logImageViewer) << "Standby memory trimmed.";
+}
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef STANDBYCONTROLLER_H
+#define STANDBYCONTROLLER_H
+
+#include <QObject>
+#include <QBasicTimer>
+#include <QPointer>
+
+class QQuickWindow;
+class GlobalControl;
+class FileControl;
+class ProviderCache;
+
+class StandbyController : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled CONSTANT)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+
+public:
+    explicit StandbyController(GlobalControl *control, FileControl *fileControl, ProviderCache *providerCache,
+                               QObject *parent = nullptr);
+    ~StandbyController() override;
+
+    // 是否通过命令行参数 --standby 启用待机模式
+    static bool isRequested();
+    // 转发图片至处于待机状态的实例，成功时当前进程无需继续启动
+    static bool forwardToStandby(const QStringList &localPaths, const QString &currentPath);
+
+    bool isEnabled() const;
+    bool isActive() const;
+    Q_SIGNAL void activeChanged();
+
+    void setWindow(QQuickWindow *window);
+    // 关闭窗口时进入待机状态，隐藏窗口并释放缓存
+    Q_INVOKABLE void enterStandby();
+    // 打开图片 urlPath ，退出待机状态并展示窗口
+    void wake(const QString &urlPath);
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    void trimMemory();
+
+private:
+    bool enabled = false;
+    bool active = false;
+    int idleInterval = 0;  // 待机空闲超时(ms)，超时后退出进程，为 0 时不退出
+
+    GlobalControl *control = nullptr;
+    FileControl *fileControl = nullptr;
+    ProviderCache *providerCache = nullptr;
+    QPointer<QQuickWindow> window;
+
+    QBasicTimer trimTimer;  // 界面卸载后释放内存
+    QBasicTimer idleTimer;  // 待机空闲超时
+};
+
+#endif  // STANDBYCONTROLLER_H
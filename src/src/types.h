@@ -13,6 +13,7 @@ class Types : public QObject
     Q_ENUMS(ItemRole)
     Q_ENUMS(ImageType)
     Q_ENUMS(StackPage)
+    Q_ENUMS(ImageSortOrder)
 
 public:
     explicit Types(QObject *parent = nullptr);
@@ -45,6 +46,17 @@ public:
         ImageViewPage,   ///< 图片展示界面(含缩略图栏)
         SliderShowPage,  ///< 图片动画展示界面
     };
+
+    /**
+       @brief 图片排序方式
+     */
+    enum ImageSortOrder {
+        SortByName,          ///< 文件名自然顺序
+        SortByCaptureTime,   ///< 拍摄时间，无拍摄时间时为文件修改时间
+        SortByModifiedTime,  ///< 文件修改时间
+        SortByFileSize,      ///< 文件大小
+        SortByPixelCount,    ///< 图片像素数
+    };
 };
 
 #endif  // TYPES_H
@@ -0,0 +1,570 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "decoderpool.h"
+#include "unionimage.h"
+#include "utils/tracerecorder.h"
+
+#include <QFile>
+#include <QThread>
+#include <QImageReader>
+#include <QGuiApplication>
+#include <QLoggingCategory>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static const char *const sc_HelperArgument = "--decoder-helper";
+static const char *const sc_HelperCountEnv = "DEEPIN_IMAGE_VIEWER_DECODER_HELPERS";
+static const quint32 sc_ProtocolMagic = 0x44564944;   // "DIVD"
+static const int sc_HelperFd = 3;                     // 辅助进程中通信套接字的文件描述符
+static const int sc_MaxPathLength = 16 * 1024;        // 请求中路径的最大长度
+static const int sc_MaxErrorLength = 1024;            // 应答中错误信息的最大长度
+static const int sc_DecodeTimeout = 30 * 1000;        // 单次解码超时时间 30s
+static const int sc_MaxHelperRequests = 256;          // 辅助进程处理此数量的请求后重启，回收解码库泄漏的内存
+static const int sc_MaxHelperAttempts = 2;            // 辅助进程异常退出时重启重试一次，仍失败则回退到进程内解码
+
+// 解码请求，后接 pathLength 字节的本地编码路径
+struct DecodeRequest
+{
+    quint32 magic;
+    qint32 frameIndex;
+    qint32 targetWidth;
+    qint32 targetHeight;
+    quint32 pathLength;
+};
+
+// 解码应答，后接 errorLength 字节的 UTF-8 错误信息，成功时通过 SCM_RIGHTS 附带存储像素数据的 memfd
+struct DecodeReply
+{
+    quint32 magic;
+    qint32 ok;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+    qint32 sourceWidth;
+    qint32 sourceHeight;
+    quint32 errorLength;
+};
+
+struct SharedMapping
+{
+    void *addr;
+    size_t length;
+};
+
+static void releaseSharedMapping(void *info)
+{
+    SharedMapping *mapping = static_cast<SharedMapping *>(info);
+    munmap(mapping->addr, mapping->length);
+    delete mapping;
+}
+
+/**
+   @brief 回收已关闭的辅助进程 \a pid ，可能阻塞至辅助进程退出，调用时不能持有进程池的锁
+ */
+static void reapHelper(qint64 pid)
+{
+    if (pid <= 0) {
+        return;
+    }
+
+    while (waitpid(pid_t(pid), nullptr, 0) < 0 && EINTR == errno) {
+    }
+}
+
+/**
+   @brief 解码图像 \a path 的第 \a frameIndex 帧，图像超过 \a targetSize 时按比例缩小
+   @param sourceSize 传出原始图像大小
+ */
+static bool decodeInProcess(const QString &path, int frameIndex, const QSize &targetSize, QImage &image, QSize &sourceSize,
+                            QString &errorMsg)
+{
+    if (frameIndex > 0) {
+        TraceSpan decodeSpan("image", "decode", path);
+        QImageReader reader(path);
+        if (!reader.jumpToImage(frameIndex)) {
+            errorMsg = QString("Failed to jump to frame %1").arg(frameIndex);
+            return false;
+        }
+        image = reader.read();
+        if (image.isNull()) {
+            errorMsg = reader.errorString();
+            return false;
+        }
+    } else if (!LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, errorMsg)) {
+        return false;
+    }
+
+    sourceSize = image.size();
+    if (targetSize.isValid() && (image.width() > targetSize.width() || image.height() > targetSize.height())) {
+        TraceSpan scaleSpan("image", "scale", path);
+        image = image.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return true;
+}
+
+/**
+   @brief 将图像 \a image 的像素数据写入新建的 memfd ，并填充应答 \a reply 中的图像参数
+   @return 返回 memfd ，失败返回 -1
+ */
+static int writeSharedImage(QImage image, DecodeReply &reply)
+{
+    // 索引色图像的颜色表不随像素传递，转换为真彩色
+    if (image.format() <= QImage::Format_Indexed8) {
+        image = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    }
+
+    const size_t length = size_t(image.sizeInBytes());
+    int memFd = memfd_create("deepin-image-viewer-decode", MFD_CLOEXEC);
+    if (memFd < 0) {
+        return -1;
+    }
+
+    if (0 != ftruncate(memFd, off_t(length))) {
+        close(memFd);
+        return -1;
+    }
+
+    void *addr = mmap(nullptr, length, PROT_WRITE, MAP_SHARED, memFd, 0);
+    if (MAP_FAILED == addr) {
+        close(memFd);
+        return -1;
+    }
+    memcpy(addr, image.constBits(), length);
+    munmap(addr, length);
+
+    reply.width = image.width();
+    reply.height = image.height();
+    reply.bytesPerLine = int(image.bytesPerLine());
+    reply.format = image.format();
+    return memFd;
+}
+
+/**
+   @brief 映射辅助进程传递的 memfd \a memFd ，构造引用映射内存的只读图像，无需拷贝像素数据
+ */
+static QImage mapSharedImage(int memFd, const DecodeReply &reply)
+{
+    if (reply.width <= 0 || reply.height <= 0 || reply.format <= QImage::Format_Indexed8
+        || reply.format >= QImage::NImageFormats) {
+        return QImage();
+    }
+
+    const size_t length = size_t(reply.bytesPerLine) * size_t(reply.height);
+    struct stat st;
+    if (0 != fstat(memFd, &st) || size_t(st.st_size) < length) {
+        return QImage();
+    }
+
+    void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, memFd, 0);
+    if (MAP_FAILED == addr) {
+        return QImage();
+    }
+
+    return QImage(static_cast<const uchar *>(addr), reply.width, reply.height, reply.bytesPerLine,
+                  QImage::Format(reply.format), releaseSharedMapping, new SharedMapping { addr, length });
+}
+
+/**
+   @class DecoderPool
+   @brief 进程外解码辅助进程池
+   @details 设置环境变量 DEEPIN_IMAGE_VIEWER_DECODER_HELPERS 为 N 时启用，启动 N 个辅助进程
+    (当前程序以 --decoder-helper 参数启动)，通过本地套接字发送解码请求 (路径、帧号、目标大小)，
+    辅助进程将像素数据写入 memfd 并传回，主进程直接映射使用。
+    不同解码库可在多个进程中并行执行，不受解码库内部全局锁的影响；异常文件导致的崩溃仅影响辅助进程；
+    辅助进程处理一定数量的请求后重启，回收解码库泄漏的内存。未启用时在当前进程内解码。
+    辅助进程读取到套接字关闭(主进程退出或崩溃时由内核关闭)后退出，不依赖父线程存活。
+   @threadsafe
+ */
+
+DecoderPool::DecoderPool(int count)
+    : available(count)
+    , helpers(count)
+{
+    qCDebug(logImageViewer) << "DecoderPool created, helper count:" << count;
+}
+
+DecoderPool::~DecoderPool()
+{
+    QVector<qint64> pids;
+    {
+        QMutexLocker locker(&mutex);
+        for (Helper &helper : helpers) {
+            pids.append(shutdown(&helper, false));
+        }
+    }
+
+    for (qint64 pid : pids) {
+        reapHelper(pid);
+    }
+}
+
+DecoderPool *DecoderPool::instance()
+{
+    static DecoderPool ins(qBound(0, qEnvironmentVariableIntValue(sc_HelperCountEnv), QThread::idealThreadCount()));
+    return &ins;
+}
+
+/**
+   @return 返回是否启用了进程外解码
+ */
+bool DecoderPool::isEnabled() const
+{
+    return !helpers.isEmpty();
+}
+
+/**
+   @brief 解码图像 \a path 的第 \a frameIndex 帧，启用辅助进程时进程外解码，否则在当前线程解码
+   @param targetSize 目标大小，图像超过此大小时按比例缩小，无效时保持原始大小
+   @param sourceSize 传出原始图像大小，可为空
+ */
+bool DecoderPool::loadImage(const QString &path, int frameIndex, const QSize &targetSize, QImage &image, QSize *sourceSize,
+                            QString &errorMsg)
+{
+    DecoderPool *pool = instance();
+    if (pool->isEnabled()) {
+        return pool->decode(path, frameIndex, targetSize, image, sourceSize, errorMsg);
+    }
+
+    QSize size;
+    bool ret = decodeInProcess(path, frameIndex, targetSize, image, size, errorMsg);
+    if (sourceSize) {
+        *sourceSize = size;
+    }
+    return ret;
+}
+
+/**
+   @brief 通过辅助进程解码图像，参数同 loadImage() 。辅助进程崩溃或超时时重启辅助进程重试一次，
+    仍失败或无法启动辅助进程时回退到进程内解码
+ */
+bool DecoderPool::decode(const QString &path, int frameIndex, const QSize &targetSize, QImage &image, QSize *sourceSize,
+                         QString &errorMsg)
+{
+    // 辅助进程中的读取、解码及缩放均计入此区间
+    TraceSpan decodeSpan("image", "decode (helper)", path);
+    const QByteArray pathData = QFile::encodeName(path);
+    if (pathData.size() > sc_MaxPathLength) {
+        errorMsg = "Image path too long";
+        return false;
+    }
+
+    for (int attempt = 0; attempt < sc_MaxHelperAttempts; ++attempt) {
+        Helper *helper = acquire();
+        if (!helper) {
+            break;
+        }
+
+        const HelperResult result = sendRequest(helper, pathData, frameIndex, targetSize, image, sourceSize, errorMsg);
+        if (HelperLost != result) {
+            return Decoded == result;
+        }
+        qCWarning(logImageViewer) << "Decoder helper lost, attempt:" << attempt + 1 << path;
+    }
+
+    qCWarning(logImageViewer) << "Decoder helper unavailable, decode in process:" << path;
+    errorMsg.clear();
+    QSize size;
+    bool ret = decodeInProcess(path, frameIndex, targetSize, image, size, errorMsg);
+    if (sourceSize) {
+        *sourceSize = size;
+    }
+    return ret;
+}
+
+/**
+   @brief 向已取得的辅助进程 \a helper 发送解码请求并等待应答，参数同 loadImage() ，返回后 \a helper 已归还
+   @return 返回解码结果，辅助进程无响应或异常退出时返回 HelperLost ，此时辅助进程已被关闭
+ */
+DecoderPool::HelperResult DecoderPool::sendRequest(Helper *helper, const QByteArray &pathData, int frameIndex, const QSize &targetSize,
+                                                   QImage &image, QSize *sourceSize, QString &errorMsg)
+{
+    DecodeRequest request { sc_ProtocolMagic, frameIndex, targetSize.width(), targetSize.height(), quint32(pathData.size()) };
+    iovec requestIov[2] = { { &request, sizeof(request) }, { const_cast<char *>(pathData.constData()), size_t(pathData.size()) } };
+    msghdr requestMsg {};
+    requestMsg.msg_iov = requestIov;
+    requestMsg.msg_iovlen = 2;
+
+    pollfd pfd { helper->fd, POLLIN, 0 };
+    if (sendmsg(helper->fd, &requestMsg, MSG_NOSIGNAL) < 0 || poll(&pfd, 1, sc_DecodeTimeout) <= 0) {
+        qCWarning(logImageViewer) << "Decoder helper not responding, restart:" << helper->pid;
+        reapHelper(shutdown(helper, true));
+        release(helper);
+        errorMsg = "Decoder helper not responding";
+        return HelperLost;
+    }
+
+    DecodeReply reply {};
+    QByteArray errorData(sc_MaxErrorLength, Qt::Uninitialized);
+    iovec replyIov[2] = { { &reply, sizeof(reply) }, { errorData.data(), size_t(errorData.size()) } };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr replyMsg {};
+    replyMsg.msg_iov = replyIov;
+    replyMsg.msg_iovlen = 2;
+    replyMsg.msg_control = control;
+    replyMsg.msg_controllen = sizeof(control);
+
+    ssize_t len = recvmsg(helper->fd, &replyMsg, MSG_CMSG_CLOEXEC);
+    if (len < ssize_t(sizeof(reply)) || sc_ProtocolMagic != reply.magic) {
+        // 辅助进程在解码时崩溃或已退出
+        qCWarning(logImageViewer) << "Decoder helper exited unexpectedly:" << helper->pid;
+        reapHelper(shutdown(helper, true));
+        release(helper);
+        errorMsg = "Decoder helper exited unexpectedly";
+        return HelperLost;
+    }
+
+    int memFd = -1;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&replyMsg); cmsg; cmsg = CMSG_NXTHDR(&replyMsg, cmsg)) {
+        if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+            memcpy(&memFd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    helper->requestCount++;
+    release(helper);
+
+    if (!reply.ok || memFd < 0) {
+        const int errorLength = qMin(int(reply.errorLength), int(len - ssize_t(sizeof(reply))));
+        errorMsg = QString::fromUtf8(errorData.constData(), qMax(0, errorLength));
+        if (memFd >= 0) {
+            close(memFd);
+        }
+        return Failed;
+    }
+
+    image = mapSharedImage(memFd, reply);
+    close(memFd);
+    if (image.isNull()) {
+        errorMsg = "Failed to map decoded image";
+        return Failed;
+    }
+
+    if (sourceSize) {
+        *sourceSize = QSize(reply.sourceWidth, reply.sourceHeight);
+    }
+    return Decoded;
+}
+
+/**
+   @brief 关闭空闲的辅助进程，用于进入待机状态时归还解码库占用的内存，下次解码时重新启动
+ */
+void DecoderPool::releaseHelpers()
+{
+    QVector<qint64> pids;
+    {
+        QMutexLocker locker(&mutex);
+        for (Helper &helper : helpers) {
+            if (!helper.busy) {
+                pids.append(shutdown(&helper, false));
+            }
+        }
+    }
+
+    for (qint64 pid : pids) {
+        reapHelper(pid);
+    }
+    qCDebug(logImageViewer) << "Idle decoder helpers released:" << pids.size();
+}
+
+/**
+   @return 返回启动参数是否为解码辅助进程
+ */
+bool DecoderPool::isHelperCommand(int argc, char *argv[])
+{
+    return argc >= 2 && 0 == qstrcmp(argv[1], sc_HelperArgument);
+}
+
+/**
+   @brief 解码辅助进程主循环，逐个处理主进程的解码请求，主进程关闭套接字后退出
+ */
+int DecoderPool::execHelper(int argc, char *argv[])
+{
+    // 辅助进程不显示界面，仅需图像插件
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    QByteArray buffer(int(sizeof(DecodeRequest)) + sc_MaxPathLength, Qt::Uninitialized);
+    while (true) {
+        ssize_t len = recv(sc_HelperFd, buffer.data(), size_t(buffer.size()), 0);
+        if (len < 0 && EINTR == errno) {
+            continue;
+        }
+        if (len <= 0) {
+            break;
+        }
+
+        DecodeRequest request {};
+        DecodeReply reply {};
+        reply.magic = sc_ProtocolMagic;
+        QString errorMsg;
+        QImage image;
+        QSize sourceSize;
+        int memFd = -1;
+
+        memcpy(&request, buffer.constData(), qMin(size_t(len), sizeof(request)));
+        if (len < ssize_t(sizeof(request)) || sc_ProtocolMagic != request.magic
+            || ssize_t(request.pathLength) != len - ssize_t(sizeof(request))) {
+            errorMsg = "Invalid decode request";
+        } else {
+            const QString path = QFile::decodeName(QByteArray(buffer.constData() + sizeof(request), int(request.pathLength)));
+            const QSize targetSize(request.targetWidth, request.targetHeight);
+            if (decodeInProcess(path, request.frameIndex, targetSize, image, sourceSize, errorMsg)) {
+                memFd = writeSharedImage(image, reply);
+                if (memFd < 0) {
+                    errorMsg = "Failed to create shared memory";
+                }
+            }
+        }
+
+        reply.ok = memFd >= 0;
+        reply.sourceWidth = sourceSize.width();
+        reply.sourceHeight = sourceSize.height();
+        const QByteArray errorData = errorMsg.toUtf8().left(sc_MaxErrorLength);
+        reply.errorLength = quint32(errorData.size());
+
+        iovec iov[2] = { { &reply, sizeof(reply) }, { const_cast<char *>(errorData.constData()), size_t(errorData.size()) } };
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr msg {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        if (memFd >= 0) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &memFd, sizeof(int));
+        }
+
+        ssize_t ret = sendmsg(sc_HelperFd, &msg, MSG_NOSIGNAL);
+        if (memFd >= 0) {
+            close(memFd);
+        }
+        if (ret < 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+   @return 取得空闲的辅助进程，辅助进程未启动时启动，所有辅助进程均忙碌时等待
+ */
+DecoderPool::Helper *DecoderPool::acquire()
+{
+    available.acquire();
+
+    QMutexLocker locker(&mutex);
+    for (Helper &helper : helpers) {
+        if (helper.busy) {
+            continue;
+        }
+
+        if (helper.fd < 0 && !spawn(&helper)) {
+            break;
+        }
+        helper.busy = true;
+        return &helper;
+    }
+
+    available.release();
+    return nullptr;
+}
+
+/**
+   @brief 归还辅助进程 \a helper ，处理的请求数达到上限时关闭，下次使用时重新启动
+ */
+void DecoderPool::release(Helper *helper)
+{
+    qint64 pid = -1;
+    {
+        QMutexLocker locker(&mutex);
+        if (helper->requestCount >= sc_MaxHelperRequests) {
+            qCDebug(logImageViewer) << "Decoder helper reached request limit, restart:" << helper->pid;
+            pid = shutdown(helper, false);
+        }
+        helper->busy = false;
+    }
+    available.release();
+
+    // 等待辅助进程退出时不持有锁，避免阻塞其它线程取得辅助进程
+    reapHelper(pid);
+}
+
+/**
+   @brief 启动辅助进程 \a helper ，通信套接字在子进程中固定为 sc_HelperFd
+ */
+bool DecoderPool::spawn(Helper *helper)
+{
+    int fds[2];
+    if (0 != socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds)) {
+        qCWarning(logImageViewer) << "Failed to create decoder helper socket:" << strerror(errno);
+        return false;
+    }
+
+    // fork 后仅调用异步信号安全的函数，参数需提前准备
+    QByteArray program = QFile::encodeName(QCoreApplication::applicationFilePath());
+    QByteArray argument(sc_HelperArgument);
+    char *const argv[] = { program.data(), argument.data(), nullptr };
+
+    // 不使用 PR_SET_PDEATHSIG ：其在创建子进程的线程退出时触发，线程池中的线程空闲超时即会退出。
+    // 主进程退出时内核关闭套接字，辅助进程读取到套接字关闭后退出
+    pid_t pid = fork();
+    if (0 == pid) {
+        if (fds[1] == sc_HelperFd) {
+            fcntl(sc_HelperFd, F_SETFD, 0);
+        } else {
+            dup2(fds[1], sc_HelperFd);
+        }
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    if (pid < 0) {
+        qCWarning(logImageViewer) << "Failed to start decoder helper:" << strerror(errno);
+        close(fds[0]);
+        return false;
+    }
+
+    qCDebug(logImageViewer) << "Decoder helper started, pid:" << pid;
+    helper->pid = pid;
+    helper->fd = fds[0];
+    helper->requestCount = 0;
+    return true;
+}
+
+/**
+   @brief 关闭辅助进程 \a helper ，辅助进程读取到套接字关闭后退出，\a force 为 true 时直接结束进程
+   @return 返回需通过 reapHelper() 回收的进程 pid ，未启动时返回 -1
+ */
+qint64 DecoderPool::shutdown(Helper *helper, bool force)
+{
+    if (helper->fd >= 0) {
+        close(helper->fd);
+        helper->fd = -1;
+    }
+
+    const qint64 pid = helper->pid;
+    if (pid > 0 && force) {
+        kill(pid_t(pid), SIGKILL);
+    }
+    helper->pid = -1;
+    helper->requestCount = 0;
+    return pid;
+}
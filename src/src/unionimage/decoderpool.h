@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QVector>
+
+class DecoderPool
+{
+public:
+    static DecoderPool *instance();
+    bool isEnabled() const;
+
+    static bool loadImage(const QString &path, int frameIndex, const QSize &targetSize, QImage &image, QSize *sourceSize,
+                          QString &errorMsg);
+    bool decode(const QString &path, int frameIndex, const QSize &targetSize, QImage &image, QSize *sourceSize, QString &errorMsg);
+    void releaseHelpers();
+
+    // 解码辅助进程入口
+    static bool isHelperCommand(int argc, char *argv[]);
+    static int execHelper(int argc, char *argv[]);
+
+private:
+    struct Helper
+    {
+        qint64 pid = -1;        ///< 辅助进程 pid
+        int fd = -1;            ///< 与辅助进程通信的套接字
+        int requestCount = 0;   ///< 已处理的请求数，超过上限后重启辅助进程以回收内存
+        bool busy = false;
+    };
+
+    enum HelperResult {
+        Decoded,
+        Failed,      ///< 辅助进程返回解码失败
+        HelperLost   ///< 辅助进程无响应或异常退出
+    };
+
+    explicit DecoderPool(int count);
+    ~DecoderPool();
+
+    Helper *acquire();
+    void release(Helper *helper);
+    HelperResult sendRequest(Helper *helper, const QByteArray &pathData, int frameIndex, const QSize &targetSize, QImage &image,
+                             QSize *sourceSize, QString &errorMsg);
+    bool spawn(Helper *helper);
+    qint64 shutdown(Helper *helper, bool force);
+
+private:
+    QMutex mutex;
+    QSemaphore available;
+    QVector<Helper> helpers;
+
+    Q_DISABLE_COPY(DecoderPool)
+};
+
+#endif  // DECODERPOOL_H
@@ -0,0 +1,358 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imageformatregistry.h"
+
+#include <QFile>
+#include <QLoggingCategory>
+
+#include <cstring>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+namespace {
+
+typedef ImageFormatRegistry R;
+
+/*
+   格式注册表，同一格式族中首个条目为识别文件内容时返回的格式(如 JPG 、TIFF)。
+   新增条目后若编译期检测到名称哈希冲突，调整 s_hashSeed 即可。
+ */
+constexpr R::Format s_formats[] = {
+    { "BMP", R::Read | R::Save | R::Rotate | R::WallPaper, R::FamilyBmp },
+    { "JPG", R::Read | R::Save | R::Rotate | R::WallPaper, R::FamilyJpeg },
+    { "JPEG", R::Read | R::Save | R::Rotate | R::WallPaper, R::FamilyJpeg },
+    { "JPE", R::Read | R::WallPaper, R::FamilyJpeg },
+    { "JPS", R::Read, R::FamilyJpeg },
+    { "JFIF", R::WallPaper, R::FamilyJpeg },
+    { "PNG", R::Read | R::Save | R::Rotate | R::WallPaper, R::FamilyPng },
+    { "PBM", R::Read, R::FamilyPbm },
+    { "PGM", R::Read | R::Save | R::Rotate, R::FamilyPgm },
+    { "PPM", R::Read | R::Save | R::Rotate, R::FamilyPpm },
+    { "PNM", R::Read, R::FamilyNone },
+    { "WBMP", R::Read, R::FamilyNone },
+    { "WEBP", R::Read | R::Animated, R::FamilyWebp },
+    { "SVG", R::Read, R::FamilySvg },
+    { "ICNS", R::Read | R::Save | R::Rotate | R::MultiPage, R::FamilyIcns },
+    { "GIF", R::Read | R::WallPaper | R::Animated, R::FamilyGif },
+    { "MNG", R::Read | R::Animated, R::FamilyMng },
+    { "TIFF", R::Read | R::WallPaper | R::MultiPage, R::FamilyTiff },
+    { "TIF", R::Read | R::WallPaper | R::MultiPage, R::FamilyTiff },
+    { "XPM", R::Read | R::Save | R::Rotate, R::FamilyXpm },
+    { "ICO", R::Read | R::Save | R::Rotate | R::MultiPage, R::FamilyIco },
+    { "HEIC", R::Read | R::MultiPage, R::FamilyHeif },
+    { "HEIF", R::Read | R::MultiPage, R::FamilyHeif },
+    { "HEJ2", R::Read, R::FamilyNone },
+    { "AVIF", R::Read | R::Animated, R::FamilyAvif },
+    { "AVIFS", R::Read | R::Animated, R::FamilyAvif },
+    { "JP2", R::Read, R::FamilyJp2 },
+    { "J2K", R::Read, R::FamilyJ2k },
+    { "PSD", R::Read, R::FamilyPsd },
+    { "HDR", R::Read, R::FamilyHdr },
+    { "TGA", R::Read, R::FamilyNone },
+    { "PXM", R::Read, R::FamilyNone },
+    { "PIC", R::Read, R::FamilyNone },
+    { "XBM", R::Read, R::FamilyNone },
+    // 无固定文件头，同一后缀也可能为非图片文件，列出前需校验文件内容
+    { "VIFF", R::Read | R::ContentCheck, R::FamilyNone },
+    { "IFF", R::Read | R::ContentCheck, R::FamilyNone },
+    { "WMF", R::Read | R::ContentCheck, R::FamilyNone },
+    { "EPS", R::Read | R::ContentCheck, R::FamilyNone },
+    // RAW 格式多基于 TIFF 容器，以后缀为准
+    { "DNG", R::Read, R::FamilyNone },
+    { "RAF", R::Read, R::FamilyNone },
+    { "CR2", R::Read, R::FamilyNone },
+    { "CRW", R::Read, R::FamilyNone },
+    { "MEF", R::Read, R::FamilyNone },
+    { "ORF", R::Read, R::FamilyNone },
+    { "RAW", R::Read, R::FamilyNone },
+    { "MRW", R::Read, R::FamilyNone },
+    { "NEF", R::Read, R::FamilyNone },
+    { "PEF", R::Read, R::FamilyNone },
+    { "ARW", R::Read, R::FamilyNone },
+    { "X3F", R::Read, R::FamilyNone },
+    { "SR2", R::Read, R::FamilyNone },
+    { "DDS", 0, R::FamilyDds },
+};
+
+constexpr int s_formatCount = sizeof(s_formats) / sizeof(s_formats[0]);
+constexpr int s_maxNameLength = 8;
+constexpr int s_tableSize = 256;        // 哈希表大小，必须为 2 的幂
+constexpr quint32 s_hashSeed = 25;      // 使所有格式名称无冲突的哈希种子
+constexpr int s_headerSize = 1024;      // 识别文件内容读取的文件头大小
+
+constexpr char asciiUpper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+constexpr quint32 hashStep(quint32 hash, char c)
+{
+    return (hash ^ static_cast<quint8>(asciiUpper(c))) * 16777619u;
+}
+
+constexpr quint32 hashFinish(quint32 hash)
+{
+    return (hash ^ (hash >> 15)) & (s_tableSize - 1);
+}
+
+constexpr quint32 hashName(const char *name)
+{
+    quint32 hash = 2166136261u ^ s_hashSeed;
+    for (int i = 0; name[i]; ++i) {
+        hash = hashStep(hash, name[i]);
+    }
+    return hashFinish(hash);
+}
+
+struct SlotTable
+{
+    qint8 slots[s_tableSize];
+};
+
+constexpr bool isPerfectHash()
+{
+    bool used[s_tableSize] {};
+    for (int i = 0; i < s_formatCount; ++i) {
+        const quint32 slot = hashName(s_formats[i].name);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr SlotTable buildSlotTable()
+{
+    SlotTable table {};
+    for (int i = 0; i < s_tableSize; ++i) {
+        table.slots[i] = -1;
+    }
+    for (int i = 0; i < s_formatCount; ++i) {
+        table.slots[hashName(s_formats[i].name)] = static_cast<qint8>(i);
+    }
+    return table;
+}
+
+static_assert(s_formatCount < 128, "format index must fit in slot table");
+static_assert(isPerfectHash(), "format name hash collision, adjust s_hashSeed");
+constexpr SlotTable s_slotTable = buildSlotTable();
+
+/**
+   @brief 文件头特征，两段特征均匹配时识别为对应格式族，offset 为 -1 时在文件头中查找
+ */
+struct Magic
+{
+    quint8 family;
+    int offset;
+    const char *bytes;
+    int length;
+    int offset2;
+    const char *bytes2;
+    int length2;
+};
+
+constexpr Magic s_magics[] = {
+    { R::FamilyPng, 0, "\x89PNG\x0d\x0a\x1a\x0a", 8, 0, nullptr, 0 },
+    { R::FamilyJpeg, 0, "\xff\xd8", 2, 0, nullptr, 0 },
+    { R::FamilyGif, 0, "GIF8", 4, 0, nullptr, 0 },
+    { R::FamilyWebp, 0, "RIFF", 4, 8, "WEBP", 4 },
+    { R::FamilyBmp, 0, "BM", 2, 0, nullptr, 0 },
+    { R::FamilyTiff, 0, "MM\x00\x2a", 4, 0, nullptr, 0 },
+    { R::FamilyTiff, 0, "II\x2a\x00", 4, 0, nullptr, 0 },
+    { R::FamilyHeif, 4, "ftypheic", 8, 0, nullptr, 0 },
+    { R::FamilyHeif, 4, "ftypheix", 8, 0, nullptr, 0 },
+    { R::FamilyHeif, 4, "ftyphevc", 8, 0, nullptr, 0 },
+    { R::FamilyHeif, 4, "ftypmif1", 8, 0, nullptr, 0 },
+    { R::FamilyAvif, 4, "ftypavif", 8, 0, nullptr, 0 },
+    { R::FamilyAvif, 4, "ftypavis", 8, 0, nullptr, 0 },
+    { R::FamilyMng, 0, "\x8aMNG\x0d\x0a\x1a\x0a", 8, 0, nullptr, 0 },
+    { R::FamilyIcns, 0, "icns", 4, 0, nullptr, 0 },
+    { R::FamilyIco, 0, "\x00\x00\x01\x00", 4, 0, nullptr, 0 },
+    { R::FamilyPsd, 0, "8BPS", 4, 0, nullptr, 0 },
+    { R::FamilyJp2, 0, "\x00\x00\x00\x0cjP  \x0d\x0a\x87\x0a", 12, 0, nullptr, 0 },
+    { R::FamilyJ2k, 0, "\xff\x4f\xff\x51", 4, 0, nullptr, 0 },
+    { R::FamilyHdr, 0, "#?RADIANCE", 10, 0, nullptr, 0 },
+    { R::FamilyDds, 0, "DDS", 3, 0, nullptr, 0 },
+    { R::FamilyXpm, 0, "/* XPM */", 9, 0, nullptr, 0 },
+    { R::FamilyPbm, 0, "P1", 2, 0, nullptr, 0 },
+    { R::FamilyPbm, 0, "P4", 2, 0, nullptr, 0 },
+    { R::FamilyPgm, 0, "P2", 2, 0, nullptr, 0 },
+    { R::FamilyPgm, 0, "P5", 2, 0, nullptr, 0 },
+    { R::FamilyPpm, 0, "P3", 2, 0, nullptr, 0 },
+    { R::FamilyPpm, 0, "P6", 2, 0, nullptr, 0 },
+    { R::FamilySvg, -1, "<svg", 4, 0, nullptr, 0 },
+};
+
+bool matchBytes(const char *data, int size, int offset, const char *bytes, int length)
+{
+    if (-1 == offset) {
+        for (int i = 0; i + length <= size; ++i) {
+            if (0 == std::memcmp(data + i, bytes, static_cast<size_t>(length))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    return offset + length <= size && 0 == std::memcmp(data + offset, bytes, static_cast<size_t>(length));
+}
+
+/**
+   @return 返回名称为 \a data 的格式，大小写不敏感，不分配内存
+ */
+const R::Format *lookup(const QChar *data, int size)
+{
+    if (size <= 0 || size > s_maxNameLength) {
+        return nullptr;
+    }
+
+    quint32 hash = 2166136261u ^ s_hashSeed;
+    for (int i = 0; i < size; ++i) {
+        const ushort ch = data[i].unicode();
+        if (ch > 0x7f) {
+            return nullptr;
+        }
+        hash = hashStep(hash, static_cast<char>(ch));
+    }
+
+    const int index = s_slotTable.slots[hashFinish(hash)];
+    if (index < 0) {
+        return nullptr;
+    }
+
+    const R::Format &format = s_formats[index];
+    for (int i = 0; i < size; ++i) {
+        if (asciiUpper(static_cast<char>(data[i].unicode())) != format.name[i]) {
+            return nullptr;
+        }
+    }
+    return ('\0' == format.name[size]) ? &format : nullptr;
+}
+
+}  // namespace
+
+/**
+   @class ImageFormatRegistry
+   @brief 图片格式注册表，统一管理支持的格式及各格式支持的操作(读取、保存、旋转、壁纸等)，
+        并提供基于文件头特征的格式识别。
+   @note 注册表在编译期构造，按名称查找使用无冲突的哈希表，不分配内存；
+        识别文件内容仅读取一次文件头，不依赖 QMimeDatabase 。
+ */
+
+/**
+   @return 返回名称(后缀)为 \a name 的格式，大小写不敏感，未注册时返回 nullptr
+ */
+const ImageFormatRegistry::Format *ImageFormatRegistry::find(const QString &name)
+{
+    return lookup(name.constData(), name.size());
+}
+
+/**
+   @return 返回文件路径 \a path 后缀对应的格式，未注册时返回 nullptr
+ */
+const ImageFormatRegistry::Format *ImageFormatRegistry::findForPath(const QString &path)
+{
+    const QChar *data = path.constData();
+    for (int i = path.size() - 1; i >= 0; --i) {
+        if ('.' == data[i]) {
+            return lookup(data + i + 1, path.size() - i - 1);
+        }
+        if ('/' == data[i]) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+/**
+   @return 返回格式族 \a family 的默认格式，识别文件内容时使用
+ */
+const ImageFormatRegistry::Format *ImageFormatRegistry::formatForFamily(int family)
+{
+    if (FamilyNone == family) {
+        return nullptr;
+    }
+
+    for (const Format &format : s_formats) {
+        if (family == format.family) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+/**
+   @return 根据文件后缀及文件内容识别 \a path 的格式，后缀与文件内容一致时优先使用后缀对应的格式，
+        不一致(如修改了后缀)时使用文件内容对应的格式，均无法识别时返回 nullptr
+ */
+const ImageFormatRegistry::Format *ImageFormatRegistry::detect(const QString &path)
+{
+    const Format *suffixFormat = findForPath(path);
+    const int family = sniffFile(path);
+    if (suffixFormat) {
+        // RAW 等基于 TIFF 容器的格式以后缀为准
+        if (FamilyNone == family || family == suffixFormat->family
+            || (FamilyNone == suffixFormat->family && FamilyTiff == family)) {
+            return suffixFormat;
+        }
+    }
+
+    const Format *contentFormat = formatForFamily(family);
+    return contentFormat ? contentFormat : suffixFormat;
+}
+
+/**
+   @return 返回文件头数据 \a header 对应的格式族，无法识别时返回 FamilyNone
+ */
+int ImageFormatRegistry::sniff(const QByteArray &header)
+{
+    const char *data = header.constData();
+    const int size = header.size();
+    for (const Magic &magic : s_magics) {
+        if (matchBytes(data, size, magic.offset, magic.bytes, magic.length)
+            && (!magic.bytes2 || matchBytes(data, size, magic.offset2, magic.bytes2, magic.length2))) {
+            return magic.family;
+        }
+    }
+    return FamilyNone;
+}
+
+/**
+   @return 读取文件 \a path 的文件头并返回对应的格式族，无法读取或识别时返回 FamilyNone
+ */
+int ImageFormatRegistry::sniffFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(logImageViewer) << "Failed to open file for format detection:" << path;
+        return FamilyNone;
+    }
+
+    return sniff(file.read(s_headerSize));
+}
+
+/**
+   @return 返回名称(后缀)为 \a name 的格式是否支持操作 \a cap
+ */
+bool ImageFormatRegistry::hasCapability(const QString &name, Capability cap)
+{
+    const Format *format = find(name);
+    return format && format->has(cap);
+}
+
+/**
+   @return 返回支持操作 \a cap 的格式名称列表
+ */
+QStringList ImageFormatRegistry::formatNames(Capability cap)
+{
+    QStringList names;
+    for (const Format &format : s_formats) {
+        if (format.has(cap)) {
+            names.append(format.formatName());
+        }
+    }
+    return names;
+}
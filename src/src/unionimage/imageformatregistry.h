@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEFORMATREGISTRY_H
+#define IMAGEFORMATREGISTRY_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+class ImageFormatRegistry
+{
+public:
+    // 图片格式支持的操作
+    enum Capability : quint16 {
+        Read = 0x01,        ///< 支持读取(看图支持的格式)
+        Save = 0x02,        ///< 支持保存
+        Rotate = 0x04,      ///< 支持旋转后写回文件
+        WallPaper = 0x08,   ///< 支持设置为壁纸
+        Animated = 0x10,    ///< 可能为动图
+        MultiPage = 0x20,   ///< 可能为多页图
+        ContentCheck = 0x40,   ///< 后缀不足以确定为图片(矢量、元文件等)，需由图片插件校验文件内容
+    };
+
+    // 文件内容(文件头)对应的格式族，同一格式族的不同后缀文件内容一致
+    enum Family : quint8 {
+        FamilyNone = 0,
+        FamilyBmp,
+        FamilyJpeg,
+        FamilyPng,
+        FamilyGif,
+        FamilyTiff,
+        FamilyWebp,
+        FamilyMng,
+        FamilyIcns,
+        FamilyIco,
+        FamilyPbm,
+        FamilyPgm,
+        FamilyPpm,
+        FamilySvg,
+        FamilyXpm,
+        FamilyDds,
+        FamilyPsd,
+        FamilyHeif,
+        FamilyAvif,
+        FamilyJp2,
+        FamilyJ2k,
+        FamilyHdr,
+    };
+
+    struct Format
+    {
+        const char *name;   ///< 格式名称(大写后缀)
+        quint16 caps;       ///< 支持的操作 Capability
+        quint8 family;      ///< 文件内容格式族 Family ，FamilyNone 表示无固定文件头或基于其它容器(如 RAW)
+
+        inline bool has(Capability cap) const { return caps & cap; }
+        // 仅通过后缀即可确定为可读取的图片，无需校验文件内容
+        inline bool readableBySuffix() const { return has(Read) && !has(ContentCheck); }
+        inline QString formatName() const { return QString::fromLatin1(name); }
+    };
+
+    static const Format *find(const QString &name);
+    static const Format *findForPath(const QString &path);
+    static const Format *formatForFamily(int family);
+    static const Format *detect(const QString &path);
+    static int sniff(const QByteArray &header);
+    static int sniffFile(const QString &path);
+
+    static bool hasCapability(const QString &name, Capability cap);
+    static QStringList formatNames(Capability cap);
+};
+
+#endif  // IMAGEFORMATREGISTRY_H
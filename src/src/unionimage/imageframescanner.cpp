@@ -0,0 +1,402 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imageframescanner.h"
+#include "imageformatregistry.h"
+
+#include <QFile>
+#include <QSet>
+#include <QtEndian>
+#include <QLoggingCategory>
+
+#include <climits>
+#include <cstring>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+namespace {
+
+const int s_maxFrames = 65535;   // 帧数上限，超过时视为异常文件，交由 QImageReader 处理
+
+const quint16 s_tiffNewSubfileType = 254;
+const quint16 s_tiffSubfileType = 255;
+const quint16 s_tiffImageWidth = 256;
+const quint16 s_tiffImageLength = 257;
+const quint16 s_tiffTypeShort = 3;
+const quint16 s_tiffTypeLong = 4;
+const quint32 s_tiffReducedImage = 0x1;       // NewSubfileType 第 0 位，缩小分辨率的预览图或缩略图
+const quint32 s_tiffSubfileReduced = 2;       // 旧版 SubfileType 中的缩小分辨率图像
+
+/**
+   @brief 读取 \a len 字节至 \a buffer ，数据不足时返回 false
+ */
+bool readExact(QIODevice *device, char *buffer, qint64 len)
+{
+    return device->read(buffer, len) == len;
+}
+
+/**
+   @brief 跳过 \a len 字节，数据不足时返回 false
+ */
+bool skipExact(QIODevice *device, qint64 len)
+{
+    return device->skip(len) == len;
+}
+
+quint32 readUInt24LE(const uchar *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16);
+}
+
+}  // namespace
+
+/**
+   @class ImageFrameScanner
+   @brief 仅读取文件容器结构统计图片帧数及各帧大小，不解码图像数据。
+        用于替代 QImageReader::imageCount() ，后者对部分格式需完整解码所有帧。
+   @note 支持 TIFF (IFD 链)、GIF (数据块) 及 WebP (ANIM/ANMF 块)，其它格式返回 false ，
+        由调用方回退至 QImageReader 。统计的帧索引与 QImageReader::jumpToImage() 一致。
+ */
+
+/**
+   @return 格式族 \a family 是否支持结构扫描
+ */
+bool ImageFrameScanner::canScan(int family)
+{
+    return ImageFormatRegistry::FamilyTiff == family || ImageFormatRegistry::FamilyGif == family
+           || ImageFormatRegistry::FamilyWebp == family;
+}
+
+/**
+   @return 文件 \a path 的后缀是否与文件内容的格式族 \a family 一致，不一致时不按容器结构统计帧数
+   @note 基于 TIFF 容器的 RAW 格式(CR2 、NEF 、DNG 等)包含预览图及缩略图 IFD ，以后缀为准视为单帧；
+        后缀未注册或为 TIFF 后缀(可能为多页图)时按文件内容扫描
+ */
+bool ImageFrameScanner::matchesSuffix(const QString &path, int family)
+{
+    const ImageFormatRegistry::Format *suffixFormat = ImageFormatRegistry::findForPath(path);
+    return !suffixFormat || family == suffixFormat->family || ImageFormatRegistry::FamilyTiff == suffixFormat->family;
+}
+
+/**
+   @brief 根据文件头识别 \a path 的格式并扫描帧信息 \a info ，后缀与文件内容不一致时返回 false
+ */
+bool ImageFrameScanner::scan(const QString &path, FrameInfo &info)
+{
+    const int family = ImageFormatRegistry::sniffFile(path);
+    return matchesSuffix(path, family) && scan(path, family, info);
+}
+
+/**
+   @brief 按格式族 \a family 扫描 \a path 的帧信息 \a info
+   @return 文件结构是否完整且可识别，失败时 \a info 内容无效
+ */
+bool ImageFrameScanner::scan(const QString &path, int family, FrameInfo &info)
+{
+    if (!canScan(family)) {
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    info = FrameInfo();
+    bool ret = false;
+    switch (family) {
+        case ImageFormatRegistry::FamilyTiff:
+            ret = scanTiff(&file, info);
+            break;
+        case ImageFormatRegistry::FamilyGif:
+            ret = scanGif(&file, info);
+            break;
+        case ImageFormatRegistry::FamilyWebp:
+            ret = scanWebp(&file, info);
+            break;
+        default:
+            break;
+    }
+
+    // 仅 TIFF 存在不计入帧数的缩小分辨率图像，其它格式的图像总数即为帧数
+    if (ImageFormatRegistry::FamilyTiff != family) {
+        info.imageCount = info.frameCount;
+    }
+    ret = ret && info.frameCount > 0 && info.frameSizes.size() == info.frameCount;
+    if (!ret) {
+        qCDebug(logImageViewer) << "Frame scan failed, fallback to image reader:" << path;
+        info = FrameInfo();
+    }
+    return ret;
+}
+
+/**
+   @brief 遍历 TIFF 文件的 IFD 链，每个 IFD 对应一帧，读取 ImageWidth/ImageLength 标签
+   @note 不支持 BigTIFF ，SubIFD 中的缩略图不计入帧数。缩小分辨率的 IFD (NewSubfileType 第 0 位)
+        为预览图或缩略图，不计入帧数但计入图像总数 imageCount ，保存时需保留这些 IFD ；
+        其后仍有完整图像时帧索引无法与 QImageReader 对应，返回 false
+ */
+bool ImageFrameScanner::scanTiff(QIODevice *device, FrameInfo &info)
+{
+    uchar header[8];
+    if (!readExact(device, reinterpret_cast<char *>(header), sizeof(header))) {
+        return false;
+    }
+
+    bool little = ('I' == header[0] && 'I' == header[1]);
+    if (!little && !('M' == header[0] && 'M' == header[1])) {
+        return false;
+    }
+
+    auto read16 = [little](const uchar *data) -> quint16 {
+        return little ? qFromLittleEndian<quint16>(data) : qFromBigEndian<quint16>(data);
+    };
+    auto read32 = [little](const uchar *data) -> quint32 {
+        return little ? qFromLittleEndian<quint32>(data) : qFromBigEndian<quint32>(data);
+    };
+
+    if (42 != read16(header + 2)) {
+        return false;
+    }
+
+    QSet<quint32> visited;
+    QByteArray entries;
+    bool hasReduced = false;   // 已遇到缩小分辨率的 IFD
+    quint32 offset = read32(header + 4);
+    while (0 != offset) {
+        // 损坏的文件可能出现 IFD 循环引用
+        if (visited.contains(offset) || info.frameCount >= s_maxFrames) {
+            return false;
+        }
+        visited.insert(offset);
+
+        uchar countData[2];
+        if (!device->seek(offset) || !readExact(device, reinterpret_cast<char *>(countData), sizeof(countData))) {
+            return false;
+        }
+
+        // 12 字节的目录项及 4 字节的下一 IFD 偏移
+        const int count = read16(countData);
+        entries.resize(count * 12 + 4);
+        if (!readExact(device, entries.data(), entries.size())) {
+            return false;
+        }
+
+        const uchar *data = reinterpret_cast<const uchar *>(entries.constData());
+        QSize size;
+        bool reduced = false;
+        for (int i = 0; i < count; ++i) {
+            const uchar *entry = data + i * 12;
+            const quint16 tag = read16(entry);
+            if (s_tiffImageWidth != tag && s_tiffImageLength != tag && s_tiffNewSubfileType != tag && s_tiffSubfileType != tag) {
+                continue;
+            }
+
+            const quint16 type = read16(entry + 2);
+            quint32 value = 0;
+            if (s_tiffTypeShort == type) {
+                value = read16(entry + 8);
+            } else if (s_tiffTypeLong == type) {
+                value = read32(entry + 8);
+            } else {
+                return false;
+            }
+
+            if (s_tiffNewSubfileType == tag) {
+                reduced = reduced || (0 != (value & s_tiffReducedImage));
+            } else if (s_tiffSubfileType == tag) {
+                reduced = reduced || (s_tiffSubfileReduced == value);
+            } else if (s_tiffImageWidth == tag) {
+                size.setWidth(static_cast<int>(qMin<quint32>(value, INT_MAX)));
+            } else {
+                size.setHeight(static_cast<int>(qMin<quint32>(value, INT_MAX)));
+            }
+        }
+
+        if (size.isEmpty()) {
+            return false;
+        }
+
+        info.imageCount++;
+        if (reduced) {
+            hasReduced = true;
+        } else if (hasReduced) {
+            return false;
+        } else {
+            info.frameSizes.append(size);
+            info.frameCount++;
+        }
+        offset = read32(data + count * 12);
+    }
+
+    return true;
+}
+
+/**
+   @brief 跳过 GIF 文件的扩展块及图像数据子块，统计图像描述符的数量
+   @note QImageReader 按逻辑屏幕大小合成各帧，因此各帧大小均为逻辑屏幕大小
+ */
+bool ImageFrameScanner::scanGif(QIODevice *device, FrameInfo &info)
+{
+    // 6 字节签名及 7 字节逻辑屏幕描述符
+    uchar header[13];
+    if (!readExact(device, reinterpret_cast<char *>(header), sizeof(header))) {
+        return false;
+    }
+
+    QSize screenSize(qFromLittleEndian<quint16>(header + 6), qFromLittleEndian<quint16>(header + 8));
+    if (header[10] & 0x80) {
+        if (!skipExact(device, 3 * (2 << (header[10] & 0x07)))) {
+            return false;
+        }
+    }
+
+    // 跳过以 0 长度结尾的数据子块序列
+    auto skipSubBlocks = [device]() -> bool {
+        char blockSize = 0;
+        while (device->getChar(&blockSize)) {
+            if (0 == blockSize) {
+                return true;
+            }
+            if (!skipExact(device, static_cast<uchar>(blockSize))) {
+                return false;
+            }
+        }
+        return false;
+    };
+
+    char introducer = 0;
+    while (device->getChar(&introducer)) {
+        switch (static_cast<uchar>(introducer)) {
+            case 0x21: {
+                // 扩展块：标签 + 数据子块
+                if (!skipExact(device, 1) || !skipSubBlocks()) {
+                    return false;
+                }
+                break;
+            }
+            case 0x2C: {
+                // 图像描述符：位置、大小、标志 + 局部颜色表 + LZW 最小码长 + 数据子块
+                uchar descriptor[9];
+                if (!readExact(device, reinterpret_cast<char *>(descriptor), sizeof(descriptor))) {
+                    return false;
+                }
+                if (descriptor[8] & 0x80) {
+                    if (!skipExact(device, 3 * (2 << (descriptor[8] & 0x07)))) {
+                        return false;
+                    }
+                }
+                if (!skipExact(device, 1) || !skipSubBlocks()) {
+                    return false;
+                }
+
+                if (screenSize.isEmpty()) {
+                    screenSize = QSize(qFromLittleEndian<quint16>(descriptor + 4), qFromLittleEndian<quint16>(descriptor + 6));
+                }
+                info.frameCount++;
+                if (info.frameCount > s_maxFrames) {
+                    return false;
+                }
+                break;
+            }
+            case 0x3B:
+                // 结束标志
+                info.frameSizes.fill(screenSize, info.frameCount);
+                return !screenSize.isEmpty();
+            default:
+                return false;
+        }
+    }
+
+    // 缺少结束标志的文件，QImageReader 同样可读取已完整的帧
+    info.frameSizes.fill(screenSize, info.frameCount);
+    return !screenSize.isEmpty();
+}
+
+/**
+   @brief 遍历 WebP 文件的 RIFF 块，动图统计 ANMF 块数量，静态图读取 VP8/VP8L 位流头中的大小
+   @note QImageReader 按画布大小合成动图各帧，因此各帧大小均为 VP8X 中的画布大小
+ */
+bool ImageFrameScanner::scanWebp(QIODevice *device, FrameInfo &info)
+{
+    uchar header[12];
+    if (!readExact(device, reinterpret_cast<char *>(header), sizeof(header)) || 0 != memcmp(header, "RIFF", 4)
+        || 0 != memcmp(header + 8, "WEBP", 4)) {
+        return false;
+    }
+
+    QSize canvasSize;
+    QSize bitstreamSize;
+    int animFrames = 0;
+    uchar chunk[8];
+    while (readExact(device, reinterpret_cast<char *>(chunk), sizeof(chunk))) {
+        const quint32 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+        // 块数据按偶数字节对齐
+        const qint64 paddedSize = static_cast<qint64>(chunkSize) + (chunkSize & 1);
+
+        if (0 == memcmp(chunk, "VP8X", 4) && chunkSize >= 10) {
+            uchar data[10];
+            if (!readExact(device, reinterpret_cast<char *>(data), sizeof(data))) {
+                return false;
+            }
+            canvasSize = QSize(static_cast<int>(readUInt24LE(data + 4)) + 1, static_cast<int>(readUInt24LE(data + 7)) + 1);
+            if (!skipExact(device, paddedSize - 10)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (0 == memcmp(chunk, "VP8 ", 4) && chunkSize >= 10 && bitstreamSize.isEmpty()) {
+            // 3 字节帧标记 + 起始码 9D 01 2A + 14 位宽高
+            uchar data[10];
+            if (!readExact(device, reinterpret_cast<char *>(data), sizeof(data))) {
+                return false;
+            }
+            if (0x9D != data[3] || 0x01 != data[4] || 0x2A != data[5]) {
+                return false;
+            }
+            bitstreamSize = QSize(qFromLittleEndian<quint16>(data + 6) & 0x3FFF, qFromLittleEndian<quint16>(data + 8) & 0x3FFF);
+            if (!skipExact(device, paddedSize - 10)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (0 == memcmp(chunk, "VP8L", 4) && chunkSize >= 5 && bitstreamSize.isEmpty()) {
+            // 签名 0x2F + 14 位宽度减一 + 14 位高度减一
+            uchar data[5];
+            if (!readExact(device, reinterpret_cast<char *>(data), sizeof(data)) || 0x2F != data[0]) {
+                return false;
+            }
+            const quint32 bits = qFromLittleEndian<quint32>(data + 1);
+            bitstreamSize = QSize(static_cast<int>(bits & 0x3FFF) + 1, static_cast<int>((bits >> 14) & 0x3FFF) + 1);
+            if (!skipExact(device, paddedSize - 5)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (0 == memcmp(chunk, "ANMF", 4)) {
+            animFrames++;
+            if (animFrames > s_maxFrames) {
+                return false;
+            }
+        }
+
+        if (!skipExact(device, paddedSize)) {
+            break;
+        }
+    }
+
+    if (animFrames > 0) {
+        info.frameCount = animFrames;
+        info.frameSizes.fill(canvasSize, animFrames);
+        return !canvasSize.isEmpty();
+    }
+
+    const QSize size = canvasSize.isEmpty() ? bitstreamSize : canvasSize;
+    info.frameCount = 1;
+    info.frameSizes.fill(size, 1);
+    return !size.isEmpty();
+}
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEFRAMESCANNER_H
+#define IMAGEFRAMESCANNER_H
+
+#include <QString>
+#include <QSize>
+#include <QVector>
+
+class QIODevice;
+
+class ImageFrameScanner
+{
+public:
+    /**
+       @brief 图片帧信息
+     */
+    struct FrameInfo
+    {
+        int frameCount = 0;          ///< 总帧数
+        QVector<QSize> frameSizes;   ///< 各帧图像大小，与 QImageReader 读取的帧索引一致
+        int imageCount = 0;          ///< 容器中的图像总数，与 QImageReader::imageCount() 一致，TIFF 含缩小分辨率的 IFD
+    };
+
+    static bool canScan(int family);
+    static bool matchesSuffix(const QString &path, int family);
+    static bool scan(const QString &path, FrameInfo &info);
+    static bool scan(const QString &path, int family, FrameInfo &info);
+
+private:
+    static bool scanTiff(QIODevice *device, FrameInfo &info);
+    static bool scanGif(QIODevice *device, FrameInfo &info);
+    static bool scanWebp(QIODevice *device, FrameInfo &info);
+};
+
+#endif  // IMAGEFRAMESCANNER_H
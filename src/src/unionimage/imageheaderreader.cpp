@@ -0,0 +1,344 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imageheaderreader.h"
+#include "imageformatregistry.h"
+#include "imageframescanner.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QFile>
+#include <QImageReader>
+#include <QtEndian>
+#include <QLoggingCategory>
+
+#include <climits>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+namespace {
+
+const int s_maxExifSize = 64 * 1024;   // APP1 段长度上限
+const int s_maxIfdEntries = 1024;      // IFD 目录项数上限，超过时视为异常文件
+
+const quint16 s_tiffImageWidth = 256;
+const quint16 s_tiffImageLength = 257;
+const quint16 s_tiffNewSubfileType = 254;
+const quint16 s_tiffSubfileType = 255;
+const quint16 s_tiffDateTime = 0x0132;
+const quint16 s_tiffExifIfd = 0x8769;
+const quint16 s_exifDateTimeOriginal = 0x9003;
+const quint16 s_tiffTypeAscii = 2;
+const quint16 s_tiffTypeShort = 3;
+const quint16 s_tiffTypeLong = 4;
+const quint32 s_tiffReducedImage = 0x1;   // NewSubfileType 第 0 位，缩小分辨率的预览图或缩略图
+const quint32 s_tiffSubfileReduced = 2;   // 旧版 SubfileType 中的缩小分辨率图像
+
+/**
+   @brief 读取 \a len 字节至 \a buffer ，数据不足时返回 false
+ */
+bool readExact(QIODevice *device, char *buffer, qint64 len)
+{
+    return device->read(buffer, len) == len;
+}
+
+/**
+   @brief 跳过 \a len 字节，数据不足时返回 false
+ */
+bool skipExact(QIODevice *device, qint64 len)
+{
+    return device->skip(len) == len;
+}
+
+/**
+   @return 返回 EXIF 日期 "YYYY:MM:DD HH:MM:SS" (本地时间) 对应的时间(ms)，无法解析时返回 0
+ */
+qint64 parseExifDateTime(const QByteArray &text)
+{
+    const QDateTime time = QDateTime::fromString(QString::fromLatin1(text.left(19)), "yyyy:MM:dd HH:mm:ss");
+    return time.isValid() ? time.toMSecsSinceEpoch() : 0;
+}
+
+}  // namespace
+
+/**
+   @class ImageHeaderReader
+   @brief 仅读取文件头获取图片的拍摄时间及大小，不解码图像数据，用于按拍摄时间、像素数排序。
+   @note JPEG 读取 APP1 段中的 EXIF 及 SOF 段，TIFF (含基于 TIFF 的 RAW 格式)读取 IFD0 及 EXIF IFD ，
+        其它格式仅由 QImageReader 读取文件头中的大小。无 DateTimeOriginal 时使用 DateTime 标签。
+        RAW 格式及 IFD0 为预览图时仅读取拍摄时间，大小由 QImageReader 读取。
+   @threadsafe
+ */
+
+/**
+   @brief 根据文件头识别 \a path 的格式并读取图片信息 \a info
+ */
+bool ImageHeaderReader::read(const QString &path, HeaderInfo &info)
+{
+    return read(path, ImageFormatRegistry::sniffFile(path), info);
+}
+
+/**
+   @brief 按格式族 \a family 读取 \a path 的图片信息 \a info
+   @return 是否读取到拍摄时间或图片大小
+ */
+bool ImageHeaderReader::read(const QString &path, int family, HeaderInfo &info)
+{
+    info = HeaderInfo();
+
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        switch (family) {
+            case ImageFormatRegistry::FamilyJpeg:
+                readJpeg(&file, info);
+                break;
+            case ImageFormatRegistry::FamilyTiff:
+                // 基于 TIFF 的 RAW 格式(CR2 、NEF 、DNG 等)的 IFD0 通常为内嵌预览图，由图片插件读取实际大小
+                readTiff(&file, info, ImageFrameScanner::matchesSuffix(path, family));
+                break;
+            default:
+                break;
+        }
+    }
+
+    // 其它格式或结构无法识别时，由图片插件读取文件头中的大小
+    if (info.size.isEmpty()) {
+        QImageReader reader(path);
+        info.size = reader.size();
+    }
+
+    if (info.size.isEmpty() && 0 == info.captureTime) {
+        qCDebug(logImageViewer) << "Read image header failed:" << path;
+        return false;
+    }
+    return true;
+}
+
+/**
+   @brief 仅读取 \a path 的 EXIF 拍摄时间，不读取图片大小，用于探测图片信息后记录至持久化索引
+   @return 返回拍摄时间(ms)，无拍摄时间或非 JPEG 、 TIFF 格式时返回 0
+ */
+qint64 ImageHeaderReader::readCaptureTime(const QString &path)
+{
+    const int family = ImageFormatRegistry::sniffFile(path);
+    if (ImageFormatRegistry::FamilyJpeg != family && ImageFormatRegistry::FamilyTiff != family) {
+        return 0;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    HeaderInfo info;
+    if (ImageFormatRegistry::FamilyJpeg == family) {
+        readJpeg(&file, info);
+    } else {
+        readTiff(&file, info, false);
+    }
+    return info.captureTime;
+}
+
+/**
+   @brief 遍历 JPEG 文件的标记段直至图像数据，读取 APP1 段中的 EXIF 及 SOF 段中的图像大小
+ */
+bool ImageHeaderReader::readJpeg(QIODevice *device, HeaderInfo &info)
+{
+    uchar soi[2];
+    if (!readExact(device, reinterpret_cast<char *>(soi), sizeof(soi)) || 0xFF != soi[0] || 0xD8 != soi[1]) {
+        return false;
+    }
+
+    bool exifRead = false;
+    char marker[2];
+    while (readExact(device, marker, sizeof(marker))) {
+        if (0xFF != static_cast<uchar>(marker[0])) {
+            return false;
+        }
+        // 标记前可能存在填充字节 0xFF
+        while (0xFF == static_cast<uchar>(marker[1])) {
+            if (!device->getChar(&marker[1])) {
+                return false;
+            }
+        }
+
+        const uchar code = static_cast<uchar>(marker[1]);
+        if (0x01 == code || (code >= 0xD0 && code <= 0xD8)) {
+            // 无长度字段的标记
+            continue;
+        }
+        if (0xD9 == code || 0xDA == code) {
+            // 图像数据开始，之后不再有 EXIF 及 SOF 段
+            break;
+        }
+
+        uchar lengthData[2];
+        if (!readExact(device, reinterpret_cast<char *>(lengthData), sizeof(lengthData))) {
+            return false;
+        }
+        const int length = qFromBigEndian<quint16>(lengthData);
+        if (length < 2) {
+            return false;
+        }
+        const int payload = length - 2;
+
+        if (0xE1 == code && !exifRead && payload > 6 && payload <= s_maxExifSize) {
+            QByteArray data(payload, '\0');
+            if (!readExact(device, data.data(), payload)) {
+                return false;
+            }
+            if (data.startsWith(QByteArray("Exif\0\0", 6))) {
+                // EXIF 数据为 TIFF 结构，偏移量相对于 TIFF 文件头
+                exifRead = true;
+                QBuffer buffer;
+                buffer.setData(data.mid(6));
+                buffer.open(QIODevice::ReadOnly);
+                readTiff(&buffer, info, false);
+            }
+            continue;
+        }
+
+        // SOF0 ~ SOF15 ，排除 DHT(C4)、JPG(C8)、DAC(CC)
+        if (code >= 0xC0 && code <= 0xCF && 0xC4 != code && 0xC8 != code && 0xCC != code && payload >= 5) {
+            uchar frame[5];
+            if (!readExact(device, reinterpret_cast<char *>(frame), sizeof(frame))) {
+                return false;
+            }
+            info.size = QSize(qFromBigEndian<quint16>(frame + 3), qFromBigEndian<quint16>(frame + 1));
+            // EXIF 位于 SOF 之前，无需继续遍历
+            break;
+        }
+
+        if (!skipExact(device, payload)) {
+            return false;
+        }
+    }
+
+    return !info.size.isEmpty();
+}
+
+/**
+   @brief 读取 TIFF 结构的 IFD0 及 EXIF IFD ，获取拍摄时间， \a readSize 为 true 时同时读取 IFD0 中的图像大小
+   @note 不支持 BigTIFF 。IFD0 为缩小分辨率的图像(NewSubfileType 第 0 位)时不读取大小，由图片插件读取
+ */
+bool ImageHeaderReader::readTiff(QIODevice *device, HeaderInfo &info, bool readSize)
+{
+    uchar header[8];
+    if (!readExact(device, reinterpret_cast<char *>(header), sizeof(header))) {
+        return false;
+    }
+
+    bool little = ('I' == header[0] && 'I' == header[1]);
+    if (!little && !('M' == header[0] && 'M' == header[1])) {
+        return false;
+    }
+
+    auto read16 = [little](const uchar *data) -> quint16 {
+        return little ? qFromLittleEndian<quint16>(data) : qFromBigEndian<quint16>(data);
+    };
+    auto read32 = [little](const uchar *data) -> quint32 {
+        return little ? qFromLittleEndian<quint32>(data) : qFromBigEndian<quint32>(data);
+    };
+
+    if (42 != read16(header + 2)) {
+        return false;
+    }
+
+    // 读取偏移 offset 处的 IFD 目录项(12 字节)，返回目录项数，失败时返回 -1
+    auto readIfd = [&](quint32 offset, QByteArray &entries) -> int {
+        uchar countData[2];
+        if (!device->seek(offset) || !readExact(device, reinterpret_cast<char *>(countData), sizeof(countData))) {
+            return -1;
+        }
+        const int count = read16(countData);
+        if (count > s_maxIfdEntries) {
+            return -1;
+        }
+        entries.resize(count * 12);
+        return readExact(device, entries.data(), entries.size()) ? count : -1;
+    };
+
+    // 读取日期标签，日期固定为 20 字节(含结尾 0)，存储在偏移处
+    auto readDate = [&](const uchar *entry) -> qint64 {
+        const quint32 count = read32(entry + 4);
+        if (s_tiffTypeAscii != read16(entry + 2) || count < 19 || count > 64) {
+            return 0;
+        }
+        QByteArray text(static_cast<int>(count), '\0');
+        if (!device->seek(read32(entry + 8)) || !readExact(device, text.data(), count)) {
+            return 0;
+        }
+        return parseExifDateTime(text);
+    };
+
+    auto readInt = [&](const uchar *entry) -> int {
+        const quint16 type = read16(entry + 2);
+        if (s_tiffTypeShort == type) {
+            return read16(entry + 8);
+        } else if (s_tiffTypeLong == type) {
+            return static_cast<int>(qMin<quint32>(read32(entry + 8), INT_MAX));
+        }
+        return 0;
+    };
+
+    QByteArray entries;
+    int count = readIfd(read32(header + 4), entries);
+    if (count < 0) {
+        return false;
+    }
+
+    QSize size;
+    bool reduced = false;
+    qint64 dateTime = 0;
+    quint32 exifOffset = 0;
+    for (int i = 0; i < count; ++i) {
+        const uchar *entry = reinterpret_cast<const uchar *>(entries.constData()) + i * 12;
+        switch (read16(entry)) {
+            case s_tiffImageWidth:
+                size.setWidth(readInt(entry));
+                break;
+            case s_tiffImageLength:
+                size.setHeight(readInt(entry));
+                break;
+            case s_tiffNewSubfileType:
+                reduced = reduced || (0 != (static_cast<quint32>(readInt(entry)) & s_tiffReducedImage));
+                break;
+            case s_tiffSubfileType:
+                reduced = reduced || (s_tiffSubfileReduced == static_cast<quint32>(readInt(entry)));
+                break;
+            case s_tiffDateTime:
+                dateTime = readDate(entry);
+                break;
+            case s_tiffExifIfd:
+                exifOffset = read32(entry + 8);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (0 != exifOffset) {
+        count = readIfd(exifOffset, entries);
+        for (int i = 0; i < count; ++i) {
+            const uchar *entry = reinterpret_cast<const uchar *>(entries.constData()) + i * 12;
+            if (s_exifDateTimeOriginal == read16(entry)) {
+                info.captureTime = readDate(entry);
+                break;
+            }
+        }
+    }
+
+    // 无原始拍摄时间时使用文件修改时间标签
+    if (0 == info.captureTime) {
+        info.captureTime = dateTime;
+    }
+    if (readSize && !reduced && !size.isEmpty()) {
+        info.size = size;
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGEHEADERREADER_H
+#define IMAGEHEADERREADER_H
+
+#include <QString>
+#include <QSize>
+
+class QIODevice;
+
+class ImageHeaderReader
+{
+public:
+    /**
+       @brief 文件头中读取的图片信息
+     */
+    struct HeaderInfo
+    {
+        qint64 captureTime = 0;  ///< EXIF 拍摄时间(ms)，0 表示无拍摄时间
+        QSize size;              ///< 图片大小，读取失败时为空
+    };
+
+    static bool read(const QString &path, HeaderInfo &info);
+    static bool read(const QString &path, int family, HeaderInfo &info);
+    static qint64 readCaptureTime(const QString &path);
+
+private:
+    static bool readJpeg(QIODevice *device, HeaderInfo &info);
+    static bool readTiff(QIODevice *device, HeaderInfo &info, bool readSize);
+};
+
+#endif  // IMAGEHEADERREADER_H
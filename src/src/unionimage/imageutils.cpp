@@ -5,6 +5,7 @@
 #include "baseutils.h"
 #include "imageutils.h"
 #include "unionimage.h"
+#include "imageformatregistry.h"
 #include <fstream>
 
 #include <QBuffer>
@@ -20,9 +21,11 @@
 #include <QPixmapCache>
 #include <QProcess>
 #include <QReadWriteLock>
+#include <QSaveFile>
 #include <QUrl>
 #include <QApplication>
 #include <QLoggingCategory>
+#include <QtConcurrent/QtConcurrent>
 
 Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
 
@@ -429,37 +432,30 @@ QMap<QString, QString> thumbnailAttribute(const QUrl &url)
 
 const QString thumbnailCachePath()
 {
-    qCDebug(logImageViewer) << "Determining thumbnail cache path.";
-    QString cacheP;
-
-    QStringList systemEnvs = QProcess::systemEnvironment();
-    for (QString it : systemEnvs) {
-        QStringList el = it.split("=");
-        if (el.length() == 2 && el.first() == "XDG_CACHE_HOME") {
-            cacheP = el.last();
-            qCDebug(logImageViewer) << "XDG_CACHE_HOME environment variable found:" << cacheP;
-            break;
-        }
-    }
-    cacheP = cacheP.isEmpty() ? (QDir::homePath() + "/.cache") : cacheP;
-    qCDebug(logImageViewer) << "Base cache path:" << cacheP;
-
-    // Check specific size dir
-    const QString thumbCacheP = cacheP + "/thumbnails";
-    qCDebug(logImageViewer) << "Thumbnail cache base path:" << thumbCacheP;
-    QDir().mkpath(thumbCacheP + "/normal");
-    QDir().mkpath(thumbCacheP + "/large");
-    QDir().mkpath(thumbCacheP + "/fail");
-    qCDebug(logImageViewer) << "Created thumbnail subdirectories: normal, large, fail.";
-
-    return thumbCacheP;
+    // 缓存路径在运行期间不会变化，仅首次调用时查询环境变量并创建目录
+    static const QString s_thumbCachePath = []() {
+        qCDebug(logImageViewer) << "Determining thumbnail cache path.";
+        QString cacheP = qEnvironmentVariable("XDG_CACHE_HOME");
+        cacheP = cacheP.isEmpty() ? (QDir::homePath() + "/.cache") : cacheP;
+        qCDebug(logImageViewer) << "Base cache path:" << cacheP;
+
+        // Check specific size dir
+        const QString thumbCacheP = cacheP + "/thumbnails";
+        qCDebug(logImageViewer) << "Thumbnail cache base path:" << thumbCacheP;
+        QDir().mkpath(thumbCacheP + "/normal");
+        QDir().mkpath(thumbCacheP + "/large");
+        QDir().mkpath(thumbCacheP + "/fail");
+        qCDebug(logImageViewer) << "Created thumbnail subdirectories: normal, large, fail.";
+        return thumbCacheP;
+    }();
+
+    return s_thumbCachePath;
 }
 
-QMutex mutex;
 const QPixmap getThumbnail(const QString &path, bool cacheOnly)
 {
     qCDebug(logImageViewer) << "Attempting to get thumbnail for:" << path << ", cacheOnly:" << cacheOnly;
-    QMutexLocker locker(&mutex);
+    // 缩略图文件通过 QSaveFile 原子写入，读写无需全局锁，不同文件的缩略图可并行生成
     // 优先读取自身缓存的图片
     //    if (dApp->m_imagemap.value(path).isNull()) {
     //        return dApp->m_imagemap.value(path);
@@ -491,6 +487,190 @@ const QPixmap getThumbnail(const QString &path, bool cacheOnly)
     }
 }
 
+/**
+   @brief 将缩略图 \a image 以 PNG 格式原子写入 \a filePath ，先写入临时文件再重命名，
+        防止其它进程(如文件管理器)或并发的写入读取到不完整的文件
+ */
+static bool saveThumbnailFile(const QImage &image, const QString &filePath, int quality)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(logImageViewer) << "Failed to open thumbnail file for writing:" << filePath << file.errorString();
+        return false;
+    }
+
+    if (!image.save(&file, "png", quality)) {
+        qCWarning(logImageViewer) << "Failed to encode thumbnail:" << filePath;
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+/**
+   @return 图像文件 \a path 记录的方向(EXIF Orientation 等)是否交换宽高，
+        仅读取可能包含方向信息的格式的文件头，其它格式直接返回 false
+ */
+static bool isOrientationTransposed(const QString &path)
+{
+    static const QStringList s_orientedSuffixes { "jpg", "jpeg", "jpe", "tif", "tiff", "webp", "heic", "heif", "avif",
+                                                  "dng", "cr2", "nef", "arw", "orf", "pef", "raf", "rw2", "srw", "mrw" };
+    if (!s_orientedSuffixes.contains(QFileInfo(path).suffix().toLower())) {
+        return false;
+    }
+
+    QImageReader reader(path);
+    return reader.transformation() & QImageIOHandler::TransformationRotate90;
+}
+
+/**
+   @return 缩略图是否可写入 freedesktop 缩略图缓存，临时文件夹及可移动设备中的图片不写入，
+        避免为临时文件生成在其删除后仍残留的缩略图
+ */
+static bool isThumbnailCacheable(const QString &path)
+{
+    static const QStringList s_excludedPrefixes { QDir::tempPath() + "/", "/tmp/", "/var/tmp/", "/dev/shm/",
+                                                  "/media/", "/run/media/", "/mnt/" };
+    for (const QString &prefix : s_excludedPrefixes) {
+        if (path.startsWith(prefix)) {
+            return false;
+        }
+    }
+    return !path.startsWith(thumbnailCachePath());
+}
+
+/**
+   @brief 读取 \a path 在 freedesktop 缩略图缓存中 \a type 类型的缩略图，
+        仅当缩略图记录的 Thumb::URI 和 Thumb::MTime 与当前文件一致时有效，
+        可直接复用文件管理器等其它程序生成的缩略图。
+   @param sourceSize 传出缩略图记录的 Thumb::Image::Width/Height ，为未应用方向的原始图像大小
+   @return 有效的缩略图，不存在或已过期时返回空图像
+ */
+static QImage readCachedThumbnail(const QString &path, ThumbnailType type, QSize *sourceSize)
+{
+    const QString thumbPath = thumbnailPath(path, type);
+    QImageReader reader(thumbPath, "png");
+    if (!reader.canRead()) {
+        return QImage();
+    }
+
+    const QString mtime = reader.text("Thumb::MTime");
+    if (mtime.isEmpty() || mtime.toLongLong() != QFileInfo(path).lastModified().toSecsSinceEpoch()) {
+        qCDebug(logImageViewer) << "Cached thumbnail is outdated:" << thumbPath;
+        return QImage();
+    }
+
+    // Thumb::URI 可能为编码或未编码的形式，统一转换为 QUrl 比较
+    const QString uri = reader.text("Thumb::URI");
+    if (!uri.isEmpty() && QUrl(uri) != QUrl::fromLocalFile(path)) {
+        qCDebug(logImageViewer) << "Cached thumbnail URI mismatch:" << thumbPath << uri;
+        return QImage();
+    }
+
+    if (sourceSize) {
+        *sourceSize = QSize(reader.text("Thumb::Image::Width").toInt(), reader.text("Thumb::Image::Height").toInt());
+    }
+
+    QImage image = reader.read();
+    qCDebug(logImageViewer) << "Loaded cached thumbnail:" << thumbPath << "size:" << image.size();
+    return image;
+}
+
+/**
+   @brief 按 large 、 normal 的顺序读取 \a path 在 freedesktop 缩略图缓存中的有效缩略图
+   @param sourceSize 传出原始图像大小，缩略图未记录时读取图像文件头获取
+   @return 有效的缩略图，不存在或已过期时返回空图像
+ */
+const QImage loadCachedThumbnail(const QString &path, QSize *sourceSize)
+{
+    // 缩略图缓存目录下的文件不生成缩略图
+    if (path.startsWith(thumbnailCachePath())) {
+        return QImage();
+    }
+
+    QSize size;
+    QImage image = readCachedThumbnail(path, ThumbLarge, &size);
+    if (image.isNull()) {
+        image = readCachedThumbnail(path, ThumbNormal, &size);
+    }
+
+    if (!image.isNull() && sourceSize) {
+        if (!size.isValid() || size.isEmpty()) {
+            // 其它程序生成的缩略图可能未记录原始大小，读取文件头信息
+            size = QImageReader(path).size();
+        }
+        // 记录的及文件头中的大小均未应用方向，与解码后的图像保持一致
+        if (isOrientationTransposed(path)) {
+            size.transpose();
+        }
+        *sourceSize = size;
+    }
+
+    return image;
+}
+
+/**
+   @brief 将 \a path 的缩略图 \a image 写入 freedesktop 缩略图缓存，
+        写入 Thumb::URI 、 Thumb::MTime 等属性用于后续校验缩略图是否有效。
+   @param sourceSize 已应用方向的原始图像大小，按规范去除方向后记录为 Thumb::Image::Width/Height
+   @note 仅写入 large(256) 缩略图，缩略图层级(短边 128)仅能由 large 满足，normal(128) 不写入。
+        涉及文件读写，应在子线程中调用，使用 saveCachedThumbnailAsync() 异步写入
+ */
+bool saveCachedThumbnail(const QString &path, const QImage &image, const QSize &sourceSize)
+{
+    if (image.isNull() || !isThumbnailCacheable(path)) {
+        return false;
+    }
+
+    QSize recordSize = sourceSize;
+    if (isOrientationTransposed(path)) {
+        recordSize.transpose();
+    }
+
+    const QUrl url = QUrl::fromLocalFile(path);
+    const QString md5s = toMd5(url.toString(QUrl::FullyEncoded).toLocal8Bit());
+    const QString cacheP = thumbnailCachePath();
+
+    QFileInfo info(path);
+    QMap<QString, QString> attributes;
+    attributes.insert("Thumb::URI", url.toString(QUrl::FullyEncoded));
+    attributes.insert("Thumb::MTime", QString::number(info.lastModified().toSecsSinceEpoch()));
+    attributes.insert("Thumb::Size", QString::number(info.size()));
+    attributes.insert("Thumb::Image::Width", QString::number(recordSize.width()));
+    attributes.insert("Thumb::Image::Height", QString::number(recordSize.height()));
+    attributes.insert("Software", "Deepin Image Viewer");
+
+    QImage thumbnail = (image.width() > 256 || image.height() > 256)
+                               ? image.scaled(256, 256, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                               : image;
+    for (auto itr = attributes.constBegin(); itr != attributes.constEnd(); ++itr) {
+        thumbnail.setText(itr.key(), itr.value());
+    }
+    const bool ret = saveThumbnailFile(thumbnail, cacheP + "/large/" + md5s + ".png", 50);
+
+    qCDebug(logImageViewer) << "Saved cached thumbnail for:" << path << "result:" << ret;
+    return ret;
+}
+
+/**
+   @brief 异步将 \a path 已解码的图像 \a image 写入 freedesktop 缩略图缓存。
+   @param sourceSize 原始图像大小，\a image 已缩小时传入，无效时使用 \a image 的大小
+   @note 在调用线程中先缩放至 large 尺寸，后台任务仅持有较小的缩略图数据，避免缓存大量原图
+ */
+void saveCachedThumbnailAsync(const QString &path, const QImage &image, const QSize &sourceSize)
+{
+    if (image.isNull() || !isThumbnailCacheable(path)) {
+        return;
+    }
+
+    QImage thumbnail = (image.width() > 256 || image.height() > 256)
+                               ? image.scaled(256, 256, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                               : image;
+    const QSize recordSize = sourceSize.isValid() ? sourceSize : image.size();
+    QtConcurrent::run([path, thumbnail, recordSize]() { saveCachedThumbnail(path, thumbnail, recordSize); });
+}
+
 /*!
  * \brief generateThumbnail
  * Generate and save thumbnail for specific size
@@ -525,7 +705,7 @@ bool generateThumbnail(const QString &path)
         }
 
         qCWarning(logImageViewer) << "Failed to generate thumbnail, saving failure marker:" << failedP;
-        img.save(failedP, "png");
+        saveThumbnailFile(img, failedP, -1);
         return false;
     } else {
         qCDebug(logImageViewer) << "Thumbnails generated successfully, saving attributes.";
@@ -535,7 +715,7 @@ bool generateThumbnail(const QString &path)
         }
         const QString largeP = cacheP + "/large/" + md5 + ".png";
         const QString normalP = cacheP + "/normal/" + md5 + ".png";
-        if (lImg.save(largeP, "png", 50) && nImg.save(normalP, "png", 50)) {
+        if (saveThumbnailFile(lImg, largeP, 50) && saveThumbnailFile(nImg, normalP, 50)) {
             qCDebug(logImageViewer) << "Successfully generated thumbnails - large:" << largeP << "normal:" << normalP;
             return true;
         } else {
@@ -635,36 +815,11 @@ bool imageSupportWallPaper(const QString &path)
 {
     qCDebug(logImageViewer) << "Checking wallpaper support for:" << path;
     bool iRet = false;
-    QStringList listsupportWallPaper;
-    listsupportWallPaper << "bmp"
-                         //                         << "cod"
-                         << "png"
-                         << "gif"
-                         << "ief"
-                         << "jpe"
-                         << "jpeg"
-                         << "jpg"
-                         << "jfif"
-                         //                         << "svg"
-                         << "tif"
-                         << "tiff"
-            //                         << "ras"
-            //                         << "cmx"
-            //                         << "ico"
-            //                         << "pnm"
-            //                         << "pbm"
-            //                         << "pgm"
-            //                         << "ppm"
-            //                         << "rgb"
-            //                         << "xbm"
-            //                         << "xpm"
-            //                         << "xwd"
-            ;
-    //
     QImageReader reader(path);
     if (reader.imageCount() > 0) {
         // 2020/11/12 bug54279
-        if (listsupportWallPaper.contains(reader.format().toLower()) && listsupportWallPaper.contains(QFileInfo(path).suffix().toLower())) {
+        if (ImageFormatRegistry::hasCapability(QString::fromLatin1(reader.format()), ImageFormatRegistry::WallPaper)
+            && ImageFormatRegistry::hasCapability(QFileInfo(path).suffix(), ImageFormatRegistry::WallPaper)) {
             iRet = true;
             qCDebug(logImageViewer) << "Image format supported for wallpaper:" << reader.format();
         } else {
@@ -52,6 +52,11 @@ const QImage                        scaleImage(const QString &path,
                                                const QSize &size = QSize(384, 383));
 
 bool                                generateThumbnail(const QString &path);
+const QImage                        loadCachedThumbnail(const QString &path, QSize *sourceSize = nullptr);
+bool                                saveCachedThumbnail(const QString &path, const QImage &image,
+                                                        const QSize &sourceSize);
+void                                saveCachedThumbnailAsync(const QString &path, const QImage &image,
+                                                             const QSize &sourceSize = QSize());
 const QPixmap                       getThumbnail(const QString &path,
                                                  bool cacheOnly = false);
 void                                removeThumbnail(const QString &path);
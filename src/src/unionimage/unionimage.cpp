@@ -15,14 +15,15 @@
 #include <QPainter>
 #include <QSvgGenerator>
 #include <QImageReader>
-#include <QMimeDatabase>
-#include <QMimeType>
 #include <QtSvg/QSvgRenderer>
 #include <QDir>
 #include <QDebug>
 #include <QLoggingCategory>
 
 #include "unionimage/imageutils.h"
+#include "unionimage/imageformatregistry.h"
+#include "unionimage/imageframescanner.h"
+#include "utils/tracerecorder.h"
 
 #include <cstring>
 
@@ -41,94 +42,12 @@ public:
     UnionImage_Private()
     {
         qCDebug(logImageViewer) << "Initializing UnionImage_Private.";
-        /*
-         * 由于原设计方案采用多个key对应一个value的方案，在判断可读可写的过程中是通过value去找key因此造成了多种情况而在下方变量中未将key，写完整因此补全
-         * */
-        m_qtSupported << "BMP"
-                      << "JPG"
-                      << "JPEG"
-                      << "JPS"
-                      << "JPE"
-                      << "PNG"
-                      << "PBM"
-                      << "PGM"
-                      << "PPM"
-                      << "PNM"
-                      << "WBMP"
-                      << "WEBP"
-                      << "SVG"
-                      << "ICNS"
-                      << "GIF"
-                      << "MNG"
-                      << "TIF"
-                      << "TIFF"
-                      << "BMP"
-                      << "XPM"
-                      << "DNG"
-                      << "RAF"
-                      << "CR2"
-                      << "MEF"
-                      << "ORF"
-                      << "ICO"
-                      << "RAW"
-                      << "MRW"
-                      << "NEF"
-                      << "JP2"
-                      << "HEIF"
-                      << "HEIC"
-                      << "HEJ2"
-                      << "AVIF"
-                      << "TGA"
-                      << "PSD"
-                      << "PXM"
-                      << "PIC"
-                      << "PEF"
-                      << "XBM"
-                      << "ARW"
-                      << "HDR"
-                      << "J2K"
-                      << "ICNS"
-                      << "AVI"
-                      << "VIFF"
-                      << "IFF"
-                      << "JP2"
-                      << "WMF"
-                      << "CRW"
-                      << "X3F"
-                      << "EPS"
-                      << "SR2"
-                      << "AVIFS";
-        qCDebug(logImageViewer) << "Supported formats initialized. Count:" << m_qtSupported.size();
-        m_canSave << "BMP"
-                  << "JPG"
-                  << "JPEG"
-                  << "PNG"
-                  << "PGM"
-                  << "PPM"
-                  << "XPM"
-                  << "ICO"
-                  << "ICNS";
-        qCDebug(logImageViewer) << "Saveable formats initialized. Count:" << m_canSave.size();
-        /*<< "PGM" << "PBM"*/
-        m_qtrotate << "BMP"
-                   << "JPG"
-                   << "JPEG"
-                   << "PNG"
-                   << "PGM"
-                   << "PPM"
-                   << "XPM"
-                   << "ICO"
-                   << "ICNS";
-        qCDebug(logImageViewer) << "Rotatable formats initialized. Count:" << m_qtrotate.size();
     }
     ~UnionImage_Private()
     {
         qCDebug(logImageViewer) << "UnionImage_Private destroyed.";
     }
-    QStringList m_qtSupported;
     QHash<QString, int> m_movie_formats;
-    QStringList m_canSave;
-    QStringList m_qtrotate;
 };
 
 static UnionImage_Private union_image_private;
@@ -150,9 +69,8 @@ UNIONIMAGESHARED_EXPORT const QStringList unionImageSupportFormat()
     qCDebug(logImageViewer) << "Getting supported image formats.";
     static QStringList res;
     if (res.empty()) {
-        qCDebug(logImageViewer) << "Result list is empty, populating from m_qtSupported.";
-        QStringList list = union_image_private.m_qtSupported;
-        res.append(list);
+        qCDebug(logImageViewer) << "Result list is empty, populating from format registry.";
+        res = ImageFormatRegistry::formatNames(ImageFormatRegistry::Read);
     }
     qCDebug(logImageViewer) << "Returning" << res.size() << "supported formats.";
     return res;
@@ -161,7 +79,7 @@ UNIONIMAGESHARED_EXPORT const QStringList unionImageSupportFormat()
 UNIONIMAGESHARED_EXPORT const QStringList supportStaticFormat()
 {
     qCDebug(logImageViewer) << "Getting supported static image formats.";
-    return (union_image_private.m_qtSupported);
+    return unionImageSupportFormat();
 }
 
 UNIONIMAGESHARED_EXPORT const QStringList supportMovieFormat()
@@ -237,100 +155,33 @@ UNIONIMAGESHARED_EXPORT const QString getFileFormat(const QString &path)
 UNIONIMAGESHARED_EXPORT const QString getFileMimeType(const QString &path)
 {
     qCDebug(logImageViewer) << "Getting file MIME type for path:" << path;
-    QMimeDatabase mimeDB;
-    QMimeType mimeType = mimeDB.mimeTypeForFile(path);
-    QString mimeTypeName = mimeType.name();
-    qCDebug(logImageViewer) << "Detected MIME type name:" << mimeTypeName;
-
-    static QMap<QString, QString> mimeToFormat;
-    if (mimeToFormat.isEmpty()) {
-        qCDebug(logImageViewer) << "MIME to format map is empty, initializing.";
-        mimeToFormat["image/jpeg"] = "JPEG";
-        mimeToFormat["image/pjpeg"] = "JPEG";
-        mimeToFormat["image/jpg"] = "JPG";
-        mimeToFormat["image/x-jps"] = "JPS";
-        mimeToFormat["image/x-jpe"] = "JPE";
-        mimeToFormat["image/png"] = "PNG";
-        mimeToFormat["image/x-portable-bitmap"] = "PBM";
-        mimeToFormat["image/x-portable-graymap"] = "PGM";
-        mimeToFormat["image/x-portable-pixmap"] = "PPM";
-        mimeToFormat["image/x-portable-anymap"] = "PNM";
-        mimeToFormat["image/vnd.wap.wbmp"] = "WBMP";
-        mimeToFormat["image/webp"] = "WEBP";
-        mimeToFormat["image/svg+xml"] = "SVG";
-        mimeToFormat["application/x-icns"] = "ICNS";
-        mimeToFormat["image/x-icns"] = "ICNS";
-        mimeToFormat["image/gif"] = "GIF";
-        mimeToFormat["video/x-mng"] = "MNG";
-        mimeToFormat["image/tif"] = "TIF";
-        mimeToFormat["image/tiff"] = "TIFF";
-        mimeToFormat["image/bmp"] = "BMP";
-        mimeToFormat["image/x-ms-bmp"] = "BMP";
-        mimeToFormat["image/x-xpixmap"] = "XPM";
-        mimeToFormat["image/x-adobe-dng"] = "DNG";
-        mimeToFormat["image/x-fuji-raf"] = "RAF";
-        mimeToFormat["image/x-canon-cr2"] = "CR2";
-        mimeToFormat["image/x-mef"] = "MEF";
-        mimeToFormat["image/x-olympus-orf"] = "ORF";
-        mimeToFormat["image/x-icon"] = "ICO";
-        mimeToFormat["image/vnd.microsoft.icon"] = "ICO";
-        mimeToFormat["image/x-raw"] = "RAW";
-        mimeToFormat["image/x-minolta-mrw"] = "MRW";
-        mimeToFormat["image/x-nikon-nef"] = "NEF";
-        mimeToFormat["image/jp2"] = "JP2";
-        mimeToFormat["image/jpx"] = "JP2";
-        mimeToFormat["image/jpm"] = "JP2";
-        mimeToFormat["image/heif"] = "HEIF";
-        mimeToFormat["image/heic"] = "HEIC";
-        mimeToFormat["image/hej2"] = "HEJ2";
-        mimeToFormat["image/avif"] = "AVIF";
-        mimeToFormat["image/avifs"] = "AVIFS";
-        mimeToFormat["image/x-tga"] = "TGA";
-        mimeToFormat["image/vnd.adobe.photoshop"] = "PSD";
-        mimeToFormat["image/x-pxm"] = "PXM";
-        mimeToFormat["image/x-pic"] = "PIC";
-        mimeToFormat["image/x-pentax-pef"] = "PEF";
-        mimeToFormat["image/x-xbitmap"] = "XBM";
-        mimeToFormat["image/x-sony-arw"] = "ARW";
-        mimeToFormat["image/x-hdr"] = "HDR";
-        mimeToFormat["image/x-j2k"] = "J2K";
-        mimeToFormat["image/avi"] = "AVI";
-        mimeToFormat["video/avi"] = "AVI";
-        mimeToFormat["image/x-viff"] = "VIFF";
-        mimeToFormat["image/x-ilbm"] = "IFF";
-        mimeToFormat["image/x-windows-metafile"] = "WMF";
-        mimeToFormat["application/x-msmetafile"] = "WMF";
-        mimeToFormat["image/x-wmf"] = "WMF";
-        mimeToFormat["image/x-canon-crw"] = "CRW";
-        mimeToFormat["image/x-sigma-x3f"] = "X3F";
-        mimeToFormat["image/x-eps"] = "EPS";
-        mimeToFormat["image/x-sony-sr2"] = "SR2";
+    // 通过格式注册表识别文件后缀及文件头，不再查询 QMimeDatabase
+    const ImageFormatRegistry::Format *format = ImageFormatRegistry::detect(path);
+    if (format) {
+        qCDebug(logImageViewer) << "Detected file format:" << format->name;
+        return format->formatName();
     }
 
-    if (mimeToFormat.contains(mimeTypeName)) {
-        QString format = mimeToFormat[mimeTypeName];
-        qCDebug(logImageViewer) << "Mapped MIME type to format:" << format;
-        return format;
-    }
-
-    qCDebug(logImageViewer) << "MIME type not found in map, returning original MIME type name:" << mimeTypeName;
+    qCDebug(logImageViewer) << "File format not found in registry.";
     return QString();
 }
 
 UNIONIMAGESHARED_EXPORT bool canSave(const QString &path)
 {
     qCDebug(logImageViewer) << "Checking if image can be saved for path:" << path;
-    QImageReader r(path);
-    if (r.imageCount() > 1) {
-        qCDebug(logImageViewer) << "Image has multiple frames, cannot be saved directly.";
+    // 按图像总数判断，TIFF 中缩小分辨率的预览图不计入帧数，但旋转保存时仅写入单帧会将其丢弃
+    ImageFrameScanner::FrameInfo frames;
+    const int imageCount = ImageFrameScanner::scan(path, frames) ? frames.imageCount : QImageReader(path).imageCount();
+    if (imageCount > 1) {
+        qCDebug(logImageViewer) << "Image has multiple frames or reduced images, cannot be saved directly.";
         return false;
     }
-    QFileInfo info(path);
-    if (union_image_private.m_canSave.contains(info.suffix().toUpper())) {
-        qCDebug(logImageViewer) << "Image format " << info.suffix().toUpper() << " is in supported save list.";
+    const ImageFormatRegistry::Format *format = ImageFormatRegistry::findForPath(path);
+    if (format && format->has(ImageFormatRegistry::Save)) {
+        qCDebug(logImageViewer) << "Image format " << format->name << " is in supported save list.";
         return true;
     }
-    qCDebug(logImageViewer) << "Image format " << info.suffix().toUpper() << " is not in supported save list.";
+    qCDebug(logImageViewer) << "Image format is not in supported save list.";
     return false;
 }
 
@@ -348,6 +199,7 @@ UNIONIMAGESHARED_EXPORT QString unionImageVersion()
 UNIONIMAGESHARED_EXPORT bool loadStaticImageFromFile(const QString &path, QImage &res, QString &errorMsg, const QString &format_bar)
 {
     qCDebug(logImageViewer) << "Loading static image from file:" << path;
+    TraceSpan ioSpan("image", "io", path);
     QFileInfo file_info(path);
     if (file_info.size() == 0) {
         qCWarning(logImageViewer) << "Empty file:" << path;
@@ -358,13 +210,15 @@ UNIONIMAGESHARED_EXPORT bool loadStaticImageFromFile(const QString &path, QImage
     QMap<QString, QString> dataMap = getAllMetaData(path);
     QString file_suffix_upper = dataMap.value("FileFormat").toUpper();
     QString file_mimeType = dataMap.value("FileMimeType").toUpper();
+    ioSpan.finish();
     qCDebug(logImageViewer) << "Detected file suffix:" << file_suffix_upper << ", MIME type:" << file_mimeType;
 
     QByteArray temp_path;
     temp_path.append(path.toUtf8());
     QString file_suffix_lower = file_suffix_upper.toLower();
 
-    if (union_image_private.m_qtSupported.contains(file_suffix_upper) || union_image_private.m_qtSupported.contains(file_mimeType)) {
+    if (ImageFormatRegistry::hasCapability(file_suffix_upper, ImageFormatRegistry::Read)
+        || ImageFormatRegistry::hasCapability(file_mimeType, ImageFormatRegistry::Read)) {
         qCDebug(logImageViewer) << "File format or MIME type is supported by Qt.";
         QImageReader reader;
         QImage res_qt;
@@ -379,6 +233,7 @@ UNIONIMAGESHARED_EXPORT bool loadStaticImageFromFile(const QString &path, QImage
         reader.setAutoTransform(true);
         if (reader.imageCount() > 0 || file_suffix_upper != "ICNS") {
             qCDebug(logImageViewer) << "Image has frames or is not ICNS, attempting to read.";
+            TraceSpan decodeSpan("image", "decode", path);
             res_qt = reader.read();
             if (res_qt.isNull()) {
                 qCDebug(logImageViewer) << "Failed to read image with QImageReader, trying old method";
@@ -424,108 +279,11 @@ UNIONIMAGESHARED_EXPORT bool loadStaticImageFromFile(const QString &path, QImage
 UNIONIMAGESHARED_EXPORT QString detectImageFormat(const QString &path)
 {
     qCDebug(logImageViewer) << "Detecting image format for:" << path;
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qCWarning(logImageViewer) << "Failed to open file for format detection:" << path;
-        return "";
-    }
-
-    const QByteArray data = file.read(1024);
-    file.close();
-    qCDebug(logImageViewer) << "Read" << data.size() << "bytes for format detection.";
-
-    // Check bmp file.
-    if (data.startsWith("BM")) {
-        qCDebug(logImageViewer) << "Detected BMP format";
-        return "BMP";
-    }
-
-    // Check dds file.
-    if (data.startsWith("DDS")) {
-        qCDebug(logImageViewer) << "Detected DDS format";
-        return "DDS";
-    }
-
-    // Check gif file.
-    if (data.startsWith("GIF8")) {
-        qCDebug(logImageViewer) << "Detected GIF format";
-        return "GIF";
-    }
-
-    // Check Max OS icons file.
-    if (data.startsWith("icns")) {
-        qCDebug(logImageViewer) << "Detected ICNS format";
-        return "ICNS";
-    }
-
-    // Check jpeg file.
-    if (data.startsWith("\xff\xd8")) {
-        qCDebug(logImageViewer) << "Detected JPG format";
-        return "JPG";
-    }
-
-    // Check mng file.
-    if (data.startsWith("\x8a\x4d\x4e\x47\x0d\x0a\x1a\x0a")) {
-        qCDebug(logImageViewer) << "Detected MNG format";
-        return "MNG";
-    }
-
-    // Check net pbm file (BitMap).
-    if (data.startsWith("P1") || data.startsWith("P4")) {
-        qCDebug(logImageViewer) << "Detected PBM format";
-        return "PBM";
-    }
-
-    // Check pgm file (GrayMap).
-    if (data.startsWith("P2") || data.startsWith("P5")) {
-        qCDebug(logImageViewer) << "Detected PGM format";
-        return "PGM";
-    }
-
-    // Check ppm file (PixMap).
-    if (data.startsWith("P3") || data.startsWith("P6")) {
-        qCDebug(logImageViewer) << "Detected PPM format";
-        return "PPM";
-    }
-
-    // Check png file.
-    if (data.startsWith("\x89PNG\x0d\x0a\x1a\x0a")) {
-        qCDebug(logImageViewer) << "Detected PNG format";
-        return "PNG";
-    }
-
-    // Check svg file.
-    if (data.indexOf("<svg") > -1) {
-        qCDebug(logImageViewer) << "Detected SVG format";
-        return "SVG";
-    }
-
-    // TODO(xushaohua): tga file is not supported yet.
-
-    // Check tiff file.
-    if (data.startsWith("MM\x00\x2a") || data.startsWith("II\x2a\x00")) {
-        qCDebug(logImageViewer) << "Detected TIFF format";
-        return "TIFF";
-    }
-
-    // TODO(xushaohua): Support wbmp file.
-
-    // Check webp file.
-    if (data.startsWith("RIFFr\x00\x00\x00WEBPVP")) {
-        qCDebug(logImageViewer) << "Detected WEBP format";
-        return "WEBP";
-    }
-
-    // Check xbm file.
-    if (data.indexOf("#define max_width ") > -1 && data.indexOf("#define max_height ") > -1) {
-        qCDebug(logImageViewer) << "Detected XBM format";
-        return "XBM";
-    }
-
-    // Check xpm file.
-    if (data.startsWith("/* XPM */")) {
-        qCDebug(logImageViewer) << "Detected XPM format";
-        return "XPM";
+    // 优先使用文件头识别的格式，无法识别时使用文件后缀
+    const ImageFormatRegistry::Format *format = ImageFormatRegistry::formatForFamily(ImageFormatRegistry::sniffFile(path));
+    if (format) {
+        qCDebug(logImageViewer) << "Detected" << format->name << "format";
+        return format->formatName();
     }
 
     QFileInfo info(path);
@@ -653,7 +411,7 @@ UNIONIMAGESHARED_EXPORT bool rotateImageFile(int angel, const QString &path, QSt
         qCDebug(logImageViewer) << "Successfully rotated SVG file";
         return true;
 
-    } else if (union_image_private.m_qtrotate.contains(format)) {
+    } else if (ImageFormatRegistry::hasCapability(format, ImageFormatRegistry::Rotate)) {
         // 由于Qt内部不会去读图片的EXIF信息来判断当前的图像矩阵的真实位置，同时回写数据的时候会丢失全部的EXIF数据
         int orientation = getOrientation(path);
         QImage image_copy(path);
@@ -801,27 +559,38 @@ imageViewerSpace::ImageType getImageType(const QString &imagepath)
             return imageViewerSpace::ImageTypeBlank;
         }
 
-        QString strType = fi.suffix().toLower();
         // 解决bug57394 【专业版1031】【看图】【5.6.3.74】【修改引入】pic格式图片变为翻页状态，不为动图且首张显示序号为0
-        QMimeDatabase db;
-        QMimeType mt = db.mimeTypeForFile(imagepath, QMimeDatabase::MatchContent);
-        QMimeType mt1 = db.mimeTypeForFile(imagepath, QMimeDatabase::MatchExtension);
-        QString path1 = mt.name();
-        QString path2 = mt1.name();
-
-        QImageReader imgreader(imagepath);
-        int nSize = imgreader.imageCount();
-        //
-        if (strType == "svg" && QSvgRenderer().load(imagepath)) {
+        // 后缀及文件头均参与判断，通过格式注册表识别，不再查询 QMimeDatabase
+        const ImageFormatRegistry::Format *suffixFormat = ImageFormatRegistry::findForPath(imagepath);
+        const int suffixFamily = suffixFormat ? suffixFormat->family : ImageFormatRegistry::FamilyNone;
+        const int contentFamily = ImageFormatRegistry::sniffFile(imagepath);
+        auto isFamily = [&](int family) { return family == suffixFamily || family == contentFamily; };
+
+        // 仅可能为动图或多页图的格式需要读取帧数，未注册的格式由图片插件判断。
+        // 基于 TIFF 等容器的 RAW 格式以后缀为准，容器中的预览图不视为多页
+        const bool containerMatched = ImageFrameScanner::matchesSuffix(imagepath, contentFamily);
+        const bool suffixOnly = suffixFormat && ImageFormatRegistry::FamilyNone == suffixFamily;
+        const ImageFormatRegistry::Format *contentFormat = suffixOnly ? nullptr : ImageFormatRegistry::formatForFamily(contentFamily);
+        const bool maybeMultiFrame = (!suffixFormat && !contentFormat)
+                                     || (suffixFormat && (suffixFormat->caps & (ImageFormatRegistry::Animated | ImageFormatRegistry::MultiPage)))
+                                     || (contentFormat && (contentFormat->caps & (ImageFormatRegistry::Animated | ImageFormatRegistry::MultiPage)));
+        int nSize = 1;
+        if (maybeMultiFrame) {
+            // TIFF/GIF/WebP 仅读取文件结构统计帧数，避免 QImageReader 解码所有帧；后缀与内容不一致时由图片插件判断
+            ImageFrameScanner::FrameInfo frames;
+            if (containerMatched && ImageFrameScanner::scan(imagepath, contentFamily, frames)) {
+                nSize = frames.frameCount;
+            } else {
+                QImageReader imgreader(imagepath);
+                nSize = imgreader.imageCount();
+            }
+        }
+
+        if (ImageFormatRegistry::FamilySvg == suffixFamily && QSvgRenderer().load(imagepath)) {
             qCDebug(logImageViewer) << "Detected SVG image type";
             type = imageViewerSpace::ImageTypeSvg;
-        } else if ((strType == "mng")
-                   || ((strType == "gif") && nSize > 1)
-                   || (strType == "webp" && nSize > 1)
-                   || ((mt.name().startsWith("image/gif")) && nSize > 1)
-                   || ((mt1.name().startsWith("image/gif")) && nSize > 1)
-                   || ((mt.name().startsWith("video/x-mng")))
-                   || ((mt1.name().startsWith("video/x-mng")))) {
+        } else if (isFamily(ImageFormatRegistry::FamilyMng)
+                   || ((isFamily(ImageFormatRegistry::FamilyGif) || ImageFormatRegistry::FamilyWebp == suffixFamily) && nSize > 1)) {
             qCDebug(logImageViewer) << "Detected dynamic image type with" << nSize << "frames";
             type = imageViewerSpace::ImageTypeDynamic;
         } else if (nSize > 1) {
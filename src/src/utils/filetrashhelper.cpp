@@ -53,7 +53,18 @@ enum DeletionResult {
 FileTrashHelper::FileTrashHelper(QObject *parent)
     : QObject(parent)
 {
-    // DFM 设备管理接口，访问文件挂载信息
+}
+
+/*!
+   \return 返回 DFM 设备管理接口，访问文件挂载信息
+   \note 首次查询挂载信息时才创建 DBus 接口，避免拖慢启动
+ */
+QDBusInterface *FileTrashHelper::deviceManager()
+{
+    if (m_dfmDeviceManager) {
+        return m_dfmDeviceManager.data();
+    }
+
     if (DSysInfo::majorVersion() == "25") {
         m_dfmDeviceManager.reset(new QDBusInterface(QStringLiteral(V25_FILEMANAGER_DAEMON_SERVICE),
                                                     QStringLiteral(V25_FILEMANAGER_DAEMON_PATH),
@@ -68,6 +79,7 @@ FileTrashHelper::FileTrashHelper(QObject *parent)
                            << "service:" << m_dfmDeviceManager.data()->service()
                            << "interface:" << m_dfmDeviceManager.data()->interface()
                            << "path:" << m_dfmDeviceManager.data()->path();
+    return m_dfmDeviceManager.data();
 }
 
 /*!
@@ -169,7 +181,8 @@ void FileTrashHelper::queryMountInfo()
     initData = true;
 
     // 调用 DBus 接口查询可被卸载设备信息
-    QDBusReply<QStringList> deviceListReply = m_dfmDeviceManager->call("GetBlockDevicesIdList", kRemovable);
+    QDBusInterface *manager = deviceManager();
+    QDBusReply<QStringList> deviceListReply = manager->call("GetBlockDevicesIdList", kRemovable);
     if (!deviceListReply.isValid()) {
         qCWarning(logImageViewer) << "Failed to get block devices list:" << deviceListReply.error().message();
         return;
@@ -178,7 +191,7 @@ void FileTrashHelper::queryMountInfo()
     qCDebug(logImageViewer) << "Found" << deviceListReply.value().size() << "removable devices";
 
     for (const QString &id : deviceListReply.value()) {
-        QDBusReply<QVariantMap> deviceReply = m_dfmDeviceManager->call("QueryBlockDeviceInfo", id, false);
+        QDBusReply<QVariantMap> deviceReply = manager->call("QueryBlockDeviceInfo", id, false);
         if (!deviceReply.isValid()) {
             qCWarning(logImageViewer) << "Failed to query device info for" << id << ":" << deviceReply.error().message();
             continue;
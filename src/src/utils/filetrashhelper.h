@@ -25,6 +25,7 @@ public:
     Q_INVOKABLE void resetMountInfo();
 
 private:
+    QDBusInterface *deviceManager();
     void queryMountInfo();
     bool isExternalDevice(const QString &path);
     bool isGvfsFile(const QUrl &url) const;
@@ -32,7 +33,7 @@ private:
     int moveFileToTrashWithDBus(const QUrl &url);
 
 private:
-    QScopedPointer<QDBusInterface> m_dfmDeviceManager;
+    QScopedPointer<QDBusInterface> m_dfmDeviceManager;  // 延迟创建，通过 deviceManager() 访问
 
     bool initData { false };                    // 挂载数据是否被初始化
     QDir lastDir;                               // 上一次访问的文件目录
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "startuptrace.h"
+#include "tracerecorder.h"
+
+#include <QAtomicInt>
+#include <QQuickWindow>
+#include <QSharedPointer>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static QAtomicInt s_imageLoaded { 0 };  // 首张图片是否已加载完成
+static QAtomicInt s_imagePainted { 0 };
+
+/**
+   @class StartupTrace
+   @brief 启动耗时跟踪，各阶段耗时输出到日志，用于定位启动过程中的耗时操作
+   @note 首张图片在子线程加载完成后，下一次窗口帧交换即视为图片已绘制。
+        启用 TraceRecorder 时，各阶段同时记录为瞬时事件，并记录从 main() 到首张图片绘制的 startup 区间
+ */
+
+/**
+   @brief 开始计时，需在 main() 起始处调用
+ */
+void StartupTrace::start()
+{
+    TraceRecorder::startClock();
+}
+
+/**
+   @return 返回从 main() 起始的耗时(ms)
+   @threadsafe
+ */
+qint64 StartupTrace::elapsed()
+{
+    return TraceRecorder::timestamp() / 1000;
+}
+
+/**
+   @brief 记录启动阶段 \a stage 的完成时间
+ */
+void StartupTrace::mark(const char *stage)
+{
+    qCInfo(logImageViewer) << "Startup trace:" << stage << "at" << elapsed() << "ms";
+    if (TraceRecorder::isEnabled()) {
+        TraceRecorder::instance()->addInstant("startup", stage);
+    }
+}
+
+/**
+   @brief 图片加载完成，仅记录首张图片
+   @threadsafe
+ */
+void StartupTrace::imageLoaded()
+{
+    if (s_imageLoaded.testAndSetOrdered(0, 1)) {
+        mark("first image loaded");
+    }
+}
+
+/**
+   @brief 监听窗口 \a window 的帧交换，记录首帧及首张图片绘制完成的时间，之后断开连接
+ */
+void StartupTrace::watchWindow(QQuickWindow *window)
+{
+    if (!window) {
+        return;
+    }
+
+    // 帧交换信号在渲染线程发送，直接连接以记录准确的时间
+    auto connection = QSharedPointer<QMetaObject::Connection>::create();
+    auto firstFrame = QSharedPointer<QAtomicInt>::create(0);
+    *connection = QObject::connect(
+            window,
+            &QQuickWindow::frameSwapped,
+            window,
+            [connection, firstFrame]() {
+                if (firstFrame->testAndSetOrdered(0, 1)) {
+                    mark("first frame swapped");
+                }
+
+                if (s_imageLoaded.loadAcquire() && s_imagePainted.testAndSetOrdered(0, 1)) {
+                    mark("first image painted");
+                    if (TraceRecorder::isEnabled()) {
+                        TraceRecorder::instance()->addComplete("startup", "startup", 0, TraceRecorder::timestamp());
+                    }
+                    QObject::disconnect(*connection);
+                }
+            },
+            Qt::DirectConnection);
+}
@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QtGlobal>
+
+class QQuickWindow;
+
+// 启动耗时跟踪，记录从 main() 到首张图片绘制完成的各阶段耗时
+class StartupTrace
+{
+public:
+    static void start();
+    static qint64 elapsed();
+    static void mark(const char *stage);
+
+    static void imageLoaded();
+    static void watchWindow(QQuickWindow *window);
+};
+
+#endif  // STARTUPTRACE_H
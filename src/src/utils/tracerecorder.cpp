@@ -0,0 +1,203 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "tracerecorder.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(logImageViewer)
+
+static const char *const sc_TraceEnv = "DEEPIN_IMAGE_VIEWER_TRACE";
+static const int sc_MaxEvents = 1000000;   // 最多记录的事件数，避免长时间运行时内存持续增长
+
+static QElapsedTimer s_clock;
+static bool s_enabled = false;
+
+/**
+   @class TraceRecorder
+   @brief 记录带单调时间戳的命名区间，用于在实际设备上分析启动、图片加载及切换的耗时
+   @note 时间戳以 startClock() 调用时为零点，单位为微秒。事件在内存中累积，
+        退出时通过 save() 写入环境变量 DEEPIN_IMAGE_VIEWER_TRACE 指定的文件。
+ */
+
+TraceRecorder::TraceRecorder()
+    : outputPath(qEnvironmentVariable(sc_TraceEnv))
+{
+    qCInfo(logImageViewer) << "Trace enabled, output:" << outputPath;
+}
+
+TraceRecorder *TraceRecorder::instance()
+{
+    static TraceRecorder ins;
+    return &ins;
+}
+
+/**
+   @return 是否启用跟踪，需在 startClock() 之后调用
+   @threadsafe
+ */
+bool TraceRecorder::isEnabled()
+{
+    return s_enabled;
+}
+
+/**
+   @brief 启动跟踪时钟并读取环境变量，需在 main() 起始处、创建其它线程前调用
+   @note 解码辅助进程不调用此函数，即使继承了环境变量也不会记录
+ */
+void TraceRecorder::startClock()
+{
+    if (!s_clock.isValid()) {
+        s_clock.start();
+    }
+    s_enabled = !qEnvironmentVariableIsEmpty(sc_TraceEnv);
+}
+
+/**
+   @return 返回从启动跟踪时钟起的单调时间(微秒)
+   @threadsafe
+ */
+qint64 TraceRecorder::timestamp()
+{
+    return s_clock.isValid() ? s_clock.nsecsElapsed() / 1000 : 0;
+}
+
+/**
+   @brief 记录分类 \a category 下名称为 \a name 的区间 [ \a begin , \a end ] ， \a detail 为附加信息
+   @note \a category 和 \a name 需为字符串常量
+   @threadsafe
+ */
+void TraceRecorder::addComplete(const char *category, const char *name, qint64 begin, qint64 end, const QString &detail)
+{
+    QMutexLocker locker(&mutex);
+    if (events.size() >= sc_MaxEvents) {
+        overflowed = true;
+        return;
+    }
+    events.append({ category, name, 'X', currentThreadIndex(), begin, qMax<qint64>(0, end - begin), detail });
+}
+
+/**
+   @brief 记录分类 \a category 下名称为 \a name 的瞬时事件
+   @threadsafe
+ */
+void TraceRecorder::addInstant(const char *category, const char *name, const QString &detail)
+{
+    const qint64 now = timestamp();
+    QMutexLocker locker(&mutex);
+    if (events.size() >= sc_MaxEvents) {
+        overflowed = true;
+        return;
+    }
+    events.append({ category, name, 'i', currentThreadIndex(), now, 0, detail });
+}
+
+/**
+   @return 返回当前线程的序号，首次记录时保存线程名称，需持有锁调用
+ */
+int TraceRecorder::currentThreadIndex()
+{
+    static thread_local int index = -1;
+    if (index < 0) {
+        index = threadNames.size();
+        QThread *thread = QThread::currentThread();
+        QString name = thread ? thread->objectName() : QString();
+        if (thread && qApp && thread == qApp->thread()) {
+            name = QStringLiteral("main");
+        } else if (name.isEmpty()) {
+            name = QStringLiteral("thread %1").arg(index);
+        }
+        threadNames.append(name);
+    }
+    return index;
+}
+
+/**
+   @brief 将已记录的事件以 Chrome trace JSON 格式写入输出文件
+   @return 是否写入成功
+ */
+bool TraceRecorder::save()
+{
+    QMutexLocker locker(&mutex);
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (int i = 0; i < threadNames.size(); ++i) {
+        traceEvents.append(QJsonObject { { "ph", "M" },
+                                         { "name", "thread_name" },
+                                         { "pid", pid },
+                                         { "tid", i },
+                                         { "args", QJsonObject { { "name", threadNames.at(i) } } } });
+    }
+
+    for (const Event &event : events) {
+        QJsonObject object { { "ph", QString(QLatin1Char(event.phase)) },
+                             { "cat", QLatin1String(event.category) },
+                             { "name", QLatin1String(event.name) },
+                             { "pid", pid },
+                             { "tid", event.thread },
+                             { "ts", event.begin } };
+        if ('X' == event.phase) {
+            object.insert("dur", event.duration);
+        } else {
+            object.insert("s", "t");
+        }
+        if (!event.detail.isEmpty()) {
+            object.insert("args", QJsonObject { { "detail", event.detail } });
+        }
+        traceEvents.append(object);
+    }
+
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(logImageViewer) << "Failed to open trace file:" << outputPath << file.errorString();
+        return false;
+    }
+
+    const QJsonObject root { { "traceEvents", traceEvents }, { "displayTimeUnit", "ms" } };
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    qCInfo(logImageViewer) << "Trace saved:" << outputPath << "events:" << events.size() << "overflowed:" << overflowed;
+    return true;
+}
+
+/**
+   @class TraceSpan
+   @brief 作用域内的跟踪区间，构造时记录起始时间，析构或调用 finish() 时写入 TraceRecorder
+ */
+
+TraceSpan::TraceSpan(const char *category, const char *name, const QString &detail)
+    : category(category)
+    , name(name)
+    , detail(detail)
+{
+    if (TraceRecorder::isEnabled()) {
+        begin = TraceRecorder::timestamp();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    finish();
+}
+
+/**
+   @brief 提前结束区间，重复调用无效
+ */
+void TraceSpan::finish()
+{
+    if (begin < 0) {
+        return;
+    }
+
+    TraceRecorder::instance()->addComplete(category, name, begin, TraceRecorder::timestamp(), detail);
+    begin = -1;
+}
@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// 性能跟踪记录，设置环境变量 DEEPIN_IMAGE_VIEWER_TRACE 为输出文件路径时启用，
+// 退出时以 Chrome trace JSON 格式写入，可通过 chrome://tracing 或 Perfetto 查看
+class TraceRecorder
+{
+public:
+    static TraceRecorder *instance();
+    static bool isEnabled();
+    static void startClock();
+    static qint64 timestamp();
+
+    void addComplete(const char *category, const char *name, qint64 begin, qint64 end, const QString &detail = QString());
+    void addInstant(const char *category, const char *name, const QString &detail = QString());
+    bool save();
+
+private:
+    TraceRecorder();
+    int currentThreadIndex();
+
+    struct Event
+    {
+        const char *category;
+        const char *name;
+        char phase;      // 'X': 持续事件 'i': 瞬时事件
+        int thread;
+        qint64 begin;    // 微秒
+        qint64 duration;
+        QString detail;
+    };
+
+    QMutex mutex;
+    QVector<Event> events;
+    QVector<QString> threadNames;  // 以线程序号为索引
+    QString outputPath;
+    bool overflowed { false };
+
+    Q_DISABLE_COPY(TraceRecorder)
+};
+
+// 作用域内的跟踪区间，析构或调用 finish() 时记录，未启用跟踪时不记录时间
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *category, const char *name, const QString &detail = QString());
+    ~TraceSpan();
+
+    void finish();
+
+private:
+    const char *category;
+    const char *name;
+    QString detail;
+    qint64 begin { -1 };
+
+    Q_DISABLE_COPY(TraceSpan)
+};
+
+#endif  // TRACERECORDER_H
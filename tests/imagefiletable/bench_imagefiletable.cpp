@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagefiletable.h"
+
+#include <QtTest>
+
+static const int sc_OperationCount = 1000;   // 每轮测试在列表中间移除及插入的文件数
+
+/**
+   @brief ImageFileTable 在 1 万、 10 万及 100 万张图片时追加、移除、插入及按路径查找的耗时
+ */
+class BenchImageFileTable : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QString fileName(int index);
+    static void fillTable(ImageFileTable &table, int count);
+
+private Q_SLOTS:
+    void append_data();
+    void append();
+    void removeAt_data();
+    void removeAt();
+    void insert_data();
+    void insert();
+    void indexOf_data();
+    void indexOf();
+};
+
+QString BenchImageFileTable::fileName(int index)
+{
+    return QString("IMG_%1.jpg").arg(index, 7, 10, QChar('0'));
+}
+
+/**
+   @brief 向 \a table 追加 \a count 个文件，每 1000 个文件位于同一文件夹
+ */
+void BenchImageFileTable::fillTable(ImageFileTable &table, int count)
+{
+    table.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const quint32 dirId = table.addDirectory(QString("/home/user/Pictures/%1").arg(i / 1000));
+        table.append(dirId, fileName(i));
+    }
+}
+
+static void addCountRows()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void BenchImageFileTable::append_data()
+{
+    addCountRows();
+}
+
+void BenchImageFileTable::append()
+{
+    QFETCH(int, count);
+
+    QBENCHMARK {
+        ImageFileTable table;
+        fillTable(table, count);
+    }
+}
+
+void BenchImageFileTable::removeAt_data()
+{
+    addCountRows();
+}
+
+void BenchImageFileTable::removeAt()
+{
+    QFETCH(int, count);
+    ImageFileTable table;
+    fillTable(table, count);
+
+    // 每轮移除的文件整段插入补回，保持列表大小，耗时主要为逐个移除
+    const quint32 dirId = table.addDirectory("/home/user/Pictures/removed");
+    QStringList names;
+    for (int i = 0; i < sc_OperationCount; ++i) {
+        names.append(fileName(i));
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < sc_OperationCount; ++i) {
+            table.removeAt(count / 2);
+        }
+        table.insert(count / 2, dirId, names, 0, names.size());
+    }
+    QCOMPARE(table.size(), count);
+}
+
+void BenchImageFileTable::insert_data()
+{
+    addCountRows();
+}
+
+void BenchImageFileTable::insert()
+{
+    QFETCH(int, count);
+    ImageFileTable table;
+    fillTable(table, count);
+
+    const quint32 dirId = table.addDirectory("/home/user/Pictures/inserted");
+    QStringList names;
+    for (int i = 0; i < sc_OperationCount; ++i) {
+        names.append(fileName(i));
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < sc_OperationCount; ++i) {
+            table.insert(count / 2, dirId, names, i, i + 1);
+        }
+        for (int i = 0; i < sc_OperationCount; ++i) {
+            table.removeAt(count / 2);
+        }
+    }
+    QCOMPARE(table.size(), count);
+}
+
+void BenchImageFileTable::indexOf_data()
+{
+    addCountRows();
+}
+
+void BenchImageFileTable::indexOf()
+{
+    QFETCH(int, count);
+    ImageFileTable table;
+    fillTable(table, count);
+
+    QStringList paths;
+    for (int i = 0; i < sc_OperationCount; ++i) {
+        const int row = static_cast<int>((static_cast<qint64>(i) * count) / sc_OperationCount);
+        paths.append(table.filePath(row));
+    }
+
+    QBENCHMARK {
+        for (const QString &path : paths) {
+            QVERIFY(table.indexOf(path) >= 0);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchImageFileTable)
+
+#include "bench_imagefiletable.moc"
@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagepathtable.h"
+
+#include <QtTest>
+#include <QElapsedTimer>
+
+/**
+   @brief ImagePathTable 在 10 万及 100 万个路径时分配 ID 、按路径及 url 查询 ID 、按 ID 查询路径的耗时
+ */
+class BenchImagePathTable : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QStringList makePaths(const QString &prefix, int count);
+
+private Q_SLOTS:
+    void intern_data();
+    void intern();
+    void find_data();
+    void find();
+    void internUrl_data();
+    void internUrl();
+    void path_data();
+    void path();
+};
+
+QStringList BenchImagePathTable::makePaths(const QString &prefix, int count)
+{
+    QStringList paths;
+    paths.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        paths.append(QString("/home/user/Pictures/%1/IMG_%2.jpg").arg(prefix).arg(i, 7, 10, QChar('0')));
+    }
+    return paths;
+}
+
+static void addCountRows()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void BenchImagePathTable::intern_data()
+{
+    addCountRows();
+}
+
+/**
+   @brief 为未驻留的路径分配 ID ，驻留表不回收，仅首次分配可重复测量，因此手动计时
+ */
+void BenchImagePathTable::intern()
+{
+    QFETCH(int, count);
+    const QStringList paths = makePaths(QString("intern_%1").arg(count), count);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString &path : paths) {
+        ImagePathTable::intern(path);
+    }
+    QTest::setBenchmarkResult(timer.nsecsElapsed() / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+void BenchImagePathTable::find_data()
+{
+    addCountRows();
+}
+
+/**
+   @brief 查询已驻留路径的 ID ，与缓存按路径查询缩略图一致
+ */
+void BenchImagePathTable::find()
+{
+    QFETCH(int, count);
+    const QStringList paths = makePaths(QString("find_%1").arg(count), count);
+    for (const QString &path : paths) {
+        ImagePathTable::intern(path);
+    }
+
+    QBENCHMARK {
+        for (const QString &path : paths) {
+            ImagePathTable::find(path);
+        }
+    }
+}
+
+void BenchImagePathTable::internUrl_data()
+{
+    addCountRows();
+}
+
+/**
+   @brief 重复查询 url 字符串的 ID ，与图像加载器重复请求同一图像一致
+ */
+void BenchImagePathTable::internUrl()
+{
+    QFETCH(int, count);
+    QStringList urls;
+    urls.reserve(count);
+    for (const QString &path : makePaths(QString("url_%1").arg(count), count)) {
+        urls.append("file://" + path);
+        ImagePathTable::internUrl(urls.last());
+    }
+
+    QBENCHMARK {
+        for (const QString &url : urls) {
+            ImagePathTable::internUrl(url);
+        }
+    }
+}
+
+void BenchImagePathTable::path_data()
+{
+    addCountRows();
+}
+
+/**
+   @brief 按 ID 查询路径
+ */
+void BenchImagePathTable::path()
+{
+    QFETCH(int, count);
+    QVector<quint32> ids;
+    ids.reserve(count);
+    for (const QString &path : makePaths(QString("path_%1").arg(count), count)) {
+        ids.append(ImagePathTable::intern(path));
+    }
+
+    QBENCHMARK {
+        for (quint32 id : ids) {
+            ImagePathTable::path(id);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchImagePathTable)
+
+#include "bench_imagepathtable.moc"
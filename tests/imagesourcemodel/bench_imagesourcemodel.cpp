@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagesourcemodel.h"
+#include "types.h"
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(logImageViewer, "org.deepin.dde.imageviewer")
+
+static const int sc_OperationCount = 1000;   // 每轮测试删除或重命名的图片数
+
+/**
+   @brief ImageSourceModel 在 1 万、 10 万及 100 万张图片时删除及重命名图片的耗时，
+    与文件监控触发的删除、重命名流程一致
+ */
+class BenchImageSourceModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QString fileUrl(const QString &prefix, int index);
+    static void fillModel(ImageSourceModel &model, int count);
+
+private Q_SLOTS:
+    void initTestCase();
+    void removeImage_data();
+    void removeImage();
+    void renameImage_data();
+    void renameImage();
+};
+
+QString BenchImageSourceModel::fileUrl(const QString &prefix, int index)
+{
+    return QString("file:///home/user/Pictures/%1_%2.jpg").arg(prefix).arg(index, 7, 10, QChar('0'));
+}
+
+/**
+   @brief 以文件名顺序的 \a count 张图片重置 \a model
+ */
+void BenchImageSourceModel::fillModel(ImageSourceModel &model, int count)
+{
+    QStringList files;
+    files.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        files.append(fileUrl("IMG", i));
+    }
+    model.setImageFiles(files);
+}
+
+void BenchImageSourceModel::initTestCase()
+{
+    // 数据模型每次访问均输出调试日志，测试时关闭
+    QLoggingCategory::setFilterRules("org.deepin.dde.imageviewer.debug=false");
+}
+
+static void addCountRows()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void BenchImageSourceModel::removeImage_data()
+{
+    addCountRows();
+}
+
+/**
+   @brief 逐个删除列表中间的图片，仅统计删除的耗时，之后整段插入补回
+ */
+void BenchImageSourceModel::removeImage()
+{
+    QFETCH(int, count);
+    ImageSourceModel model;
+    fillModel(model, count);
+
+    QStringList removed;
+    for (int i = 0; i < sc_OperationCount; ++i) {
+        removed.append(fileUrl("IMG", count / 2 + i));
+    }
+
+    qint64 elapsed = 0;
+    int rounds = 0;
+    for (; rounds < 5; ++rounds) {
+        QElapsedTimer timer;
+        timer.start();
+        for (const QString &file : removed) {
+            model.removeImage(QUrl(file));
+        }
+        elapsed += timer.nsecsElapsed();
+
+        QCOMPARE(model.rowCount(), count - sc_OperationCount);
+        model.insertImageFiles(removed);
+        QCOMPARE(model.rowCount(), count);
+    }
+
+    // 结果为删除 sc_OperationCount 张图片的耗时
+    QTest::setBenchmarkResult(elapsed / rounds / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+void BenchImageSourceModel::renameImage_data()
+{
+    addCountRows();
+}
+
+/**
+   @brief 重命名列表中间的图片，新文件名排在列表首部，行移动至对应位置，每轮结束后重命名回原文件名
+ */
+void BenchImageSourceModel::renameImage()
+{
+    QFETCH(int, count);
+    ImageSourceModel model;
+    fillModel(model, count);
+
+    QBENCHMARK {
+        for (int i = 0; i < sc_OperationCount; ++i) {
+            const int row = model.indexForImagePath(QUrl(fileUrl("IMG", count / 2 + i)));
+            model.setData(model.index(row), QUrl(fileUrl("A", count / 2 + i)), Types::ImageUrlRole);
+        }
+        for (int i = 0; i < sc_OperationCount; ++i) {
+            const int row = model.indexForImagePath(QUrl(fileUrl("A", count / 2 + i)));
+            model.setData(model.index(row), QUrl(fileUrl("IMG", count / 2 + i)), Types::ImageUrlRole);
+        }
+    }
+
+    QCOMPARE(model.indexForImagePath(QUrl(fileUrl("IMG", count / 2))), count / 2);
+}
+
+QTEST_GUILESS_MAIN(BenchImageSourceModel)
+
+#include "bench_imagesourcemodel.moc"
@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagesubscribers.h"
+
+#include <QtTest>
+
+#include <memory>
+#include <vector>
+
+/**
+   @brief 模拟 ImageInfo 的订阅者，记录收到的通知次数
+ */
+class Subscriber : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Subscriber(const ImageKey &k)
+        : key(k)
+    {
+    }
+
+    void onLoadFinished() { ++hits; }
+
+    // 广播方式下，每个订阅者比较通知的 key 是否为自身的图片
+    Q_SLOT void onDataChanged(quint64 changedKey)
+    {
+        if (changedKey == key.toUInt64()) {
+            ++hits;
+        }
+    }
+
+    ImageKey key;
+    int hits = 0;
+};
+
+/**
+   @brief 广播方式的通知源，数据变更信号连接至全部订阅者
+ */
+class Broadcaster : public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_SIGNAL void dataChanged(quint64 key);
+};
+
+/**
+   @brief 存活订阅者数量(缩略图栏及视图中的 ImageInfo)不同时，逐个通知全部图片加载完成的耗时，
+    对比按 key 通知与信号广播后逐个比较 key 的方式
+ */
+class BenchImageSubscribers : public QObject
+{
+    Q_OBJECT
+
+private:
+    static std::vector<std::unique_ptr<Subscriber>> makeSubscribers(int count);
+
+private Q_SLOTS:
+    void notifyPerKey_data();
+    void notifyPerKey();
+    void notifyBroadcast_data();
+    void notifyBroadcast();
+};
+
+/**
+   @brief 创建 \a count 个订阅者，每 10 张图片中有 1 张同时被两个订阅者使用(缩略图栏及大图视图)
+ */
+std::vector<std::unique_ptr<Subscriber>> BenchImageSubscribers::makeSubscribers(int count)
+{
+    std::vector<std::unique_ptr<Subscriber>> subscribers;
+    for (int i = 0; i < count; ++i) {
+        subscribers.emplace_back(new Subscriber(ImageKey(static_cast<quint32>(i + 1), 0)));
+        if (0 == i % 10) {
+            subscribers.emplace_back(new Subscriber(ImageKey(static_cast<quint32>(i + 1), 0)));
+        }
+    }
+    return subscribers;
+}
+
+static void addCountRows()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("200") << 200;
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("5k") << 5000;
+}
+
+void BenchImageSubscribers::notifyPerKey_data()
+{
+    addCountRows();
+}
+
+void BenchImageSubscribers::notifyPerKey()
+{
+    QFETCH(int, count);
+    const std::vector<std::unique_ptr<Subscriber>> subscribers = makeSubscribers(count);
+    ImageSubscribers<Subscriber> table;
+    for (const std::unique_ptr<Subscriber> &subscriber : subscribers) {
+        table.subscribe(subscriber->key, subscriber.get());
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < count; ++i) {
+            table.notify(ImageKey(static_cast<quint32>(i + 1), 0), [](Subscriber *subscriber) { subscriber->onLoadFinished(); });
+        }
+    }
+    QVERIFY(subscribers.front()->hits > 0);
+}
+
+void BenchImageSubscribers::notifyBroadcast_data()
+{
+    addCountRows();
+}
+
+void BenchImageSubscribers::notifyBroadcast()
+{
+    QFETCH(int, count);
+    const std::vector<std::unique_ptr<Subscriber>> subscribers = makeSubscribers(count);
+    Broadcaster broadcaster;
+    for (const std::unique_ptr<Subscriber> &subscriber : subscribers) {
+        connect(&broadcaster, &Broadcaster::dataChanged, subscriber.get(), &Subscriber::onDataChanged);
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < count; ++i) {
+            Q_EMIT broadcaster.dataChanged(ImageKey(static_cast<quint32>(i + 1), 0).toUInt64());
+        }
+    }
+    QVERIFY(subscribers.front()->hits > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchImageSubscribers)
+
+#include "bench_imagesubscribers.moc"
@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "thumbnailcache.h"
+
+#include <QtTest>
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+static const int sc_ImageCount = 200;        // 缓存的缩略图数量，不超过默认容量
+static const int sc_LookupCount = 100000;    // 每个读取线程的查询次数
+
+/**
+   @brief ThumbnailCache 在多个读取线程下 find() 及 getOrInsert() 命中的耗时，
+    以及同时存在写入线程时的读取耗时，用于对比分片读取路径的扩展性
+ */
+class BenchThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QString imagePath(int index);
+    static void fillCache(ThumbnailCache &cache);
+    static void runThreads(int threadCount, const std::function<void(int)> &worker);
+
+private Q_SLOTS:
+    void find_data();
+    void find();
+    void getOrInsert_data();
+    void getOrInsert();
+    void findWithWriter_data();
+    void findWithWriter();
+};
+
+QString BenchThumbnailCache::imagePath(int index)
+{
+    return QString("/home/user/Pictures/IMG_%1.jpg").arg(index, 7, 10, QChar('0'));
+}
+
+/**
+   @brief 以 4:3 的默认层级缩略图填充 \a cache ，与短边 128px 的缩略图大小一致
+ */
+void BenchThumbnailCache::fillCache(ThumbnailCache &cache)
+{
+    QImage image(171, 128, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::gray);
+    for (int i = 0; i < sc_ImageCount; ++i) {
+        cache.add(imagePath(i), 0, image);
+    }
+}
+
+/**
+   @brief 启动 \a threadCount 个线程执行 \a worker ，参数为线程序号，等待全部线程结束
+ */
+void BenchThumbnailCache::runThreads(int threadCount, const std::function<void(int)> &worker)
+{
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(QThread::create(worker, i));
+        threads.back()->start();
+    }
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->wait();
+    }
+}
+
+static void addThreadRows()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("8 threads") << 8;
+}
+
+void BenchThumbnailCache::find_data()
+{
+    addThreadRows();
+}
+
+/**
+   @brief 各线程按路径 ID 查询缩略图，与缩略图栏滚动时的读取一致
+ */
+void BenchThumbnailCache::find()
+{
+    QFETCH(int, threads);
+    ThumbnailCache cache(true);
+    fillCache(cache);
+
+    std::vector<ThumbnailCache::Key> keys;
+    for (int i = 0; i < sc_ImageCount; ++i) {
+        keys.push_back(ThumbnailCache::toFindKey(imagePath(i)));
+    }
+
+    QBENCHMARK {
+        runThreads(threads, [&](int thread) {
+            QImage image;
+            for (int i = 0; i < sc_LookupCount; ++i) {
+                cache.find(keys[static_cast<size_t>((i + thread * 7) % sc_ImageCount)], image);
+            }
+        });
+    }
+}
+
+void BenchThumbnailCache::getOrInsert_data()
+{
+    addThreadRows();
+}
+
+/**
+   @brief 各线程按路径查询较小层级的缩略图，首次查询由默认层级缩放生成，之后均为命中
+ */
+void BenchThumbnailCache::getOrInsert()
+{
+    QFETCH(int, threads);
+    ThumbnailCache cache(true);
+    fillCache(cache);
+
+    QStringList paths;
+    for (int i = 0; i < sc_ImageCount / 2; ++i) {
+        paths.append(imagePath(i));
+    }
+
+    QBENCHMARK {
+        runThreads(threads, [&](int thread) {
+            for (int i = 0; i < sc_LookupCount; ++i) {
+                cache.getOrInsert(paths.at((i + thread * 7) % paths.size()), 0, ThumbnailCache::SmallTier, nullptr);
+            }
+        });
+    }
+}
+
+void BenchThumbnailCache::findWithWriter_data()
+{
+    addThreadRows();
+}
+
+/**
+   @brief 读取线程查询的同时，另一线程持续写入缩略图，写入会替换分片的索引快照
+ */
+void BenchThumbnailCache::findWithWriter()
+{
+    QFETCH(int, threads);
+    ThumbnailCache cache(true);
+    fillCache(cache);
+
+    std::vector<ThumbnailCache::Key> keys;
+    for (int i = 0; i < sc_ImageCount; ++i) {
+        keys.push_back(ThumbnailCache::toFindKey(imagePath(i)));
+    }
+
+    QImage image(128, 171, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QBENCHMARK {
+        QAtomicInt finished;
+        std::unique_ptr<QThread> writer(QThread::create([&]() {
+            for (int i = 0; !finished.loadAcquire(); ++i) {
+                cache.add(imagePath(sc_ImageCount + i % sc_ImageCount), 0, image);
+            }
+        }));
+        writer->start();
+
+        runThreads(threads, [&](int thread) {
+            QImage found;
+            for (int i = 0; i < sc_LookupCount; ++i) {
+                cache.find(keys[static_cast<size_t>((i + thread * 7) % sc_ImageCount)], found);
+            }
+        });
+
+        finished.storeRelease(1);
+        writer->wait();
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchThumbnailCache)
+
+#include "bench_thumbnailcache.moc"